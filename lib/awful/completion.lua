@@ -18,10 +18,16 @@ local table = table
 local math = math
 local print = print
 local pairs = pairs
+local ipairs = ipairs
+local type = type
 local string = string
 
 local gears_debug = require("gears.debug")
 local gstring = require("gears.string")
+local spawn = require("awful.spawn")
+local lgi = require("lgi")
+local Gio = lgi.Gio
+local GLib = lgi.GLib
 
 local completion = {}
 
@@ -36,22 +42,82 @@ local bashcomp_src = "@SYSCONFDIR@/bash_completion"
 -- @staticfct awful.completion.bashcomp_load
 function completion.bashcomp_load(src)
     if src then bashcomp_src = src end
-    local c, err = io.popen("/usr/bin/env bash -c 'source " .. bashcomp_src .. "; complete -p'")
-    if c then
-        while true do
-            local line = c:read("*line")
-            if not line then break end
-            -- if a bash function is used for completion, register it
-            if line:match(".* -F .*") then
-                bashcomp_funcs[line:gsub(".* (%S+)$","%1")] = line:gsub(".*-F +(%S+) .*$", "%1")
+    spawn.easy_async({"/usr/bin/env", "bash", "-c", "source " .. bashcomp_src .. "; complete -p"},
+        function(stdout, stderr)
+            for line in stdout:gmatch("[^\n]+") do
+                -- if a bash function is used for completion, register it
+                if line:match(".* -F .*") then
+                    bashcomp_funcs[line:gsub(".* (%S+)$","%1")] = line:gsub(".*-F +(%S+) .*$", "%1")
+                end
             end
+            if stderr ~= "" then
+                print(stderr)
+            end
+        end)
+end
+
+-- Cache of the shell completions.
+--
+-- The completions of a word only depend on the content of some directories:
+-- $PATH and the current directory for commands, the directory of the word for
+-- files. They are cached until one of these directories changes, which is
+-- noticed with a file monitor (inotify). Programmable bash completions have no
+-- such dependencies and are only kept while cycling through them.
+local completion_cache = {}
+local completion_cache_size = 0
+local completion_pending = {}
+local completion_monitors = {}
+
+local function completion_cache_clear()
+    for _, monitor in pairs(completion_monitors) do
+        monitor:cancel()
+    end
+    completion_cache = {}
+    completion_cache_size = 0
+    completion_monitors = {}
+end
+
+local function completion_cache_drop(key)
+    if completion_cache[key] then
+        completion_cache[key] = nil
+        completion_cache_size = completion_cache_size - 1
+    end
+end
+
+local function completion_cache_invalidate(dir)
+    for key, entry in pairs(completion_cache) do
+        if entry.dirs[dir] then
+            completion_cache_drop(key)
         end
-        c:close()
-    else
-        print(err)
     end
 end
 
+local function completion_cache_store(key, output, dirs)
+    -- Bound the number of entries and monitors.
+    if completion_cache_size >= 64 then
+        completion_cache_clear()
+    end
+
+    local dir_set = {}
+    for _, dir in ipairs(dirs) do
+        dir_set[dir] = true
+        if not completion_monitors[dir] then
+            local ok, monitor = pcall(function()
+                return Gio.File.new_for_path(dir):monitor_directory(Gio.FileMonitorFlags.NONE)
+            end)
+            if ok and monitor then
+                monitor.on_changed = function()
+                    completion_cache_invalidate(dir)
+                end
+                completion_monitors[dir] = monitor
+            end
+        end
+    end
+
+    completion_cache[key] = { output = output, dirs = dir_set }
+    completion_cache_size = completion_cache_size + 1
+end
+
 local function bash_escape(str)
     str = str:gsub(" ", "\\ ")
     str = str:gsub("%[", "\\[")
@@ -64,16 +130,28 @@ end
 completion.default_shell = nil
 
 --- Use shell completion system to complete commands and filenames.
+--
+-- The completions are cached until the directories they come from change. When
+-- a `callback` is given, a completion which is not cached yet is computed
+-- without blocking: the command is returned unchanged and the callback is
+-- called with the results later. `awful.prompt` gives one.
+--
 -- @tparam string command The command line.
 -- @tparam number cur_pos The cursor position.
 -- @tparam number ncomp The element number to complete.
 -- @tparam[opt=based on SHELL] string shell The shell to use for completion.
 --   Supports "bash" and "zsh".
+-- @tparam[opt] function callback Called with the new command, cursor position
+--   and matches once they are known. It can also be given instead of `shell`.
 -- @treturn string The new command.
 -- @treturn number The new cursor position.
 -- @treturn table The table with all matches.
 -- @staticfct awful.completion.shell
-function completion.shell(command, cur_pos, ncomp, shell)
+function completion.shell(command, cur_pos, ncomp, shell, callback)
+    if type(shell) == "function" then
+        shell, callback = nil, shell
+    end
+
     local wstart = 1
     local wend = 1
     local words = {}
@@ -154,37 +232,97 @@ function completion.shell(command, cur_pos, ncomp, shell)
                 .. string.format('%q', words[cword_index]) .. "'"
         end
     end
-    local c, err = io.popen(shell_cmd .. " | sort -u")
-    local output = {}
-    if c then
-        while true do
-            local line = c:read("*line")
-            if not line then break end
+
+    local function complete(output)
+        -- no completion, return
+        if #output == 0 then
+            return command, cur_pos
+        end
+
+        -- cycle
+        while ncomp > #output do
+            ncomp = ncomp - #output
+        end
+
+        local str = command:sub(1, cword_start - 1) .. output[ncomp] .. command:sub(cword_end)
+
+        return str, cword_start + #output[ncomp], output
+    end
+
+    local function parse(lines)
+        local output = {}
+        for line in lines do
             if gstring.startswith(line, "./") and gfs.is_dir(line) then
                 line = line .. "/"
             end
             table.insert(output, bash_escape(line))
         end
+        return output
+    end
 
-        c:close()
+    -- The directories the completions depend on.
+    local cwd = GLib.get_current_dir()
+    local key = table.concat({ shell_cmd, cwd, os.getenv("PATH") or "" }, "\0")
+    local dirs = {}
+    if bashcomp_funcs[words[1]] and shell ~= 'zsh' then
+        if ncomp == 1 then
+            completion_cache_drop(key)
+        end
+    elseif comptype == "command" then
+        for dir in (os.getenv("PATH") or ""):gmatch("[^:]+") do
+            table.insert(dirs, dir)
+        end
+        table.insert(dirs, cwd)
     else
-        print(err)
+        local dir = words[cword_index]:match("^(.*)/") or "."
+        dir = dir:gsub("^~", function() return GLib.get_home_dir() end)
+        if dir == "" then dir = "/" end
+        if not GLib.path_is_absolute(dir) then
+            dir = GLib.build_filenamev({ cwd, dir })
+        end
+        table.insert(dirs, dir)
     end
 
-    -- no completion, return
-    if #output == 0 then
-        return command, cur_pos
+    local cached = completion_cache[key]
+    if cached then
+        return complete(cached.output)
     end
 
-    -- cycle
-    while ncomp > #output do
-        ncomp = ncomp - #output
+    if not callback then
+        local c, err = io.popen(shell_cmd .. " | sort -u")
+        local output = {}
+        if c then
+            output = parse(c:lines())
+            c:close()
+            completion_cache_store(key, output, dirs)
+        else
+            print(err)
+        end
+        return complete(output)
     end
 
-    local str = command:sub(1, cword_start - 1) .. output[ncomp] .. command:sub(cword_end)
-    cur_pos = cword_start + #output[ncomp]
+    local function deliver(output)
+        callback(complete(output))
+    end
+
+    -- Only run the shell once for concurrent requests.
+    if completion_pending[key] then
+        table.insert(completion_pending[key], deliver)
+        return command, cur_pos
+    end
+
+    completion_pending[key] = { deliver }
+    spawn.easy_async({ "/bin/sh", "-c", shell_cmd .. " | sort -u" }, function(stdout)
+        local callbacks = completion_pending[key]
+        local output = parse(stdout:gmatch("[^\n]+"))
+        completion_pending[key] = nil
+        completion_cache_store(key, output, dirs)
+        for _, cb in ipairs(callbacks) do
+            cb(output)
+        end
+    end)
 
-    return str, cur_pos, output
+    return command, cur_pos
 end
 
 --- Run a generic completion.
@@ -39,6 +39,7 @@ local ret = {
     rules = require("awful.rules");
     popup = require("awful.popup");
     spawn = require("awful.spawn");
+    sampler = require("awful.sampler");
     screenshot = require("awful.screenshot");
 }
 
@@ -886,6 +886,20 @@ function keygrab.run(g)
     return g
 end
 
+-- The keyboard grab is acquired asynchronously, and may fail if another client
+-- holds it for too long. Nothing is getting the key events then.
+capi.awesome.connect_signal("keygrabber::grab_failed", function()
+    keygrabbing = false
+
+    if keygrab.current_instance then
+        keygrab.current_instance:stop()
+    end
+
+    for i = #grabbers, 1, -1 do
+        grabbers[i] = nil
+    end
+end)
+
 -- Implement the signal system for the keygrabber.
 
 local signals = {}
@@ -67,6 +67,16 @@ local default_layouts = setmetatable({}, {
 
 layout.suit = require("awful.layout.suit")
 
+--- Use the C implementations of the built-in layouts.
+--
+-- The tile, fair, spiral, magnifier and max layouts have native versions which
+-- compute the geometry of all clients in one pass and apply it directly. They
+-- produce the same geometries as the Lua versions. Layouts without a native
+-- version, including custom ones, always use their `arrange` function.
+--
+-- @field awful.layout.native
+layout.native = false
+
 --- The default list of layouts.
 --
 -- The default value is:
@@ -256,16 +266,25 @@ function layout.arrange(screen)
             local p = layout.parameters(nil, screen)
 
             local useless_gap = p.useless_gap
+            local l = layout.get(screen)
+
+            if layout.native and l.native_arrange and capi.awesome._layout_arrange then
+                -- This also removes the gaps and borders and resizes the clients
+                l.native_arrange(p)
+                return
+            end
 
             p.geometries = setmetatable({}, {__mode = "k"})
-            layout.get(screen).arrange(p)
+            l.arrange(p)
             for c, g in pairs(p.geometries) do
                 g.width = math.max(1, g.width - c.border_width * 2 - useless_gap * 2)
                 g.height = math.max(1, g.height - c.border_width * 2 - useless_gap * 2)
                 g.x = g.x + useless_gap
                 g.y = g.y + useless_gap
-                c:geometry(g)
             end
+
+            -- Move all clients before any of them emits its geometry signals
+            capi.client.batch_geometry(p.geometries)
         end)
         arrange_lock = false
         delayed_arrange[screen] = nil
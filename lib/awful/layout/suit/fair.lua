@@ -9,6 +9,7 @@
 -- Grab environment we need
 local ipairs = ipairs
 local math = math
+local capi = { awesome = awesome }
 
 --- The fairh layout layoutbox icon.
 -- @beautiful beautiful.layout_fairh
@@ -97,6 +98,10 @@ function fair.horizontal.arrange(p)
     return do_fair(p, "east")
 end
 
+function fair.horizontal.native_arrange(p)
+    capi.awesome._layout_arrange("fair", p, { orientation = "east" })
+end
+
 -- Vertical fair layout.
 -- @param screen The screen to arrange.
 fair.name = "fairv"
@@ -104,6 +109,10 @@ function fair.arrange(p)
     return do_fair(p, "south")
 end
 
+function fair.native_arrange(p)
+    capi.awesome._layout_arrange("fair", p, { orientation = "south" })
+end
+
 --- The fair layout.
 -- Try to give all clients the same size.
 -- @clientlayout awful.layout.suit.fair
@@ -11,6 +11,7 @@ local ipairs = ipairs
 local math = math
 local capi =
 {
+    awesome = awesome,
     client = client,
     screen = screen,
     mouse = mouse,
@@ -145,6 +146,19 @@ end
 -- @clientlayout awful.layout.suit.magnifier
 -- @usebeautiful beautiful.layout_magnifier
 
+function magnifier.native_arrange(p)
+    local focus = p.focus or capi.client.focus
+    local t = p.tag or capi.screen[p.screen].selected_tag
+
+    if focus and focus.screen ~= get_screen(p.screen) then focus = nil end
+    if focus and focus.floating then focus = nil end
+
+    capi.awesome._layout_arrange("magnifier", p, {
+        master_width_factor = t.master_width_factor,
+        focus               = focus,
+    })
+end
+
 magnifier.name = "magnifier"
 
 -- This layout handles the currently focused client specially and needs to be
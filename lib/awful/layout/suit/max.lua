@@ -8,6 +8,7 @@
 
 -- Grab environment we need
 local pairs = pairs
+local capi = { awesome = awesome }
 
 local max = {}
 
@@ -48,6 +49,9 @@ max.name = "max"
 function max.arrange(p)
     return fmax(p, false)
 end
+function max.native_arrange(p)
+    capi.awesome._layout_arrange("max", p, { fullscreen = false })
+end
 function max.skip_gap(nclients, t) -- luacheck: no unused args
     return true
 end
@@ -61,6 +65,9 @@ max.fullscreen.skip_gap = max.skip_gap
 function max.fullscreen.arrange(p)
     return fmax(p, true)
 end
+function max.fullscreen.native_arrange(p)
+    capi.awesome._layout_arrange("max", p, { fullscreen = true })
+end
 
 return max
 
@@ -11,6 +11,7 @@
 -- Grab environment we need
 local ipairs = ipairs
 local math = math
+local capi = { awesome = awesome }
 
 --- The spiral layout layoutbox icon.
 -- @beautiful beautiful.layout_spiral
@@ -77,6 +78,9 @@ spiral.dwindle.name = "dwindle"
 function spiral.dwindle.arrange(p)
     return do_spiral(p, false)
 end
+function spiral.dwindle.native_arrange(p)
+    capi.awesome._layout_arrange("spiral", p, { spiral = false })
+end
 
 --- Spiral layout.
 -- @clientlayout awful.layout.suit.spiral.name
@@ -85,6 +89,9 @@ spiral.name = "spiral"
 function spiral.arrange(p)
     return do_spiral(p, true)
 end
+function spiral.native_arrange(p)
+    capi.awesome._layout_arrange("spiral", p, { spiral = true })
+end
 
 return spiral
 
@@ -15,6 +15,7 @@ local ipairs = ipairs
 local math = math
 local capi =
 {
+    awesome = awesome,
     mouse = mouse,
     screen = screen,
     mousegrabber = mousegrabber
@@ -305,6 +306,25 @@ local function do_tile(param, orientation)
 
 end
 
+local function do_tile_native(param, orientation)
+    local t = param.tag or capi.screen[param.screen].selected_tag
+    local data = tag.getdata(t).windowfact
+
+    if not data then
+        data = {}
+        tag.getdata(t).windowfact = data
+    end
+
+    capi.awesome._layout_arrange("tile", param, {
+        orientation         = orientation,
+        master_count        = t.master_count,
+        master_width_factor = t.master_width_factor,
+        column_count        = t.column_count,
+        master_fill_policy  = t.master_fill_policy,
+        windowfact          = data,
+    })
+end
+
 function tile.skip_gap(nclients, t)
     return nclients == 1 and t.master_fill_policy == "expand"
 end
@@ -317,6 +337,9 @@ tile.right = {}
 tile.right.name = "tile"
 tile.right.arrange = do_tile
 tile.right.skip_gap = tile.skip_gap
+function tile.right.native_arrange(p)
+    return do_tile_native(p, "right")
+end
 function tile.right.mouse_resize_handler(c, corner, x, y)
     return mouse_resize_handler(c, corner, x, y)
 end
@@ -331,6 +354,9 @@ tile.left.skip_gap = tile.skip_gap
 function tile.left.arrange(p)
     return do_tile(p, "left")
 end
+function tile.left.native_arrange(p)
+    return do_tile_native(p, "left")
+end
 function tile.left.mouse_resize_handler(c, corner, x, y)
     return mouse_resize_handler(c, corner, x, y, "left")
 end
@@ -345,6 +371,9 @@ tile.bottom.skip_gap = tile.skip_gap
 function tile.bottom.arrange(p)
     return do_tile(p, "bottom")
 end
+function tile.bottom.native_arrange(p)
+    return do_tile_native(p, "bottom")
+end
 function tile.bottom.mouse_resize_handler(c, corner, x, y)
     return mouse_resize_handler(c, corner, x, y, "bottom")
 end
@@ -359,11 +388,15 @@ tile.top.skip_gap = tile.skip_gap
 function tile.top.arrange(p)
     return do_tile(p, "top")
 end
+function tile.top.native_arrange(p)
+    return do_tile_native(p, "top")
+end
 function tile.top.mouse_resize_handler(c, corner, x, y)
     return mouse_resize_handler(c, corner, x, y, "top")
 end
 
 tile.arrange = tile.right.arrange
+tile.native_arrange = tile.right.native_arrange
 tile.mouse_resize_handler = tile.right.mouse_resize_handler
 tile.name = tile.right.name
 
@@ -87,7 +87,8 @@ local capi =
 {
     screen = screen,
     mouse = mouse,
-    client = client
+    client = client,
+    awesome = awesome,
 }
 local floating = require("awful.layout.suit.floating")
 local a_screen = require("awful.screen")
@@ -988,13 +989,25 @@ function placement.no_overlap(c, args)
         end
         curlay = tags[1] and tags[1].layout
     end
-    local areas = { screen.workarea }
+    local obstacles = {}
     for _, cl in pairs(cls) do
         if cl ~= c
            and cl.type ~= "desktop"
            and (cl.floating or curlay == floating)
            and not (cl.maximized or cl.fullscreen) then
-            areas = grect.area_remove(areas, area_common(cl))
+            table.insert(obstacles, area_common(cl))
+        end
+    end
+
+    -- The native version only keeps the maximal free areas, the Lua one keeps
+    -- every fragment and slows down quadratically on busy screens.
+    local areas
+    if capi.awesome and capi.awesome._placement_free_areas then
+        areas = capi.awesome._placement_free_areas(screen.workarea, obstacles)
+    else
+        areas = { screen.workarea }
+        for _, obstacle in ipairs(obstacles) do
+            areas = grect.area_remove(areas, obstacle)
         end
     end
 
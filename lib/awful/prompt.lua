@@ -135,36 +135,44 @@ local data = {}
 data.history = {}
 
 local search_term = nil
-local function itera (inc,a, i)
-    i = i + inc
-    local v = a[i]
-    if v then return i,v end
-end
+
+-- The history file is an append-only log of the executed commands, oldest
+-- first. A command executed again is appended again, the history is made of
+-- the last occurrence of each command, limited to the `max` newest ones. The
+-- file is rewritten ("compacted") when it gets twice as long as needed and
+-- when a command is deleted.
 
 --- Load history file in history table
 -- @param id The data.history identifier which is the path to the filename.
 -- @param[opt] max The maximum number of entries in file.
 local function history_check_load(id, max)
     if id and id ~= "" and not data.history[id] then
-        data.history[id] = { max = 50, table = {} }
-
-        if max then
-            data.history[id].max = max
-        end
+        local history = { max = max or 1000, table = {}, set = {}, log_lines = 0 }
+        data.history[id] = history
 
         local f = io.open(id, "r")
         if not f then return end
 
-        -- Read history file
+        -- Read history file, keeping the last occurrence of each line
+        local lines, last = {}, {}
         for line in f:lines() do
-            if gtable.hasitem(data.history[id].table, line) == nil then
-                table.insert(data.history[id].table, line)
-                if #data.history[id].table >= data.history[id].max then
-                    break
-                end
-            end
+            table.insert(lines, line)
+            last[line] = #lines
         end
         f:close()
+        history.log_lines = #lines
+
+        local commands = {}
+        for i, line in ipairs(lines) do
+            if last[line] == i and line ~= "" then
+                table.insert(commands, line)
+            end
+        end
+
+        for i = math.max(1, #commands - history.max + 1), #commands do
+            table.insert(history.table, commands[i])
+            history.set[commands[i]] = true
+        end
     end
 end
 
@@ -205,19 +213,26 @@ local function cword_end(s, pos)
 end
 
 --- Save history table in history file
+--
+-- The file is replaced atomically.
+--
 -- @param id The data.history identifier
-local function history_save(id)
-    if data.history[id] then
+-- @param[opt=false] force Also save when the log is short enough
+local function history_save(id, force)
+    local history = data.history[id]
+    if history and (force or history.log_lines > 2 * history.max) then
         gfs.make_parent_directories(id)
-        local f = io.open(id, "w")
+        local f = io.open(id .. ".tmp", "w")
         if not f then
             gdebug.print_warning("Failed to write the history to "..id)
             return
         end
-        for i = 1, math.min(#data.history[id].table, data.history[id].max) do
-            f:write(data.history[id].table[i] .. "\n")
+        for i = 1, math.min(#history.table, history.max) do
+            f:write(history.table[i] .. "\n")
         end
-       f:close()
+        f:close()
+        os.rename(id .. ".tmp", id)
+        history.log_lines = math.min(#history.table, history.max)
     end
 end
 
@@ -236,24 +251,123 @@ end
 -- @param id The data.history identifier
 -- @param command The command to add
 local function history_add(id, command)
-    if data.history[id] and command ~= "" then
-        local index = gtable.hasitem(data.history[id].table, command)
-        if index == nil then
-            table.insert(data.history[id].table, command)
-
-            -- Do not exceed our max_cmd
-            if #data.history[id].table > data.history[id].max then
-                table.remove(data.history[id].table, 1)
+    local history = data.history[id]
+    if not history or command == "" then return end
+
+    local commands = history.table
+    if commands[#commands] == command then
+        return
+    elseif history.set[command] then
+        -- Bump this command to the end of history, it is usually recent
+        for i = #commands, 1, -1 do
+            if commands[i] == command then
+                table.remove(commands, i)
+                break
             end
+        end
+    end
 
-            history_save(id)
-        else
-            -- Bump this command to the end of history
-            table.remove(data.history[id].table, index)
-            table.insert(data.history[id].table, command)
-            history_save(id)
+    table.insert(commands, command)
+    history.set[command] = true
+    history.search_index = nil
+
+    -- Do not exceed our max_cmd
+    if #commands > history.max then
+        history.set[table.remove(commands, 1)] = nil
+    end
+
+    local f = io.open(id, "a")
+    if not f then
+        gfs.make_parent_directories(id)
+        f = io.open(id, "a")
+    end
+    if not f then
+        gdebug.print_warning("Failed to write the history to "..id)
+        return
+    end
+    f:write(command .. "\n")
+    f:close()
+    history.log_lines = history.log_lines + 1
+
+    history_save(id)
+end
+
+--- Remove an entry from the history file
+-- @param id The data.history identifier
+-- @param index The index of the entry
+local function history_remove(id, index)
+    local history = data.history[id]
+    history.set[table.remove(history.table, index)] = nil
+    history.search_index = nil
+    history_save(id, true)
+end
+
+--- Search the history.
+--
+-- The entries are indexed by their trigrams, so that only the entries
+-- containing all the trigrams of the search term are compared to it.
+--
+-- @param id The data.history identifier
+-- @tparam string term The text to search.
+-- @tparam number from Search the entries after (or before) this index.
+-- @tparam number direction 1 to search forward, -1 backward.
+-- @tparam boolean prefix Only match the entries starting with the term.
+-- @treturn number|nil The index of the found entry.
+-- @treturn string The entry.
+local function history_search(id, term, from, direction, prefix)
+    local history = data.history[id]
+    if not history then return end
+
+    local commands = history.table
+    local function matches(i)
+        local pos = commands[i]:find(term, 1, true)
+        return pos and (pos == 1 or not prefix)
+    end
+
+    if #term < 3 then
+        for i = from + direction, direction > 0 and #commands or 1, direction do
+            if matches(i) then return i, commands[i] end
+        end
+        return
+    end
+
+    if not history.search_index then
+        history.search_index = {}
+        for i, command in ipairs(commands) do
+            local seen = {}
+            for j = 1, #command - 2 do
+                local trigram = command:sub(j, j + 2)
+                if not seen[trigram] then
+                    seen[trigram] = true
+                    history.search_index[trigram] = history.search_index[trigram] or {}
+                    table.insert(history.search_index[trigram], i)
+                end
+            end
+        end
+    end
+
+    -- The entries having the rarest trigram of the term, in ascending order
+    local candidates
+    for j = 1, #term - 2 do
+        local list = history.search_index[term:sub(j, j + 2)]
+        if not list then return end
+        if not candidates or #list < #candidates then
+            candidates = list
         end
     end
+
+    -- Find the first candidate after `from` in the search direction
+    local low, high = 1, #candidates
+    while low <= high do
+        local mid = math.floor((low + high) / 2)
+        if candidates[mid] <= from then low = mid + 1 else high = mid - 1 end
+    end
+    local start = direction > 0 and low or low - 1
+
+    for k = start, direction > 0 and #candidates or 1, direction do
+        local i = candidates[k]
+        if i ~= from and matches(i) then return i, commands[i] end
+    end
 end
 
 
@@ -328,6 +442,9 @@ end
 -- @tparam string command_before_comp The current command.
 -- @tparam number cur_pos_before_comp The current cursor position.
 -- @tparam number ncomp The number of the currently completed element.
+-- @tparam function done To complete asynchronously, return the command and
+--  cursor position unchanged and call this later with the same three values.
+--  It does nothing once another key was pressed.
 -- @treturn string command
 -- @treturn number cur_pos
 -- @treturn number matches
@@ -413,8 +530,8 @@ end
 -- @tparam function args.completion_callback The callback function to call to get completion.
 -- @tparam[opt] string args.history_path File path where the history should be
 -- saved, set nil to disable history
--- @tparam[opt] function args.history_max Set the maximum entries in history
--- file, 50 by default
+-- @tparam[opt=1000] integer args.history_max Set the maximum entries in
+-- history file
 -- @tparam[opt] function args.done_callback The callback function to always call
 -- without arguments, regardless of whether the prompt was cancelled.
 -- @tparam[opt] function args.changed_callback The callback function to call
@@ -451,8 +568,8 @@ end
 --   [**DEPRECATED**]
 -- @tparam[opt] string history_path File path where the history should be
 -- saved, set nil to disable history [**DEPRECATED**]
--- @tparam[opt] number history_max Set the maximum entries in history
--- file, 50 by default [**DEPRECATED**]
+-- @tparam[opt=1000] number history_max Set the maximum entries in history
+-- file [**DEPRECATED**]
 -- @tparam[opt] function done_callback The callback function to always call
 -- without arguments, regardless of whether the prompt was cancelled.
 --  [**DEPRECATED**]
@@ -519,6 +636,8 @@ function prompt.run(args, textbox, exe_callback, completion_callback,
     local cur_pos = (selectall and 1) or text:wlen() + 1
     -- The completion element to use on completion request.
     local ncomp = 1
+    -- Incremented on every key press, to match asynchronous completions.
+    local completion_request = 0
 
     -- Build the hook map
     for _,v in ipairs(args.hooks or {}) do
@@ -571,6 +690,8 @@ function prompt.run(args, textbox, exe_callback, completion_callback,
             return
         end
 
+        completion_request = completion_request + 1
+
         -- Call the user specified callback. If it returns true as
         -- the first result then return from the function. Treat the
         -- second and third results as a new command and new prompt
@@ -703,23 +824,19 @@ function prompt.run(args, textbox, exe_callback, completion_callback,
                 cur_pos = #command + 1
             elseif key == "r" then
                 search_term = search_term or command:sub(1, cur_pos - 1)
-                for i,v in (function(a,i) return itera(-1,a,i) end), data.history[history_path].table, history_index do
-                    if v:find(search_term,1,true) ~= nil then
-                        command=v
-                        history_index=i
-                        cur_pos=#command+1
-                        break
-                    end
+                local i, v = history_search(history_path, search_term, history_index, -1, false)
+                if i then
+                    command=v
+                    history_index=i
+                    cur_pos=#command+1
                 end
             elseif key == "s" then
                 search_term = search_term or command:sub(1, cur_pos - 1)
-                for i,v in (function(a,i) return itera(1,a,i) end), data.history[history_path].table, history_index do
-                    if v:find(search_term,1,true) ~= nil then
-                        command=v
-                        history_index=i
-                        cur_pos=#command+1
-                        break
-                    end
+                local i, v = history_search(history_path, search_term, history_index, 1, false)
+                if i then
+                    command=v
+                    history_index=i
+                    cur_pos=#command+1
                 end
             elseif key == "f" then
                 if cur_pos <= #command then
@@ -745,21 +862,17 @@ function prompt.run(args, textbox, exe_callback, completion_callback,
                 cur_pos = 1
             elseif key == "Up" then
                 search_term = command:sub(1, cur_pos - 1) or ""
-                for i,v in (function(a,i) return itera(-1,a,i) end), data.history[history_path].table, history_index do
-                    if v:find(search_term,1,true) == 1 then
-                        command=v
-                        history_index=i
-                        break
-                    end
+                local i, v = history_search(history_path, search_term, history_index, -1, true)
+                if i then
+                    command=v
+                    history_index=i
                 end
             elseif key == "Down" then
                 search_term = command:sub(1, cur_pos - 1) or ""
-                for i,v in (function(a,i) return itera(1,a,i) end), data.history[history_path].table, history_index do
-                    if v:find(search_term,1,true) == 1 then
-                        command=v
-                        history_index=i
-                        break
-                    end
+                local i, v = history_search(history_path, search_term, history_index, 1, true)
+                if i then
+                    command=v
+                    history_index=i
                 end
             elseif key == "w" or key == "BackSpace" then
                 local wstart = 1
@@ -783,7 +896,7 @@ function prompt.run(args, textbox, exe_callback, completion_callback,
                 --  we are not dealing with a new command
                 --  the user has not edited an existing entry
                 if command == data.history[history_path].table[history_index] then
-                    table.remove(data.history[history_path].table, history_index)
+                    history_remove(history_path, history_index)
                     if history_index <= history_items(history_path) then
                         command = data.history[history_path].table[history_index]
                         cur_pos = #command + 2
@@ -833,7 +946,21 @@ function prompt.run(args, textbox, exe_callback, completion_callback,
                         cur_pos_before_comp = cur_pos
                     end
                     local matches
-                    command, cur_pos, matches = completion_callback(command_before_comp, cur_pos_before_comp, ncomp)
+                    local request = completion_request
+                    command, cur_pos, matches = completion_callback(command_before_comp, cur_pos_before_comp, ncomp,
+                        function(new_command, new_cur_pos, new_matches)
+                            -- Drop late completions when another key was pressed.
+                            if request ~= completion_request then return end
+                            command, cur_pos = new_command, new_cur_pos
+                            if new_matches and #new_matches == 1 and args.autoexec then
+                                exec(exe_callback)
+                                return
+                            end
+                            update()
+                            if changed_callback then
+                                changed_callback(command)
+                            end
+                        end)
                     ncomp = ncomp + 1
                     key = ""
                     -- execute if only one match found and autoexec flag set
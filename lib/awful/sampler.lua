@@ -0,0 +1,136 @@
+---------------------------------------------------------------------------
+--- Shared sampler of the system statistics.
+--
+-- The CPU, memory, network, battery and temperature statistics are read from
+-- `/proc` and `/sys` by Awesome itself, once per interval for all the
+-- consumers. Unlike `awful.widget.watch` running shell commands such as `free`
+-- or `acpi`, this never forks.
+--
+--    awful.sampler.connect(function(data)
+--        if data.cpu and data.cpu.usage then
+--            mycpu.value = data.cpu.usage
+--        end
+--    end)
+--
+-- The data table has the following keys, each being nil when the
+-- corresponding files cannot be read:
+--
+-- * `time`: The monotonic time of the sample, in seconds.
+-- * `cpu`: The `usage` of all CPUs in percent, and the usage of each core
+--   as the array part. The usages are nil on the first sample.
+-- * `memory`: Every `/proc/meminfo` field in KiB, such as `MemTotal`, and the
+--   `usage` in percent.
+-- * `network`: A table per interface, with `rx_bytes`, `tx_bytes` and the
+--   `rx_rate` and `tx_rate` in bytes per second.
+-- * `power`: A table per `/sys/class/power_supply` entry, with `type`,
+--   `status`, `capacity`, `online`, `energy_now` and `power_now`.
+-- * `thermal`: A table per thermal zone, with `type` and the `temperature`
+--   in degree Celsius.
+--
+-- @author Abigail Teague
+-- @copyright 2026 Abigail Teague
+-- @module awful.sampler
+---------------------------------------------------------------------------
+
+local capi = { awesome = awesome }
+local timer = require("gears.timer")
+local gtable = require("gears.table")
+local protected_call = require("gears.protected_call")
+
+local sampler = {}
+
+local consumers = {}
+local sample_timer = nil
+
+--- The interval between two samples, in seconds.
+--
+-- Use `set_interval` to change it.
+--
+-- @tfield[opt=2] number interval
+sampler.interval = 2
+
+--- The latest sample, or nil.
+-- @tfield table|nil data
+sampler.data = nil
+
+--- Take a sample now.
+--
+-- This is independent of the shared timer, but the rates are computed since
+-- the previous sample, whoever took it.
+--
+-- @treturn table|nil The statistics, or nil if sampling is not supported.
+-- @staticfct awful.sampler.read
+function sampler.read()
+    if capi.awesome and capi.awesome._sampler_read then
+        return capi.awesome._sampler_read()
+    end
+end
+
+local function update()
+    local data = sampler.read()
+    if not data then return end
+
+    sampler.data = data
+    -- Callbacks may disconnect themselves
+    for _, callback in ipairs(gtable.clone(consumers, false)) do
+        protected_call(callback, data)
+    end
+end
+
+--- Call a function with every sample.
+--
+-- The timer runs as long as there is at least one function connected. If a
+-- sample was already taken, the function is called with it right away.
+--
+-- @tparam function callback The function, called with the data table.
+-- @staticfct awful.sampler.connect
+function sampler.connect(callback)
+    table.insert(consumers, callback)
+
+    if not sample_timer then
+        sample_timer = timer {
+            timeout   = sampler.interval,
+            autostart = true,
+            callback  = update,
+        }
+        update()
+    elseif sampler.data then
+        protected_call(callback, sampler.data)
+    end
+end
+
+--- Stop calling a function.
+--
+-- The timer is stopped with the last function.
+--
+-- @tparam function callback The function given to `connect`.
+-- @staticfct awful.sampler.disconnect
+function sampler.disconnect(callback)
+    for k, v in ipairs(consumers) do
+        if v == callback then
+            table.remove(consumers, k)
+            break
+        end
+    end
+
+    if #consumers == 0 and sample_timer then
+        sample_timer:stop()
+        sample_timer = nil
+    end
+end
+
+--- Change the interval between two samples.
+-- @tparam number interval The interval in seconds.
+-- @staticfct awful.sampler.set_interval
+function sampler.set_interval(interval)
+    sampler.interval = interval
+
+    if sample_timer then
+        sample_timer.timeout = interval
+        sample_timer:again()
+    end
+end
+
+return sampler
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -307,6 +307,34 @@ local function hash_command(cmd, rules)
     return string.format('%x', math.ceil(GLib.String.hash(glibstr)))
 end
 
+--- The maximum number of bytes kept from each output of a command.
+--
+-- This applies to `with_line_callback`, `easy_async` and their variants. The
+-- rest of the output is read and thrown away. With `with_line_callback`, the
+-- limit applies to each line instead: longer lines are cut, and the rest of
+-- them is dropped. `nil` means no limit.
+--
+-- @tfield[opt=nil] integer|nil max_output_size
+spawn.max_output_size = nil
+
+-- Read a pipe from a child with the native reader.
+-- In line mode, `callback` gets each line, otherwise it gets all the output
+-- once. `done` is called after that.
+local function read_output(fd, lines, callback, done)
+    capi.awesome._spawn_read(fd, function(output, finished)
+        if lines then
+            for _, line in ipairs(output) do
+                protected_call(callback, line)
+            end
+        elseif finished then
+            protected_call(callback, output)
+        end
+        if finished then
+            protected_call(done)
+        end
+    end, lines, spawn.max_output_size)
+end
+
 spawn.snid_buffer = {}
 
 function spawn.on_snid_callback(c)
@@ -376,27 +404,8 @@ function spawn.with_shell(cmd)
     end
 end
 
---- Spawn a program and asynchronously capture its output line by line.
--- @tparam string|table cmd The command.
--- @tparam table callbacks Table containing callbacks that should be invoked on
---   various conditions.
--- @tparam[opt] function callbacks.stdout Function that is called with each
---   line of output on stdout, e.g. `stdout(line)`.
--- @tparam[opt] function callbacks.stderr Function that is called with each
---   line of output on stderr, e.g. `stderr(line)`.
--- @tparam[opt] function callbacks.output_done Function to call when no more
---   output is produced.
--- @tparam[opt] function callbacks.exit Function to call when the spawned
---   process exits. This function gets the exit reason and code as its
---   arguments.
---   The reason can be "exit" or "signal".
---   For "exit", the second argument is the exit code.
---   For "signal", the second argument is the signal causing process
---   termination.
--- @treturn[1] Integer the PID of the forked process.
--- @treturn[2] string Error message.
--- @staticfct awful.spawn.with_line_callback
-function spawn.with_line_callback(cmd, callbacks)
+-- Spawn a program and read its output, line by line or all at once.
+local function spawn_with_output(cmd, callbacks, lines)
     local stdout_callback, stderr_callback, done_callback, exit_callback =
         callbacks.stdout, callbacks.stderr, callbacks.output_done, callbacks.exit
     local have_stdout, have_stderr = stdout_callback ~= nil, stderr_callback ~= nil
@@ -417,18 +426,56 @@ function spawn.with_line_callback(cmd, callbacks)
             done_callback()
         end
     end
+    local function read(fd, callback)
+        if capi.awesome._spawn_read then
+            read_output(fd, lines, callback, step_done)
+        elseif lines then
+            spawn.read_lines(Gio.UnixInputStream.new(fd, true),
+                    callback, step_done, true)
+        else
+            local output = {}
+            spawn.read_lines(Gio.UnixInputStream.new(fd, true), function(line)
+                table.insert(output, line .. "\n")
+            end, function()
+                protected_call(callback, table.concat(output))
+                step_done()
+            end, true)
+        end
+    end
     if have_stdout then
-        spawn.read_lines(Gio.UnixInputStream.new(stdout, true),
-                stdout_callback, step_done, true)
+        read(stdout, stdout_callback)
     end
     if have_stderr then
-        spawn.read_lines(Gio.UnixInputStream.new(stderr, true),
-                stderr_callback, step_done, true)
+        read(stderr, stderr_callback)
     end
     assert(stdin == nil)
     return pid
 end
 
+--- Spawn a program and asynchronously capture its output line by line.
+-- @tparam string|table cmd The command.
+-- @tparam table callbacks Table containing callbacks that should be invoked on
+--   various conditions.
+-- @tparam[opt] function callbacks.stdout Function that is called with each
+--   line of output on stdout, e.g. `stdout(line)`.
+-- @tparam[opt] function callbacks.stderr Function that is called with each
+--   line of output on stderr, e.g. `stderr(line)`.
+-- @tparam[opt] function callbacks.output_done Function to call when no more
+--   output is produced.
+-- @tparam[opt] function callbacks.exit Function to call when the spawned
+--   process exits. This function gets the exit reason and code as its
+--   arguments.
+--   The reason can be "exit" or "signal".
+--   For "exit", the second argument is the exit code.
+--   For "signal", the second argument is the signal causing process
+--   termination.
+-- @treturn[1] Integer the PID of the forked process.
+-- @treturn[2] string Error message.
+-- @staticfct awful.spawn.with_line_callback
+function spawn.with_line_callback(cmd, callbacks)
+    return spawn_with_output(cmd, callbacks, true)
+end
+
 --- Asynchronously spawn a program and capture its output.
 -- (wraps `spawn.with_line_callback`).
 -- @tparam string|table cmd The command.
@@ -447,10 +494,10 @@ function spawn.easy_async(cmd, callback)
     local stderr = ''
     local exitcode, exitreason
     local function parse_stdout(str)
-        stdout = stdout .. str .. "\n"
+        stdout = str
     end
     local function parse_stderr(str)
-        stderr = stderr .. str .. "\n"
+        stderr = str
     end
     local function done_callback()
         return callback(stdout, stderr, exitreason, exitcode)
@@ -471,13 +518,13 @@ function spawn.easy_async(cmd, callback)
             return done_callback()
         end
     end
-    return spawn.with_line_callback(
+    return spawn_with_output(
         cmd, {
         stdout=parse_stdout,
         stderr=parse_stderr,
         exit=exit_callback,
         output_done=output_done_callback
-    })
+    }, false)
 end
 
 --- Call `spawn.easy_async` with a shell.
@@ -20,6 +20,7 @@ return
     textclock = require("awful.widget.textclock");
     keyboardlayout = require("awful.widget.keyboardlayout");
     watch = require("awful.widget.watch");
+    sampler = require("awful.widget.sampler");
     only_on_screen = require("awful.widget.only_on_screen");
     clienticon = require("awful.widget.clienticon");
     calendar_popup = require("awful.widget.calendar_popup");
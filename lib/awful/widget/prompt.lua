@@ -100,7 +100,7 @@ end
 --   for details.
 -- @tparam[opt=`gears.filesystem.get_cache_dir() .. '/history'`] string
 --   args.history_path File path where the history should be saved.
--- @tparam[opt=50] integer args.history_max Set the maximum entries in
+-- @tparam[opt=1000] integer args.history_max Set the maximum entries in
 --   history file.
 -- @tparam[opt] function args.done_callback
 --   The callback function to always call without arguments, regardless of
@@ -0,0 +1,70 @@
+---------------------------------------------------------------------------
+--- Display the system statistics of `awful.sampler`.
+--
+-- This is an alternative to `awful.widget.watch` for the usual CPU, memory,
+-- network and battery widgets. All the widgets share one timer and nothing is
+-- spawned to update them.
+--
+--    local battery = awful.widget.sampler(function(widget, data)
+--        local bat = data.power and data.power.BAT0
+--        widget:set_text(bat and (bat.capacity .. "% " .. bat.status) or "")
+--    end)
+--
+-- By default, the CPU and memory usage are shown.
+--
+-- @author Abigail Teague
+-- @copyright 2026 Abigail Teague
+-- @widgetmod awful.widget.sampler
+-- @supermodule wibox.widget.base
+---------------------------------------------------------------------------
+
+local setmetatable = setmetatable
+local textbox = require("wibox.widget.textbox")
+local asampler = require("awful.sampler")
+
+local sampler = { mt = {} }
+
+local function default_callback(widget, data)
+    local cpu = data.cpu and data.cpu.usage
+    local mem = data.memory and data.memory.usage
+
+    widget:set_text(string.format("CPU %s MEM %s",
+        cpu and string.format("%.0f%%", cpu) or "-",
+        mem and string.format("%.0f%%", mem) or "-"))
+end
+
+--- Create a widget updated with every sample.
+--
+-- @tparam[opt] function callback The function updating the widget.
+-- Defaults to showing the CPU and memory usage.
+-- @tparam wibox.widget callback.widget Base widget instance.
+-- @tparam table callback.data The statistics, see `awful.sampler`.
+--
+-- @tparam[opt=wibox.widget.textbox()] wibox.widget base_widget Base widget.
+--
+-- @return The widget.
+-- @return The function connected to `awful.sampler`, to give to
+--  `awful.sampler.disconnect` to stop the updates.
+-- @constructorfct awful.widget.sampler
+function sampler.new(callback, base_widget)
+    base_widget = base_widget or textbox()
+    callback = callback or default_callback
+
+    local function update(data)
+        callback(base_widget, data)
+    end
+
+    asampler.connect(update)
+
+    return base_widget, update
+end
+
+function sampler.mt.__call(_, ...)
+    return sampler.new(...)
+end
+
+--@DOC_object_COMMON@
+
+return setmetatable(sampler, sampler.mt)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
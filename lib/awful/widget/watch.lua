@@ -23,6 +23,9 @@
 --
 -- ![Example screenshot](../images/awful_widget_watch.png)
 --
+-- For the CPU, memory, network, battery and temperature statistics, prefer
+-- `awful.widget.sampler`, which reads them without spawning any process.
+--
 -- Here is the most basic usage:
 --
 -- @DOC_wibox_awidget_defaults_watch_EXAMPLE@
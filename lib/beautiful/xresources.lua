@@ -44,15 +44,35 @@ local fallback = {
   foreground  = '#bcbcbc',
 }
 
+local theme_keys = { 'background', 'foreground' }
+for i=0,15 do table.insert(theme_keys, "color"..i) end
+
+-- Get several resources, in one call when possible.
+local function get_values(keys)
+    if awesome.xrdb_get_values then
+        return awesome.xrdb_get_values("", keys)
+    end
+
+    local values = {}
+    for _, key in ipairs(keys) do
+        values[key] = awesome.xrdb_get_value("", key)
+    end
+    return values
+end
+
 --- Get current base colorscheme from xrdb.
+--
+-- The values are cached until the X resources change, which is signalled by
+-- the `xrdb::changed` signal of `awesome`. Calling this function again then
+-- gives the new colorscheme.
+--
 -- @treturn table Color table with keys 'background', 'foreground' and 'color0'..'color15'.
 -- @staticfct beautiful.xresources.get_current_theme
 function xresources.get_current_theme()
-    local keys = { 'background', 'foreground' }
-    for i=0,15 do table.insert(keys, "color"..i) end
+    local values = get_values(theme_keys)
     local colors = {}
-    for _, key in ipairs(keys) do
-        local color = awesome.xrdb_get_value("", key)
+    for _, key in ipairs(theme_keys) do
+        local color = values[key]
         if color then
             if color:find("rgb:") then
                 color = "#"..color:gsub("[a]?rgb:", ""):gsub("/", "")
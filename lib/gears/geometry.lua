@@ -298,6 +298,17 @@ function gears.geometry.rectangle.area_remove(areas, elem)
     return areas
 end
 
+-- Inside awesome, use the native versions of the hot functions. They accept and
+-- return the same values, without going through intermediate tables.
+local capi = { awesome = awesome }
+
+if capi.awesome and capi.awesome._rectangle_area_remove then
+    gears.geometry.rectangle.area_intersect_area  = capi.awesome._rectangle_intersect
+    gears.geometry.rectangle.get_intersection     = capi.awesome._rectangle_intersection
+    gears.geometry.rectangle.area_remove          = capi.awesome._rectangle_area_remove
+    gears.geometry.rectangle.get_closest_by_coord = capi.awesome._rectangle_closest_by_coord
+end
+
 return gears.geometry
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
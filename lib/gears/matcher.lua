@@ -215,6 +215,174 @@ function matcher:matches_rule(o, entry)
     return true
 end
 
+-- The fields used to index the rules. A rule is indexed on the first of these
+-- fields it matches with a literal string. All other rules are kept in a
+-- residual list and checked one by one.
+local indexed_fields = {"class", "instance", "role", "type"}
+
+local pattern_magic = "[%^%$%(%)%%%.%[%]%*%+%-%?]"
+
+-- Get the bucket a rule value belongs to.
+--
+-- `default_matcher` accepts `a == b` or `a:match(b)`. A string without magic
+-- characters is thus a substring search and `^literal$` an exact comparison.
+-- Everything else (patterns, functions, non-string values) can't be indexed.
+local function index_key(value)
+    if type(value) ~= "string" or value == "" then return nil end
+
+    if not value:find(pattern_magic) then return "plain", value end
+
+    local inner = value:match("^%^(.*)%$$")
+
+    if inner and inner ~= "" and not inner:find(pattern_magic) then
+        return "exact", inner
+    end
+end
+
+-- Find which field and key a rule entry can be indexed on, if any.
+local function rule_index_key(self, entry)
+    -- With `rule_any`, the entry can match without any of the `rule` fields.
+    if type(entry.rule) ~= "table" or entry.rule_any then return nil end
+
+    -- A property matcher accepts the whole rule as soon as it matches.
+    for field in pairs(entry.rule) do
+        if self._private.prop_matchers[field] then return nil end
+    end
+
+    for _, field in ipairs(indexed_fields) do
+        local kind, key = index_key(entry.rule[field])
+        if kind then return field, kind, key end
+    end
+end
+
+local function bucket_add(t, key, i)
+    t[key] = t[key] or {}
+    table.insert(t[key], i)
+end
+
+-- Build the index of a rule list.
+local function compile_rules(self, rules)
+    local index = {
+        entries  = {},
+        indexed  = {},
+        buckets  = {},
+        residual = {},
+    }
+
+    for i, entry in ipairs(rules) do
+        index.entries[i] = entry
+
+        local field, kind, key = rule_index_key(self, entry)
+
+        if field then
+            local bucket = index.buckets[field] or {
+                plain = {}, exact = {}, lengths = {}
+            }
+            index.buckets[field] = bucket
+
+            if kind == "plain" then
+                bucket_add(bucket.plain, key, i)
+                bucket.lengths[#key] = true
+            else
+                bucket_add(bucket.exact, key, i)
+
+                -- `a == b` is checked before the pattern.
+                bucket_add(bucket.exact, entry.rule[field], i)
+            end
+
+            index.indexed[i] = {entry.rule, field, entry.rule[field]}
+        else
+            table.insert(index.residual, i)
+        end
+    end
+
+    for _, bucket in pairs(index.buckets) do
+        local lengths = {}
+
+        for len in pairs(bucket.lengths) do
+            table.insert(lengths, len)
+        end
+
+        bucket.lengths = lengths
+    end
+
+    return index
+end
+
+-- Check that a rule list didn't change since it has been compiled.
+--
+-- Rules are usually changed using `append_rule` and `remove_rule`, but the
+-- lists are exposed and can be modified directly. This is only a handful of
+-- comparisons per rule, much cheaper than matching it.
+local function index_valid(self, index, rules)
+    local entries, count = index.entries, 0
+    local prop_matchers = self._private.prop_matchers
+
+    for i, entry in ipairs(rules) do
+        if entries[i] ~= entry then return false end
+
+        local check = index.indexed[i]
+
+        if check then
+            if entry.rule ~= check[1] or entry.rule_any
+              or check[1][check[2]] ~= check[3] then
+                return false
+            end
+
+            -- A property matcher field may have been added to the rule.
+            for field in pairs(check[1]) do
+                if prop_matchers[field] then return false end
+            end
+        end
+
+        count = i
+    end
+
+    return count == #entries
+end
+
+-- Drop all compiled indices. They will be rebuilt on the next match.
+local function invalidate_rules(self)
+    self._private.rule_index = setmetatable({}, {__mode = "k"})
+end
+
+-- Get the indices of the rules which may match an object, in order.
+local function rule_candidates(index, o)
+    local seen, ret = {}, {}
+
+    local function add(list)
+        for _, i in ipairs(list) do
+            if not seen[i] then
+                seen[i] = true
+                table.insert(ret, i)
+            end
+        end
+    end
+
+    for field, bucket in pairs(index.buckets) do
+        local value = o[field]
+
+        if type(value) == "string" then
+            if bucket.exact[value] then add(bucket.exact[value]) end
+
+            for _, len in ipairs(bucket.lengths) do
+                for start = 1, #value - len + 1 do
+                    local hits = bucket.plain[value:sub(start, start + len - 1)]
+                    if hits then add(hits) end
+                end
+            end
+        end
+    end
+
+    -- Nothing was indexed, the residual list is already in order.
+    if #ret == 0 then return index.residual end
+
+    add(index.residual)
+    table.sort(ret)
+
+    return ret
+end
+
 --- Get list of matching rules for an object.
 --
 -- If the `rules` argument is not provided, the rules added with
@@ -246,7 +414,16 @@ function matcher:matching_rules(o, rules)
         return result
     end
 
-    for _, entry in ipairs(rules) do
+    local index = self._private.rule_index[rules]
+
+    if not (index and index_valid(self, index, rules)) then
+        index = compile_rules(self, rules)
+        self._private.rule_index[rules] = index
+    end
+
+    for _, i in ipairs(rule_candidates(index, o)) do
+        local entry = index.entries[i]
+
         if self:matches_rule(o, entry) then
             table.insert(result, entry)
         end
@@ -306,6 +483,9 @@ function matcher:add_property_matcher(name, f)
 
     self._private.prop_matchers[name] = f
 
+    -- Rules using this property can no longer be indexed.
+    invalidate_rules(self)
+
     self:emit_signal("property_matcher::added", name, f)
 end
 
@@ -366,6 +546,7 @@ function matcher:add_matching_rules(name, rules, depends_on, precede)
     end
 
     self._matching_rules[name] = rules
+    invalidate_rules(self)
 
     self:emit_signal("matching_rules::added", rules)
 
@@ -524,6 +705,7 @@ function matcher:append_rule(source, rule)
         self:add_matching_rules(source, {}, {}, {})
     end
     table.insert(self._matching_rules[source], rule)
+    invalidate_rules(self)
     self:emit_signal("rule::appended", rule, source, self._matching_rules[source])
 end
 
@@ -549,6 +731,7 @@ function matcher:remove_rule(source, rule)
     for k, v in ipairs(self._matching_rules[source]) do
         if v == rule or v.id == rule then
             table.remove(self._matching_rules[source], k)
+            invalidate_rules(self)
             self:emit_signal("rule::removed", rule, source, self._matching_rules[source])
             return true
         end
@@ -570,6 +753,8 @@ local function new()
         rules = {}, prop_matchers = {}, prop_setters = {}
     })
 
+    invalidate_rules(ret)
+
     -- Contains the sources.
     -- The elements are ordered "first in, first executed". Thus, the higher the
     -- index, the higher the priority. Each entry is a table with a `name` and a
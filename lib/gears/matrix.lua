@@ -210,6 +210,28 @@ function matrix.from_cairo_matrix(mat)
     return matrix.create(mat.xx, mat.yx, mat.xy, mat.yy, mat.x0, mat.y0)
 end
 
+-- Inside awesome, use the native versions of the hot functions. The matrices
+-- are still plain tables, only the arithmetic is done in C.
+local capi = { awesome = awesome }
+
+if capi.awesome and capi.awesome._matrix_multiply then
+    local native_multiply  = capi.awesome._matrix_multiply
+    local native_invert    = capi.awesome._matrix_invert
+    local native_transform = capi.awesome._matrix_transform_rectangle
+
+    function matrix:multiply(other)
+        return matrix.create(native_multiply(self, other))
+    end
+
+    function matrix:invert()
+        return matrix.create(native_invert(self))
+    end
+
+    function matrix:transform_rectangle(x, y, width, height)
+        return native_transform(self, x, y, width, height)
+    end
+end
+
 matrix_mt.__index = matrix
 matrix_mt.__newindex = error
 matrix_mt.__eq = matrix.equals
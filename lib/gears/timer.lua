@@ -100,6 +100,10 @@ function timer:start()
     end
     local timeout_ms = gmath.round(self.data.timeout * 1000)
     self.data.source_id = glib.timeout_add(glib.PRIORITY_DEFAULT, timeout_ms, function()
+        -- Timer wakeups are part of `awesome --record` event logs
+        if capi.awesome._eventlog_mark then
+            capi.awesome._eventlog_mark("timer")
+        end
         protected_call(self.emit_signal, self, "timeout")
         return true
     end)
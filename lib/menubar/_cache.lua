@@ -0,0 +1,79 @@
+-- Lua tables kept in a file of the cache directory, for the indexes of the
+-- desktop entries and of the icon themes.
+--
+-- The file is a Lua chunk returning the table. It is loaded in an empty
+-- environment and dropped when its key does not match, the key describing
+-- everything the content depends on.
+--
+-- It is **NOT** a public API.
+
+local pairs = pairs
+local string = string
+local table = table
+local type = type
+
+local cache = {}
+
+local function serialize(value, buffer)
+    local value_type = type(value)
+    if value_type == "table" then
+        table.insert(buffer, "{")
+        for k, v in pairs(value) do
+            table.insert(buffer, "[")
+            serialize(k, buffer)
+            table.insert(buffer, "]=")
+            serialize(v, buffer)
+            table.insert(buffer, ",")
+        end
+        table.insert(buffer, "}")
+    elseif value_type == "string" then
+        table.insert(buffer, string.format("%q", value))
+    elseif value_type == "number" then
+        table.insert(buffer, string.format("%.17g", value))
+    elseif value_type == "boolean" then
+        table.insert(buffer, tostring(value))
+    else
+        table.insert(buffer, "nil")
+    end
+end
+
+--- Load a table.
+-- @tparam string path The file.
+-- @tparam string key The expected key.
+-- @treturn table|nil The table, or nil if it is missing, invalid or outdated.
+function cache.load(path, key)
+    local chunk = loadfile(path, "t", {})
+    if not chunk then return nil end
+
+    local ok, loaded = pcall(chunk)
+    if ok and type(loaded) == "table" and loaded.key == key and type(loaded.data) == "table" then
+        return loaded.data
+    end
+end
+
+--- Save a table.
+--
+-- The file is replaced atomically, a concurrent reader gets the old one.
+--
+-- @tparam string path The file.
+-- @tparam string key The key.
+-- @tparam table data The table, made of strings, numbers, booleans and tables.
+-- @treturn boolean Whether the table was saved.
+-- @treturn string The error message.
+function cache.save(path, key, data)
+    local buffer = { "return " }
+    serialize({ key = key, data = data }, buffer)
+
+    local tmp = path .. ".tmp"
+    local file, err = io.open(tmp, "w")
+    if not file then return false, err end
+
+    file:write(table.concat(buffer))
+    file:close()
+
+    return os.rename(tmp, path)
+end
+
+return cache
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,103 @@
+-- Search index over the names and command lines of menu entries.
+--
+-- query_to_pattern() makes a case-insensitive pattern without magic
+-- characters, so matching it is a plain substring search in the lower-cased
+-- strings. Every entry is listed under the trigrams of its name and command
+-- line, and only the entries listed under all the trigrams of the query can
+-- match it.
+--
+-- It is **NOT** a public API.
+
+local ipairs = ipairs
+local string = string
+local table = table
+
+local search = {}
+
+--- Build the index of a list of entries.
+-- @tparam table entries The entries, with a `name` and a `cmdline`.
+-- @treturn table The index.
+function search.new(entries)
+    local index = {
+        entries  = entries,
+        count    = #entries,
+        names    = {},
+        cmdlines = {},
+        trigrams = {},
+        previous = nil,
+    }
+
+    local trigrams = index.trigrams
+    for i, entry in ipairs(entries) do
+        local name, cmdline = string.lower(entry.name), string.lower(entry.cmdline)
+        local seen = {}
+        index.names[i] = name
+        index.cmdlines[i] = cmdline
+        for _, s in ipairs { name, cmdline } do
+            for j = 1, #s - 2 do
+                local trigram = string.sub(s, j, j + 2)
+                if not seen[trigram] then
+                    seen[trigram] = true
+                    local list = trigrams[trigram]
+                    if not list then
+                        list = {}
+                        trigrams[trigram] = list
+                    end
+                    table.insert(list, i)
+                end
+            end
+        end
+    end
+
+    return index
+end
+
+--- Find the entries of a category matching a query.
+-- @tparam table index The search index.
+-- @tparam string lower_query The lower-cased query.
+-- @tparam[opt] string category The category, nil for all the entries.
+-- @treturn table The indices of the matching entries, in ascending order.
+function search.find(index, lower_query, category)
+    local candidates = nil
+    local previous = index.previous
+
+    if previous and previous.category == category
+        and string.find(lower_query, previous.query, 1, true) then
+        -- The query was refined: whatever matches it matched the previous one.
+        candidates = previous.matches
+    elseif #lower_query >= 3 then
+        for j = 1, #lower_query - 2 do
+            local list = index.trigrams[string.sub(lower_query, j, j + 2)] or {}
+            if not candidates or #list < #candidates then
+                candidates = list
+            end
+        end
+    end
+
+    local matches = {}
+    local function check(i)
+        local entry = index.entries[i]
+        if (not category or entry.category == category)
+            and (string.find(index.names[i], lower_query, 1, true)
+                or string.find(index.cmdlines[i], lower_query, 1, true)) then
+            table.insert(matches, i)
+        end
+    end
+
+    if candidates then
+        for _, i in ipairs(candidates) do
+            check(i)
+        end
+    else
+        for i = 1, index.count do
+            check(i)
+        end
+    end
+
+    index.previous = { query = lower_query, category = category, matches = matches }
+    return matches
+end
+
+return search
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
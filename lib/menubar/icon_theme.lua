@@ -12,14 +12,18 @@
 
 local beautiful = require("beautiful")
 local gfs = require("gears.filesystem")
-local GLib = require("lgi").GLib
+local lgi = require("lgi")
+local GLib = lgi.GLib
+local Gio = lgi.Gio
 local index_theme = require("menubar.index_theme")
+local cache = require("menubar._cache")
 
 local ipairs = ipairs
 local setmetatable = setmetatable
 local string = string
 local table = table
 local math = math
+local pairs = pairs
 
 local get_pragmatic_base_directories = function()
     local dirs = {}
@@ -77,6 +81,180 @@ local icon_theme = { mt = {} }
 
 local index_theme_cache = {}
 
+--- Path of the icon directory index.
+--
+-- Set to `false` to keep the index in memory only.
+--
+-- @param[opt=gears.filesystem.get_cache_dir() .. "icon_theme_index"] string|boolean
+icon_theme.index_file = nil
+
+-- Directory index.
+--
+-- Instead of testing whether every candidate file exists, each directory of a
+-- theme is listed once and the lookups are answered from the listings. The
+-- listings are kept in a file of the cache directory with the modification
+-- time of their directory, and a directory is listed again only when its
+-- modification time changed. This is checked once per directory until
+-- `icon_theme.refresh` is called.
+local dir_index_key = "1"
+local dir_index = nil
+local dir_index_checked = {}
+local dir_index_dirty = false
+
+local mtime_query = Gio.FILE_ATTRIBUTE_TIME_MODIFIED .. "," .. Gio.FILE_ATTRIBUTE_TIME_MODIFIED_USEC
+
+local get_dir_index_file = function()
+    if icon_theme.index_file == nil then
+        return gfs.get_cache_dir() .. "icon_theme_index"
+    end
+    return icon_theme.index_file
+end
+
+local get_mtime = function(path)
+    local info = Gio.File.new_for_path(path):query_info(mtime_query, Gio.FileQueryInfoFlags.NONE)
+    if not info then
+        return false
+    end
+    return info:get_attribute_uint64(Gio.FILE_ATTRIBUTE_TIME_MODIFIED) * 1000000
+        + info:get_attribute_uint32(Gio.FILE_ATTRIBUTE_TIME_MODIFIED_USEC)
+end
+
+--- Get the names of the files of a directory.
+-- @tparam string path The directory.
+-- @treturn table The file names, empty if the directory does not exist.
+local list_directory = function(path)
+    if not dir_index then
+        local file = get_dir_index_file()
+        dir_index = file and cache.load(file, dir_index_key) or {}
+    end
+
+    local entry = dir_index[path]
+    if entry and dir_index_checked[path] then
+        return entry.files
+    end
+    dir_index_checked[path] = true
+
+    local mtime = get_mtime(path)
+    if entry and entry.mtime == mtime then
+        return entry.files
+    end
+
+    local files = {}
+    local dir = mtime and GLib.Dir.open(path, 0)
+    if dir then
+        local name = dir:read_name()
+        while name do
+            table.insert(files, name)
+            name = dir:read_name()
+        end
+        dir:close()
+    end
+
+    dir_index[path] = { mtime = mtime, files = files }
+    dir_index_dirty = true
+
+    return files
+end
+
+local save_dir_index = function()
+    local file = get_dir_index_file()
+    if dir_index_dirty and file then
+        dir_index_dirty = false
+        cache.save(file, dir_index_key, dir_index)
+    end
+end
+
+-- Icons of a theme: icon name to the files in the order of the lookup, first
+-- by subdirectory, then by base directory, then by extension.
+local theme_icons_cache = {}
+
+local get_theme_icons = function(self)
+    local key = self.icon_theme_name .. "\0" .. table.concat(self.base_directories, ":")
+    if theme_icons_cache[key] then
+        return theme_icons_cache[key]
+    end
+
+    local extensions = {}
+    for i, ext in ipairs(self.extensions) do
+        extensions[ext] = i
+    end
+
+    local icons = {}
+    local base_count, ext_count = #self.base_directories, #self.extensions
+    for subdir_index, subdir in ipairs(self.index_theme:get_subdirectories()) do
+        for base_index, basedir in ipairs(self.base_directories) do
+            local path = string.format("%s/%s/%s", basedir, self.icon_theme_name, subdir)
+            for _, name in ipairs(list_directory(path)) do
+                local icon_name, ext = name:match("^(.+)%.([^.]+)$")
+                if extensions[ext] then
+                    icons[icon_name] = icons[icon_name] or {}
+                    table.insert(icons[icon_name], {
+                        subdir       = subdir,
+                        subdir_index = subdir_index,
+                        order        = ((subdir_index - 1) * base_count + base_index - 1) * ext_count
+                                       + extensions[ext],
+                        path         = path .. "/" .. name,
+                    })
+                end
+            end
+        end
+    end
+
+    for _, files in pairs(icons) do
+        table.sort(files, function(a, b) return a.order < b.order end)
+    end
+
+    save_dir_index()
+    theme_icons_cache[key] = icons
+
+    return icons
+end
+
+-- Icons directly in the base directories, for the fallback lookup.
+local fallback_icons_cache = {}
+
+local get_fallback_icons = function(self)
+    local key = table.concat(self.base_directories, ":")
+    if fallback_icons_cache[key] then
+        return fallback_icons_cache[key]
+    end
+
+    local extensions = {}
+    for i, ext in ipairs(self.extensions) do
+        extensions[ext] = i
+    end
+
+    local icons, orders = {}, {}
+    for base_index, dir in ipairs(self.base_directories) do
+        for _, name in ipairs(list_directory(dir)) do
+            local icon_name, ext = name:match("^(.+)%.([^.]+)$")
+            local order = extensions[ext] and base_index * (#self.extensions + 1) + extensions[ext]
+            if order and (not orders[icon_name] or order < orders[icon_name]) then
+                icons[icon_name] = dir .. "/" .. name
+                orders[icon_name] = order
+            end
+        end
+    end
+
+    save_dir_index()
+    fallback_icons_cache[key] = icons
+
+    return icons
+end
+
+--- Look for new and removed icons on the next lookups.
+--
+-- The directories are listed again if they changed. This is called by
+-- `menubar.menu_gen.generate`.
+--
+-- @staticfct menubar.icon_theme.refresh
+-- @noreturn
+icon_theme.refresh = function()
+    dir_index_checked = {}
+    theme_icons_cache = {}
+    fallback_icons_cache = {}
+end
+
 --- Class constructor of `icon_theme`
 -- @deprecated menubar.icon_theme.new
 -- @tparam string icon_theme_name Internal name of icon theme
@@ -146,41 +324,31 @@ local directory_size_distance = function(self, subdirectory, icon_size)
 end
 
 local lookup_icon = function(self, icon_name, icon_size)
-    local checked_already = {}
-    for _, subdir in ipairs(self.index_theme:get_subdirectories()) do
-        for _, basedir in ipairs(self.base_directories) do
-            for _, ext in ipairs(self.extensions) do
-                if directory_matches_size(self, subdir, icon_size) then
-                    local filename = string.format("%s/%s/%s/%s.%s",
-                                                   basedir, self.icon_theme_name, subdir,
-                                                   icon_name, ext)
-                    if gfs.file_readable(filename) then
-                        return filename
-                    else
-                        checked_already[filename] = true
-                    end
-                end
-            end
+    local files = get_theme_icons(self)[icon_name]
+    if not files then
+        return nil
+    end
+
+    for _, file in ipairs(files) do
+        if directory_matches_size(self, file.subdir, icon_size) then
+            return file.path
         end
     end
 
+    -- As no subdirectory matches the size, take the closest. Of the files in
+    -- the same subdirectory, the last one is used.
     local minimal_size = 0xffffffff -- Any large number will do.
     local closest_filename = nil
-    for _, subdir in ipairs(self.index_theme:get_subdirectories()) do
-        local dist = directory_size_distance(self, subdir, icon_size)
-        if dist < minimal_size then
-            for _, basedir in ipairs(self.base_directories) do
-                for _, ext in ipairs(self.extensions) do
-                    local filename = string.format("%s/%s/%s/%s.%s",
-                                                   basedir, self.icon_theme_name, subdir,
-                                                   icon_name, ext)
-                    if not checked_already[filename] then
-                        if gfs.file_readable(filename) then
-                            closest_filename = filename
-                            minimal_size = dist
-                        end
-                    end
-                end
+    local closest_subdir = nil
+    for _, file in ipairs(files) do
+        if file.subdir_index == closest_subdir then
+            closest_filename = file.path
+        else
+            local dist = directory_size_distance(self, file.subdir, icon_size)
+            if dist < minimal_size then
+                closest_filename = file.path
+                closest_subdir = file.subdir_index
+                minimal_size = dist
             end
         end
     end
@@ -206,17 +374,7 @@ find_icon_path_helper = function(self, icon_name, icon_size)
 end
 
 local lookup_fallback_icon = function(self, icon_name)
-    for _, dir in ipairs(self.base_directories) do
-        for _, ext in ipairs(self.extensions) do
-            local filename = string.format("%s/%s.%s",
-                                           dir,
-                                           icon_name, ext)
-            if gfs.file_readable(filename) then
-                return filename
-            end
-        end
-    end
-    return nil
+    return get_fallback_icons(self)[icon_name]
 end
 
 ---  Look up an image file based on a given icon name and/or a preferable size.
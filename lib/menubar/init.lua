@@ -38,6 +38,7 @@ local common = require("awful.widget.common")
 local theme = require("beautiful")
 local wibox = require("wibox")
 local gcolor = require("gears.color")
+local search = require("menubar._search")
 local gstring = require("gears.string")
 local gdebug = require("gears.debug")
 
@@ -271,13 +272,31 @@ local function get_current_page(all_items, query, scr)
     return current_page
 end
 
+-- Search index over the names and command lines of menu_entries, rebuilt when
+-- the entries are generated again.
+local search_index = nil
+
+local function get_search_index()
+    local entries = menubar.menu_entries
+    if not (search_index and search_index.entries == entries
+        and search_index.count == #entries) then
+        search_index = search.new(entries)
+    end
+    return search_index
+end
+
 --- Update the menubar according to the command entered by user.
 -- @tparam number|screen scr Screen
 local function menulist_update(scr)
     local query = instance.query or ""
-    shownitems = {}
+    local lower_query = string.lower(query)
     local pattern = gstring.query_to_pattern(query)
 
+    for _, v in ipairs(shownitems or {}) do
+        v.focused = false
+    end
+    shownitems = {}
+
     -- All entries are added to a list that will be sorted
     -- according to the priority (first) and weight (second) of its
     -- entries.
@@ -325,42 +344,33 @@ local function menulist_update(scr)
     end
 
     -- Add the applications according to their name and cmdline
-    local add_entry = function(entry)
-        entry.focused = false
-        if not current_category or entry.category == current_category then
-
-            -- check if the query matches either the name or the commandline
-            -- of some entry
-            if string.match(entry.name, pattern)
-                or string.match(entry.cmdline, pattern) then
-
-                entry.weight = 0
-                entry.prio = PRIO_NONE
-
-                -- get use count from count_table if present
-                -- and use it as weight
-                if string.len(pattern) > 0 and count_table[entry.name] ~= nil then
-                    entry.weight = tonumber(count_table[entry.name])
-                end
-
-                -- check for prefix match
-                if string.match(entry.name, "^" .. pattern)
-                    or string.match(entry.cmdline, "^" .. pattern) then
-                    -- increase default priority
-                    entry.prio = PRIO_NONE + 1
-                else
-                    entry.prio = PRIO_NONE
-                end
+    local add_entry = function(entry, lower_name, lower_cmdline)
+        entry.weight = 0
+        entry.prio = PRIO_NONE
+
+        -- get use count from count_table if present
+        -- and use it as weight
+        if string.len(pattern) > 0 and count_table[entry.name] ~= nil then
+            entry.weight = tonumber(count_table[entry.name])
+        end
 
-                table.insert (command_list, entry)
-            end
+        -- check for prefix match
+        if gstring.startswith(lower_name, lower_query)
+            or gstring.startswith(lower_cmdline, lower_query) then
+            -- increase default priority
+            entry.prio = PRIO_NONE + 1
+        else
+            entry.prio = PRIO_NONE
         end
+
+        table.insert (command_list, entry)
     end
 
     -- Add entries if required
     if query ~= "" or menubar.match_empty then
-        for _, v in ipairs(menubar.menu_entries) do
-            add_entry(v)
+        local index = get_search_index()
+        for _, i in ipairs(search.find(index, lower_query, current_category)) do
+            add_entry(index.entries[i], index.names[i], index.cmdlines[i])
         end
     end
 
@@ -10,6 +10,7 @@
 local gtable = require("gears.table")
 local gfilesystem = require("gears.filesystem")
 local utils = require("menubar.utils")
+local icon_theme = require("menubar.icon_theme")
 local pairs = pairs
 local ipairs = ipairs
 local table = table
@@ -82,6 +83,9 @@ end
 -- @staticfct menubar.menu_gen.generate
 -- @noreturn
 function menu_gen.generate(callback)
+    -- Find the icons installed since the last time
+    icon_theme.refresh()
+
     -- Update icons for category entries
     menu_gen.lookup_category_icons()
 
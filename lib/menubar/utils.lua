@@ -18,6 +18,8 @@ local gio = lgi.Gio
 local glib = lgi.GLib
 local w_textbox = require("wibox.widget.textbox")
 local gdebug = require("gears.debug")
+local gtimer = require("gears.timer")
+local cache = require("menubar._cache")
 local protected_call = require("gears.protected_call")
 local unpack = unpack or table.unpack -- luacheck: globals unpack (compatibility with Lua 5.1)
 
@@ -352,7 +354,101 @@ function utils.parse_desktop_file(file)
     return program
 end
 
+-- The desktop entry index.
+--
+-- Every directory parsed by `parse_dir` is stored with its modification time
+-- and its children, in the order of the enumeration: the parsed entries of its
+-- files (with their own modification time) and its subdirectories. As long as
+-- the modification time of a directory does not change, its entries are taken
+-- from the index without listing it. Otherwise, only the files which changed
+-- are parsed again.
+--
+-- The entries depend on the locale, the icon theme, `wm_name` and `terminal`,
+-- the whole index is dropped when any of them changes.
+local index_version = 1
+local desktop_index = nil
+local desktop_index_dirty = false
+
+--- Path of the desktop entry index.
+--
+-- Set to `false` to disable the index.
+--
+-- @param[opt=gears.filesystem.get_cache_dir() .. "menubar_index"] string|boolean
+utils.index_file = nil
+
+local function get_index_file()
+    if utils.index_file == nil then
+        return gfs.get_cache_dir() .. "menubar_index"
+    end
+    return utils.index_file
+end
+
+local function get_index_key()
+    return table.concat({
+        index_version,
+        glib.get_language_names()[1] or "",
+        theme.icon_theme or "",
+        utils.wm_name,
+        utils.terminal,
+    }, "\0")
+end
+
+local function load_index()
+    local key = get_index_key()
+    if desktop_index and desktop_index.key == key then
+        return desktop_index
+    end
+
+    local path = get_index_file()
+    local loaded = path and cache.load(path, key)
+    desktop_index = { key = key, dirs = loaded and loaded.dirs or {} }
+    desktop_index_dirty = false
+
+    return desktop_index
+end
+
+local function save_index()
+    local path = get_index_file()
+    if not desktop_index_dirty or not path then return end
+    desktop_index_dirty = false
+
+    local ok, err = cache.save(path, desktop_index.key, { dirs = desktop_index.dirs })
+    if not ok then
+        gdebug.print_warning("Cannot write the menubar index: " .. tostring(err))
+    end
+end
+
+local function mark_index_dirty()
+    if not desktop_index_dirty then
+        desktop_index_dirty = true
+        gtimer.delayed_call(save_index)
+    end
+end
+
+--- Drop the desktop entry index.
+--
+-- The next `parse_dir` parses every file again.
+--
+-- @staticfct menubar.utils.clear_index
+-- @noreturn
+function utils.clear_index()
+    desktop_index = { key = get_index_key(), dirs = {} }
+    mark_index_dirty()
+end
+
+local mtime_query = gio.FILE_ATTRIBUTE_TIME_MODIFIED .. "," .. gio.FILE_ATTRIBUTE_TIME_MODIFIED_USEC
+
+local function get_mtime(info)
+    return info:get_attribute_uint64(gio.FILE_ATTRIBUTE_TIME_MODIFIED) * 1000000
+        + info:get_attribute_uint32(gio.FILE_ATTRIBUTE_TIME_MODIFIED_USEC)
+end
+
 --- Parse a directory with .desktop files recursively.
+--
+-- The parsed entries are kept in an index under the cache directory, see
+-- `index_file`. Only the directories which were modified since the previous
+-- call are listed again.
+--
 -- @tparam string dir_path The directory path.
 -- @tparam function callback Will be fired when all the files were parsed
 -- with the resulting list of menu entries as argument.
@@ -360,41 +456,106 @@ end
 -- @staticfct menubar.utils.parse_dir
 -- @noreturn
 function utils.parse_dir(dir_path, callback)
+    local index = get_index_file() and load_index() or { dirs = {} }
 
     local function get_readable_path(file)
         return file:get_path() or file:get_uri()
     end
 
-    local function parser(file, programs)
+    local function parse_file(path)
+        local success, program = pcall(utils.parse_desktop_file, path)
+        if not success then
+            gdebug.print_error("Error while reading '" .. path .. "': " .. program)
+            return false
+        end
+        return program or false
+    end
+
+    local parser
+
+    local function add_children(children, programs)
+        for _, child in ipairs(children) do
+            if child.dir then
+                parser(gio.File.new_for_path(child.path), programs)
+            elseif child.program then
+                table.insert(programs, child.program)
+            end
+        end
+    end
+
+    function parser(file, programs, mtime)
+        local path = get_readable_path(file)
+        local cached = index.dirs[path]
+
+        if not mtime then
+            local info = file:async_query_info(mtime_query, gio.FileQueryInfoFlags.NONE)
+            mtime = info and get_mtime(info)
+        end
+
+        if cached and mtime and cached.mtime == mtime then
+            add_children(cached.children, programs)
+            return
+        end
+
         -- Except for "NONE" there is also NOFOLLOW_SYMLINKS
         local query = gio.FILE_ATTRIBUTE_STANDARD_NAME .. "," .. gio.FILE_ATTRIBUTE_STANDARD_TYPE
+            .. "," .. mtime_query
         local enum, err = file:async_enumerate_children(query, gio.FileQueryInfoFlags.NONE)
         if not enum then
-            gdebug.print_warning(get_readable_path(file) .. ": " .. tostring(err))
+            gdebug.print_warning(path .. ": " .. tostring(err))
+            if cached then
+                index.dirs[path] = nil
+                mark_index_dirty()
+            end
             return
         end
+
+        -- Reuse the files which did not change.
+        local previous = {}
+        for _, child in ipairs(cached and cached.children or {}) do
+            previous[child.path] = child
+        end
+
+        local children = {}
         local files_per_call = 100 -- Actual value is not that important
         while true do
             local list, enum_err = enum:async_next_files(files_per_call)
             if enum_err then
-                gdebug.print_error(get_readable_path(file) .. ": " .. tostring(enum_err))
+                gdebug.print_error(path .. ": " .. tostring(enum_err))
+
+                -- Keep what was read and the previous entries for the rest,
+                -- but don't index this incomplete listing.
+                local seen = {}
+                for _, child in ipairs(children) do
+                    seen[child.path] = true
+                end
+                for _, child in ipairs(cached and cached.children or {}) do
+                    if not seen[child.path] then
+                        table.insert(children, child)
+                    end
+                end
+                enum:async_close()
+                add_children(children, programs)
                 return
             end
             for _, info in ipairs(list) do
                 local file_type = info:get_file_type()
                 local file_child = enum:get_child(info)
-                if file_type == 'REGULAR' then
-                    local path = file_child:get_path()
-                    if path then
-                        local success, program = pcall(utils.parse_desktop_file, path)
-                        if not success then
-                            gdebug.print_error("Error while reading '" .. path .. "': " .. program)
-                        elseif program then
-                            table.insert(programs, program)
-                        end
+                local child_path = file_child:get_path()
+                if file_type == 'REGULAR' and child_path then
+                    local child_mtime = get_mtime(info)
+                    local child = previous[child_path]
+                    if not child or child.dir or child.mtime ~= child_mtime then
+                        child = {
+                            path    = child_path,
+                            mtime   = child_mtime,
+                            program = parse_file(child_path),
+                        }
                     end
+                    table.insert(children, child)
                 elseif file_type == 'DIRECTORY' then
-                    parser(file_child, programs)
+                    table.insert(children, { path = get_readable_path(file_child), dir = true })
+                    previous[get_readable_path(file_child)] = nil
                 end
             end
             if #list == 0 then
@@ -402,6 +563,20 @@ function utils.parse_dir(dir_path, callback)
             end
         end
         enum:async_close()
+
+        -- Forget the subdirectories which are gone.
+        for _, child in pairs(previous) do
+            if child.dir then
+                index.dirs[child.path] = nil
+            end
+        end
+
+        index.dirs[path] = { mtime = mtime, children = children }
+        if mtime and index == desktop_index then
+            mark_index_dirty()
+        end
+
+        add_children(children, programs)
     end
 
     gio.Async.start(do_protected_call)(function()
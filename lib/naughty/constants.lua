@@ -20,6 +20,9 @@ ret.config = {
     icon_dirs       = { "/usr/share/pixmaps/", "/usr/share/icons/hicolor" },
     icon_formats    = { "png", "gif" },
     notify_callback = nil,
+    burst_window    = 1,
+    burst_limit     = nil,
+    spare_boxes     = 0,
 }
 
 no_clear.presets = {
@@ -46,6 +46,15 @@ local naughty = {}
 --   access the freedesktop hints via `args.freedesktop_hints` if any where
 --   specified.
 --
+-- @tfield[opt=1] number burst_window The duration of a burst, in seconds.
+-- @tfield[opt=nil] integer burst_limit The number of notifications an
+--   application can show during a burst. The next ones sent over DBUS update
+--   the latest one instead of adding popups. Disabled when nil.
+-- @tfield[opt=0] integer spare_boxes The number of closed `naughty.layout.box`
+--   popups kept to show the next notifications, instead of creating new ones.
+--   Only the boxes created with the `notification` argument alone are kept.
+--   Do not keep references to the boxes when this is enabled.
+--
 -- @tfield table presets Notification presets.  See `config.presets`.
 --
 -- @tfield table defaults Default values for the params to `naughty.notification{}`.  These can
@@ -245,6 +254,18 @@ capi.screen.connect_signal("removed", function(scr)
 end)
 
 local function remove_from_index(n)
+    -- The list it was added to, unless the public table was modified.
+    local list = n._private.index_list
+    n._private.index_list = nil
+
+    for k, n2 in ipairs(list or {}) do
+        if n2 == n then
+            assert(list[k+1] ~= n, "The notification index is corrupted")
+            table.remove(list, k)
+            return
+        end
+    end
+
     for _, positions in pairs(naughty.notifications) do
         for _, ns in pairs(positions) do
             for k, n2 in ipairs(ns) do
@@ -265,15 +286,22 @@ local function update_index(n)
 
     assert(not n._private.is_destroyed, "The notification index is corrupted")
 
-    -- Find the only index and remove it (there's an useless loop, but it's small).
-    remove_from_index(n)
-
-    -- Add to the index again
     local s = get_screen(n.screen
         or (n.preset and n.preset.screen)
         or screen.focused())
     naughty.notifications[s] = naughty.notifications[s] or {}
-    table.insert(naughty.notifications[s][n.position], n)
+
+    local list = naughty.notifications[s][n.position]
+
+    -- Setting the same screen or position again is frequent, there is nothing
+    -- to move then.
+    if list == n._private.index_list then return end
+
+    remove_from_index(n)
+
+    -- Add to the index again
+    table.insert(list, n)
+    n._private.index_list = list
 end
 
 --- Notification state.
@@ -701,6 +729,7 @@ local function register(notification, args)
     -- insert the notification to the table
     table.insert(naughty._active, notification)
     table.insert(naughty.notifications[s][notification.position], notification)
+    notification._private.index_list = naughty.notifications[s][notification.position]
     notification.idx    = #naughty.notifications[s][notification.position]
     notification.screen = s
 
@@ -120,6 +120,41 @@ local function convert_icon(w, h, rowstride, channels, data)
     return res
 end
 
+-- The current burst of each application: when it started, how many
+-- notifications it had and the latest popup, which the extra ones update.
+-- The application names are chosen by the clients, so they are only trusted
+-- within a DBus connection.
+local bursts = {}
+
+local function get_burst_target(sender, appname)
+    local limit = cst.config.burst_limit
+    if not limit or limit <= 0 then return nil end
+
+    local now = GLib.get_monotonic_time() / 1000000
+    local window = cst.config.burst_window or 1
+    local key = sender .. "\0" .. appname
+    local burst = bursts[key]
+
+    if not burst or now - burst.start > window then
+        -- Forget the bursts which are over, the connections come and go.
+        for k, b in pairs(bursts) do
+            if now - b.start > window then
+                bursts[k] = nil
+            end
+        end
+
+        burst = setmetatable({ start = now, count = 0 }, { __mode = "v" })
+        bursts[key] = burst
+    end
+
+    burst.count = burst.count + 1
+
+    local last = burst.last
+    if burst.count > limit and last and not last._private.is_destroyed then
+        return last
+    end
+end
+
 local notif_methods = {}
 
 function notif_methods.Notify(sender, object_path, interface, method, parameters, invocation)
@@ -298,6 +333,12 @@ function notif_methods.Notify(sender, object_path, interface, method, parameters
         -- Try to update existing objects when possible
         notification = naughty.get_by_id(replaces_id)
 
+        -- Past the limit, the application updates its latest popup instead of
+        -- stacking new ones.
+        if not notification then
+            notification = get_burst_target(sender, appname)
+        end
+
         if notification then
             if not notification._private._unique_sender then
                 -- If this happens, the notification is either trying to
@@ -343,6 +384,11 @@ function notif_methods.Notify(sender, object_path, interface, method, parameters
             notification = nnotif(args)
 
             notification:connect_signal("destroyed", function(_, r) args.destroy(r) end)
+
+            local burst = bursts[sender .. "\0" .. appname]
+            if burst then
+                burst.last = notification
+            end
         end
 
         invocation:return_value(GLib.Variant("(u)", { notification.id }))
@@ -23,11 +23,19 @@ local abutton    = require("awful.button")
 local ascreen    = require("awful.screen")
 local gpcall     = require("gears.protected_call")
 local dpi        = require("beautiful").xresources.apply_dpi
+local cst        = require("naughty.constants")
 
 local default_widget = require("naughty.widget._default")
 
 local box, by_position = {}, {}
 
+-- The hidden boxes kept for the next notifications, see
+-- `naughty.config.spare_boxes`.
+local spare = {}
+
+-- The positions to update with the next frame, and their preset.
+local pending_positions = nil
+
 -- Init the weak tables for each positions. It is done ahead of time rather
 -- than when notifications are added to simplify the code.
 
@@ -59,6 +67,10 @@ local function disconnect(self)
         n:disconnect_signal("property::suspended",
             self._private.hide)
     end
+
+    if self._private.update then
+        self:disconnect_signal("property::geometry", self._private.update)
+    end
 end
 
 ascreen.connect_for_each_screen(init_screen)
@@ -89,31 +101,54 @@ local function get_offset(position, preset)
 end
 
 -- Leverage `awful.placement` to create the stacks.
-local function update_position(position, preset)
+local function place(list, k, position, preset)
     local pref  = position:match("top_") and "bottom" or "top"
     local align = position:match("_(.*)")
         :gsub("left", "front"):gsub("right", "back")
 
-    for _, pos in pairs(by_position) do
-        for k, wdg in ipairs(pos[position]) do
-            local args = {
-                geometry            = pos[position][k-1],
-                preferred_positions = {pref },
-                preferred_anchors   = {align},
-                margins             = get_spacing(),
-                honor_workarea      = true,
-            }
-            if k == 1 then
-                args.offset = get_offset(position, preset)
-            end
+    local args = {
+        geometry            = list[k-1],
+        preferred_positions = {pref },
+        preferred_anchors   = {align},
+        margins             = get_spacing(),
+        honor_workarea      = true,
+    }
+    if k == 1 then
+        args.offset = get_offset(position, preset)
+    end
 
-            -- The first entry is aligned to the workarea, then the following to the
-            -- previous widget.
-            placement[k==1 and position:gsub("_middle", "") or "next_to"](wdg, args)
+    -- The first entry is aligned to the workarea, then the following to the
+    -- previous widget.
+    placement[k==1 and position:gsub("_middle", "") or "next_to"](list[k], args)
+end
+
+local function update_position(position, preset)
+    for _, pos in pairs(by_position) do
+        for k in ipairs(pos[position]) do
+            place(pos[position], k, position, preset)
         end
     end
 end
 
+-- Removing or resizing a box moves all the following ones, which then emit
+-- `property::geometry` in turn. During a burst, do it once per frame.
+local function queue_update_position(position, preset)
+    if not pending_positions then
+        pending_positions = {}
+
+        gtimer.delayed_call(function()
+            local positions = pending_positions
+            pending_positions = nil
+
+            for pos, pos_preset in pairs(positions) do
+                update_position(pos, pos_preset or nil)
+            end
+        end)
+    end
+
+    pending_positions[position] = preset or pending_positions[position] or false
+end
+
 local function finish(self)
     self.visible = false
     assert(init_screen(self.screen)[self.position])
@@ -127,11 +162,17 @@ local function finish(self)
 
     local preset = (self._private.notification[1] or {}).preset
 
-    update_position(self.position, preset)
+    queue_update_position(self.position, preset)
 
     disconnect(self)
 
     self._private.notification = {}
+
+    if self._private.recyclable and not self._private.spare
+            and #spare < (cst.config.spare_boxes or 0) then
+        self._private.spare = true
+        table.insert(spare, self)
+    end
 end
 
 -- It isn't a good idea to use the `attach` `awful.placement` property. If the
@@ -140,7 +181,7 @@ end
 capi.screen.connect_signal("property::geometry", function(s)
     for pos, notifs in pairs(by_position[s]) do
         if #notifs > 0 then
-            update_position(pos, notifs[1].preset)
+            queue_update_position(pos, notifs[1].preset)
         end
     end
 end)
@@ -275,9 +316,10 @@ local function init(self, notification)
 
     self:_apply_size_now()
 
-    table.insert(init_screen(s)[position], self)
+    local list = init_screen(s)[position]
+    table.insert(list, self)
 
-    self._private.update = function() update_position(position, preset) end
+    self._private.update = function() queue_update_position(position, preset) end
     self._private.hide = function(_, value)
         if value then
             finish(self)
@@ -289,7 +331,10 @@ local function init(self, notification)
     notification:weak_connect_signal("property::suspended", self._private.hide)
     notification:weak_connect_signal("destroyed", self._private.destroy_callback)
 
-    update_position(position, preset)
+    -- The previous boxes do not move, place the new one right away, the stack
+    -- is checked with the next frame.
+    place(list, #list, position, preset)
+    queue_update_position(position, preset)
 
     self.visible = true
 end
@@ -332,9 +377,42 @@ end
 -- @usebeautiful beautiful.notification_position If `position` is not defined
 -- in the notification object (or in this constructor).
 
+-- Only the boxes using the defaults can be reused for any notification.
+local function is_recyclable(args)
+    for k in pairs(args) do
+        if k ~= "notification" then return false end
+    end
+
+    return args.notification ~= nil and args.notification.widget_template == nil
+end
+
+local function recycle(args)
+    local n = args.notification
+
+    while #spare > 0 do
+        local ret = table.remove(spare)
+        ret._private.spare = false
+
+        -- The screen may have been removed in the meantime.
+        if ret.screen and ret.screen.valid and n.screen and n.screen.valid then
+            ret.screen = n.screen
+            awcommon._set_common_property(ret.widget, "notification", n)
+            ret:set_notification(n)
+            return ret
+        end
+    end
+end
+
 local function new(args)
     args = args or {}
 
+    local recyclable = is_recyclable(args)
+
+    if recyclable and (cst.config.spare_boxes or 0) > 0 then
+        local ret = recycle(args)
+        if ret then return ret end
+    end
+
     -- Set the default wibox values
     local new_args = {
         ontop        = true,
@@ -366,6 +444,7 @@ local function new(args)
     ret._private.notification = {}
     ret._private.widget_template = args.widget_template
     ret._private.position = args.position
+    ret._private.recyclable = recyclable
 
     gtable.crush(ret, box, true)
 
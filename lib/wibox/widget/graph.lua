@@ -348,6 +348,142 @@ end
 -- Set up the nan_color fallback.
 prop_fallbacks.nan_color = build_fallback_nan_color()
 
+--
+-- Value storage.
+--
+-- Each data group is a ring of values, the newest one at `ring.last` and the
+-- oldest one at `ring.first`, so the i-th newest value is
+-- `ring[ring.last - i + 1]`. Adding a value and dropping the oldest ones
+-- doesn't move the others; the values are only moved back to the start of the
+-- table once most of it is unused.
+--
+-- For autoscaling, a ring also keeps the indexes of the values that can still
+-- become the minimum or maximum of its `window` newest values, in increasing
+-- order. Their first index is the current extreme.
+--
+
+-- The number of unused slots a ring or queue keeps before being moved back.
+local RING_MIN_WASTE = 256
+
+local function ring_new()
+    return {
+        first = 1,
+        last = 0,
+        window = 0,
+        min_q = { head = 1, tail = 0 },
+        max_q = { head = 1, tail = 0 },
+    }
+end
+
+local function ring_len(ring)
+    return ring.last - ring.first + 1
+end
+
+local function queue_compact(q)
+    local head, tail = q.head, q.tail
+    if head <= RING_MIN_WASTE or head <= tail - head + 1 then return end
+
+    local shift = head - 1
+    for k = head, tail do
+        q[k - shift] = q[k]
+        q[k] = nil
+    end
+    q.head, q.tail = 1, tail - shift
+end
+
+local function queue_push(q, ring, idx, dominates)
+    local value = ring[idx]
+    -- A NaN is never an extreme
+    if value ~= value then return end
+
+    -- Drop the values which can no longer be an extreme
+    local head, tail = q.head, q.tail
+    while tail >= head and dominates(value, ring[q[tail]]) do
+        q[tail] = nil
+        tail = tail - 1
+    end
+
+    tail = tail + 1
+    q[tail] = idx
+    q.tail = tail
+end
+
+local function queue_drop_before(q, idx)
+    local head, tail = q.head, q.tail
+    while head <= tail and q[head] < idx do
+        q[head] = nil
+        head = head + 1
+    end
+    q.head = head
+    queue_compact(q)
+end
+
+local function less_or_equal(a, b) return a <= b end
+local function greater_or_equal(a, b) return a >= b end
+
+local function ring_compact(ring)
+    local first, last = ring.first, ring.last
+    if first <= RING_MIN_WASTE or first <= last - first + 1 then return end
+
+    local shift = first - 1
+    for k = first, last do
+        ring[k - shift] = ring[k]
+        ring[k] = nil
+    end
+    ring.first, ring.last = 1, last - shift
+
+    for _, q in ipairs { ring.min_q, ring.max_q } do
+        for k = q.head, q.tail do
+            q[k] = q[k] - shift
+        end
+    end
+end
+
+local function ring_push(ring, value, capacity)
+    local last, first = ring.last + 1, ring.first
+    ring[last] = value
+    ring.last = last
+
+    -- Drop the oldest values over capacity
+    while last - first + 1 > capacity do
+        ring[first] = nil
+        first = first + 1
+    end
+    ring.first = first
+
+    if ring.window > 0 then
+        -- Forget the dropped values first, they can't be compared anymore
+        local oldest = math_max(first, last - ring.window + 1)
+        queue_drop_before(ring.min_q, oldest)
+        queue_drop_before(ring.max_q, oldest)
+        queue_push(ring.min_q, ring, last, less_or_equal)
+        queue_push(ring.max_q, ring, last, greater_or_equal)
+    end
+
+    ring_compact(ring)
+end
+
+-- Track the extremes among the `window` newest values, 0 to stop tracking.
+local function ring_set_window(ring, window)
+    if ring.window == window then return end
+
+    ring.window = window
+    ring.min_q = { head = 1, tail = 0 }
+    ring.max_q = { head = 1, tail = 0 }
+
+    for idx = math_max(ring.first, ring.last - window + 1), ring.last do
+        queue_push(ring.min_q, ring, idx, less_or_equal)
+        queue_push(ring.max_q, ring, idx, greater_or_equal)
+    end
+end
+
+-- The extremes among the `window` newest values, nil if they are all NaNs.
+local function ring_extremes(ring)
+    local min_q, max_q = ring.min_q, ring.max_q
+    if min_q.head > min_q.tail then return end
+    return ring[min_q[min_q.head]], ring[max_q[max_q.head]]
+end
+
 --
 -- Module and prototype methods.
 --
@@ -426,9 +562,11 @@ end
 local function graph_preprocess_values(self, values, drawn_values_num)
     -- TODO: elevate to function documentation, if we decide to make it public API.
     --- Preprocesses values before drawing them.
-    -- This function can return up to 2 values: drawn_values and scaling_values
-    -- The former will be used as values to draw in place of the original data.
-    -- The latter will be used as values to scan for min/max value for scaling.
+    -- This function can return up to 3 values: drawn_values, data_min and
+    -- data_max.
+    -- The former will be used as values to draw in place of the original data,
+    -- as arrays with the newest value first.
+    -- The latter will be used as the range of the data for scaling.
     -- Either can be nil, which means: use values as is.
 
     -- This default implementation is only used to implement
@@ -437,30 +575,48 @@ local function graph_preprocess_values(self, values, drawn_values_num)
         return
     end
 
-    -- Prepare to draw a stacked graph
+    -- Prepare to draw a stacked graph, reusing the arrays of the last time
+
+    local buffers = self._private.stack_buffers
+    if not buffers then
+        buffers = { summed = {}, drawn = {} }
+        self._private.stack_buffers = buffers
+    end
 
     -- summed_values[i] = sum [1,#values] of values[c][i]
-    local summed_values = {}
+    local summed_values = buffers.summed
     -- drawn_values[c][i] = sum [1,c] of values[c][i]
-    local drawn_values = {}
+    local drawn_values = buffers.drawn
 
     local nan = 0/0
 
+    local summed_num = 0
+    for group_idx, ring in ipairs(values) do
+        if graph_should_draw_data_group(self, group_idx) then
+            summed_num = math_max(summed_num, math_min(ring_len(ring), drawn_values_num))
+        end
+    end
+    for idx = 1, summed_num do
+        summed_values[idx] = 0
+    end
+
     -- Add stacked values up to get values we need to render
-    for group_idx, group_values in ipairs(values) do
-        local drawn_row = {}
+    for group_idx, ring in ipairs(values) do
+        local drawn_row = drawn_values[group_idx] or {}
         drawn_values[group_idx] = drawn_row
+        local drawn_num = 0
 
         if graph_should_draw_data_group(self, group_idx) then
-            for idx, value in ipairs(group_values) do
-                if idx > drawn_values_num then
-                    break
-                end
+            local last = ring.last
+            drawn_num = math_min(ring_len(ring), drawn_values_num)
+
+            for idx = 1, drawn_num do
+                local value = ring[last - idx + 1]
 
                 -- drawn_values will have NaN values in it due to negatives/NaNs in input.
                 -- we can't simply treat them like zeros during rendering,
                 -- in case step_shape() draws visible shapes for actual zero values too.
-                local acc = summed_values[idx] or 0
+                local acc = summed_values[idx]
                 if value >= 0 then
                     acc = acc + value
                     drawn_row[idx] = acc
@@ -470,14 +626,27 @@ local function graph_preprocess_values(self, values, drawn_values_num)
                 summed_values[idx] = acc
             end
         end
+
+        -- Drop what is left from the last time
+        for idx = drawn_num + 1, #drawn_row do
+            drawn_row[idx] = nil
+        end
+    end
+    for group_idx = #values + 1, #drawn_values do
+        drawn_values[group_idx] = nil
     end
 
-    -- In a stacked graph it's sufficient to examine only the last summed row
+    -- In a stacked graph it's sufficient to examine only the summed values
     -- to determine the max_value, since all values are necessarily >= 0
     -- and the min_value should be always at most 0
-    local scaling_values = { {0}, summed_values }
+    local data_max = 0
+    for idx = 1, summed_num do
+        if summed_values[idx] > data_max then
+            data_max = summed_values[idx]
+        end
+    end
 
-    return drawn_values, scaling_values
+    return drawn_values, 0, data_max
 end
 
 local function graph_map_value_to_widget_coordinates(self, value, min_value, max_value, height)
@@ -497,28 +666,19 @@ local function graph_map_value_to_widget_coordinates(self, value, min_value, max
     return value --NaN
 end
 
-local function graph_choose_coordinate_system(self, scaling_values, drawn_values_num, height)
+local function graph_choose_coordinate_system(self, data_min, data_max, height)
     local scale = self._private.scale
     local max_value = self._private.max_value or (scale and -math.huge or 1)
     local min_value = self._private.min_value or (scale and math.huge or 0)
 
     if scale then
-        for _, group_values in ipairs(scaling_values) do
-            for idx, v in ipairs(group_values) do
-                -- Do not let off-screen values affect autoscaling
-                if idx > drawn_values_num then
-                    break
-                end
-
-                -- We don't use math.min/max here to be sure that
-                -- min/max_value don't accidentally get assigned a NaN
-                if v > max_value then
-                    max_value = v
-                end
-                if min_value > v then
-                    min_value = v
-                end
-            end
+        -- We don't use math.min/max here to be sure that
+        -- min/max_value don't accidentally get assigned a NaN
+        if data_max and data_max > max_value then
+            max_value = data_max
+        end
+        if data_min and min_value > data_min then
+            min_value = data_min
         end
         if min_value == max_value then
             -- If all values are equal in an autoscaled graph,
@@ -554,28 +714,47 @@ local function graph_draw_values(self, cr, _, height, drawn_values_num)
     -- Preserve the transform centered at the top-left corner of the graph
     local pristine_transform = step_shape and cr:get_matrix()
 
-    local drawn_values, scaling_values = graph_preprocess_values(self, values, drawn_values_num)
-    -- If preprocessor returned drawn_values = nil, then simply draw the values we have
-    drawn_values = drawn_values or values
-    -- If preprocessor returned scaling_values = nil, then
-    -- all drawn values need to be examined to determine proper scaling
-    scaling_values = scaling_values or drawn_values
+    local drawn_values, data_min, data_max = graph_preprocess_values(
+        self, values, drawn_values_num
+    )
+
+    -- If preprocessor returned no range, then use the extremes
+    -- the rings keep of the drawn values, for autoscaling only
+    local window = (data_min == nil and self._private.scale) and drawn_values_num or 0
+    for _, ring in ipairs(values) do
+        ring_set_window(ring, window)
+        if window > 0 then
+            local ring_min, ring_max = ring_extremes(ring)
+            if ring_min and not (data_min and data_min <= ring_min) then
+                data_min = ring_min
+            end
+            if ring_max and not (data_max and data_max >= ring_max) then
+                data_max = ring_max
+            end
+        end
+    end
 
     local min_value, max_value, baseline_y = graph_choose_coordinate_system(
-        self, scaling_values, drawn_values_num, height
+        self, data_min, data_max, height
     )
 
     local nan_x = self._private.nan_indication and {}
     local prev_y = self._private.stack and {}
 
-    for group_idx, group_values in ipairs(drawn_values) do
+    for group_idx, ring in ipairs(values) do
         if graph_should_draw_data_group(self, group_idx) then
             -- Set the data series' color early, in case the user
             -- wants to do their own painting inside step_shape()
             cr:set_source(color(self:pick_data_group_color(group_idx)))
 
-            for i = 1, math_min(#group_values, drawn_values_num) do
-                local value = group_values[i]
+            -- If preprocessor returned drawn_values = nil, then simply draw the values we have
+            local row, offset, direction = ring, ring.last + 1, -1
+            if drawn_values then
+                row, offset, direction = drawn_values[group_idx], 0, 1
+            end
+
+            for i = 1, math_min(ring_len(ring), drawn_values_num) do
+                local value = row[offset + direction*i]
 
                 local value_y = map_coords(self, value, min_value, max_value, height)
                 local not_nan = value_y == value_y
@@ -739,7 +918,7 @@ function graph:add_value(value, group)
         -- Ensure that there are no gaps in the values array,
         -- so that ipairs() can reach all data groups.
         for i = #values+1, group do
-            values[i] = {}
+            values[i] = ring_new()
         end
         -- If the above loop hasn't set it, then
         -- `group` wasn't a non-negative integer.
@@ -753,16 +932,12 @@ function graph:add_value(value, group)
     -- Map negatives, NaNs and zero to nil
     capacity = (capacity >= 1) and capacity
 
-    -- Remove old values over capacity
-    -- Invalid capacity means "remove everything"
-    local i = capacity or 1
-    while values[i] do
-        values[i] = nil
-        i = i + 1
-    end
-
     if capacity then
-        table.insert(values, 1, value)
+        -- Remove old values over capacity
+        ring_push(values, value, capacity)
+    else
+        -- Invalid capacity means "remove everything"
+        ring_push(values, value, 0)
     end
 
     self:emit_signal("widget::redraw_needed")
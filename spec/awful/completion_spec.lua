@@ -1,3 +1,7 @@
+-- awful.spawn needs the C API, the tests which use it fill this in.
+local spawn = {}
+package.loaded["awful.spawn"] = spawn
+
 local compl = require("awful.completion")
 local shell = function(...)
     local command, pos, matches = compl.shell(...)
@@ -222,6 +226,108 @@ describe("awful.completion.shell", function()
     end
 end)
 
+describe("awful.completion.shell cache", function()
+    local orig_dir = lfs.currentdir()
+    local sh = has_bash and 'bash' or 'zsh'
+    local spawned
+
+    -- Run the main loop until `cond` holds, for at most 5 seconds.
+    local function wait_for(cond)
+        local timed_out = false
+        local source = GLib.timeout_add(GLib.PRIORITY_DEFAULT, 5000, function()
+            timed_out = true
+            return false
+        end)
+        while not cond() and not timed_out do
+            GLib.MainContext.default():iteration(true)
+        end
+        if not timed_out then
+            GLib.source_remove(source)
+        end
+        return not timed_out
+    end
+
+    local function touch(path)
+        Gio.File.new_for_path(path):create(Gio.FileCreateFlags.NONE)
+    end
+
+    setup(function()
+        spawn.easy_async = function(cmd, callback)
+            table.insert(spawned, { cmd = cmd, callback = callback })
+        end
+
+        test_dir = get_test_dir()
+        touch(test_dir .. '/localcommand')
+        lfs.chdir(test_dir)
+        test_path = get_test_path_dir()
+    end)
+
+    teardown(function()
+        spawn.easy_async = nil
+        for _, name in ipairs({'localcommand', 'lonely', 'loose', 'lost'}) do
+            os.remove(test_dir .. '/' .. name)
+        end
+        assert.True(os.remove(test_dir))
+        remove_test_path_dir(test_path)
+        lfs.chdir(orig_dir)
+    end)
+
+    before_each(function()
+        spawned = {}
+    end)
+
+    it("calls back with the completions", function()
+        local results = {}
+        local function callback(...)
+            table.insert(results, {...})
+        end
+
+        -- The command line is returned unchanged until the shell answers, and
+        -- concurrent requests share it.
+        assert.same(shell('cat lo', 7, 1, sh, callback), {'cat lo', 7})
+        assert.same(shell('cat lo', 7, 2, sh, callback), {'cat lo', 7})
+        assert.same(#spawned, 1)
+        assert.same(#results, 0)
+
+        spawned[1].callback('localcommand\nlonely\n')
+        assert.same(results, {
+            {'cat localcommand', 17, {'localcommand', 'lonely'}},
+            {'cat lonely', 11, {'localcommand', 'lonely'}},
+        })
+
+        -- It is cached now.
+        assert.same(shell('cat lo', 7, 2, sh, callback),
+                    {'cat lonely', 11, {'localcommand', 'lonely'}})
+        assert.same(#spawned, 1)
+    end)
+
+    it("drops the completions when their directory changes", function()
+        assert.same(shell('ls l', 5, 1, sh), {'ls localcommand', 16, {'localcommand'}})
+
+        -- The change is only noticed from the main loop.
+        touch(test_dir .. '/loose')
+        assert.same(shell('ls l', 5, 1, sh), {'ls localcommand', 16, {'localcommand'}})
+
+        assert.True(wait_for(function()
+            return #shell('ls l', 5, 1, sh)[3] == 2
+        end))
+        assert.same(shell('ls l', 5, 2, sh), {'ls loose', 9, {'localcommand', 'loose'}})
+        assert.same(#spawned, 0)
+    end)
+
+    it("watches the directory of absolute paths", function()
+        local word = test_dir .. '/lo'
+        local command = 'ls ' .. word
+        local first = shell(command, #command + 1, 1, sh)
+        assert.same(first[3], {test_dir .. '/localcommand', test_dir .. '/loose'})
+
+        touch(test_dir .. '/lost')
+        assert.True(wait_for(function()
+            return #shell(command, #command + 1, 1, sh)[3] == 3
+        end))
+    end)
+end)
+
 describe("awful.completion.shell handles $SHELL", function()
     local orig_getenv = os.getenv
     local gdebug = require("gears.debug")
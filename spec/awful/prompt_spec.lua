@@ -391,6 +391,151 @@ insulate('main', function ()
         end)
     end)
 
+    describe('history', function()
+        local path
+
+        before_each(function()
+            path = os.tmpname()
+            os.remove(path)
+        end)
+
+        after_each(function()
+            os.remove(path)
+        end)
+
+        local function read_lines()
+            local lines = {}
+            for line in io.lines(path) do
+                table.insert(lines, line)
+            end
+            return lines
+        end
+
+        local function write_lines(lines)
+            local f = assert(io.open(path, "w"))
+            f:write(table.concat(lines, "\n") .. "\n")
+            f:close()
+        end
+
+        local function shown()
+            return (get_prompt_text(markup):gsub(' $', ''))
+        end
+
+        local function start(p, max)
+            p.run{ textbox = atextbox, history_path = path, history_max = max }
+        end
+
+        local function execute(p, max, command)
+            start(p, max)
+            enter_text(prompt_callback, command)
+            prompt_callback({}, 'Return', 'press')
+        end
+
+        -- The history as seen with Up, newest first.
+        local function browse(p, max)
+            start(p, max)
+            local entries = {}
+            while true do
+                prompt_callback({}, 'Up', 'press')
+                if shown() == entries[#entries] then break end
+                table.insert(entries, shown())
+            end
+            prompt_callback({}, 'Escape', 'press')
+            return entries
+        end
+
+        -- A module which has not loaded any history file yet.
+        local function reloaded()
+            package.loaded['awful.prompt'] = nil
+            local p = require 'awful.prompt'
+            package.loaded['awful.prompt'] = prompt
+            return p
+        end
+
+        it('appends the commands and loads them back', function()
+            execute(prompt, 50, 'a')
+            execute(prompt, 50, 'b')
+            execute(prompt, 50, 'b')
+            execute(prompt, 50, 'a')
+
+            assert.same({'a', 'b', 'a'}, read_lines())
+            assert.same({'a', 'b'}, browse(prompt, 50))
+            assert.same({'a', 'b'}, browse(reloaded(), 50))
+        end)
+
+        it('keeps the last occurrence of the newest commands', function()
+            write_lines({'x', 'y', 'x', 'z', 'w', 'z'})
+            assert.same({'z', 'w', 'x'}, browse(reloaded(), 3))
+            assert.same({'z', 'w'}, browse(reloaded(), 2))
+        end)
+
+        it('compacts the file past twice the limit', function()
+            local p = reloaded()
+            for i = 1, 4 do
+                execute(p, 2, 'c' .. i)
+            end
+            assert.same({'c1', 'c2', 'c3', 'c4'}, read_lines())
+
+            execute(p, 2, 'c5')
+            assert.same({'c4', 'c5'}, read_lines())
+            assert.is_nil(io.open(path .. '.tmp'))
+            assert.same({'c5', 'c4'}, browse(p, 2))
+
+            execute(p, 2, 'c6')
+            assert.same({'c4', 'c5', 'c6'}, read_lines())
+            assert.same({'c6', 'c5'}, browse(reloaded(), 2))
+        end)
+
+        it('compacts the file when an entry is deleted', function()
+            write_lines({'a', 'b', 'a', 'c'})
+            local p = reloaded()
+            start(p, 50)
+            prompt_callback({}, 'Up', 'press')
+            prompt_callback({}, 'Up', 'press')
+            assert.are_equal('a', shown())
+            prompt_callback({'Control'}, 'Delete', 'press')
+            prompt_callback({}, 'Escape', 'press')
+
+            assert.same({'b', 'c'}, read_lines())
+        end)
+
+        describe('search', function()
+            local p
+
+            before_each(function()
+                write_lines({'git status', 'make test', 'git commit', 'ls', 'git stash'})
+                p = reloaded()
+            end)
+
+            local function search(text, keys)
+                start(p, 50)
+                enter_text(prompt_callback, text)
+                local results = {}
+                for _, key in ipairs(keys) do
+                    prompt_callback({'Control'}, key, 'press')
+                    table.insert(results, shown())
+                end
+                prompt_callback({}, 'Escape', 'press')
+                return results
+            end
+
+            it('finds the entries containing the term', function()
+                assert.same({'git stash', 'git commit', 'git status', 'git status', 'git commit'},
+                            search('git', {'r', 'r', 'r', 'r', 's'}))
+                assert.same({'git stash', 'git status'}, search('sta', {'r', 'r'}))
+                assert.same({'make test', 'make test'}, search('ma', {'r', 'r'}))
+                assert.same({'git stash', 'ls', 'make test'}, search('s', {'r', 'r', 'r'}))
+                assert.same({'nope'}, search('nope', {'r'}))
+            end)
+
+            it('finds the entries starting with the term', function()
+                assert.same({'git stash', 'git status', 'git status', 'git stash'},
+                            search('git s', {'Up', 'Up', 'Up', 'Down'}))
+                assert.same({'tes'}, search('tes', {'Up'}))
+            end)
+        end)
+    end)
+
     describe('hooks', function()
         it('callback called', function()
             local callback_arg = ''
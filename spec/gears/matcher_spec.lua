@@ -81,6 +81,97 @@ describe("gears.matcher", function()
         assert.is_true(matcher_instance:_match_every(test_obj, rule))
     end)
 
+    describe("indexed matching", function()
+        local function linear(m, o, rules)
+            local ret = {}
+            for _, entry in ipairs(rules) do
+                if m:matches_rule(o, entry) then
+                    table.insert(ret, entry)
+                end
+            end
+            return ret
+        end
+
+        local rules = {
+            { id = 1, rule     = { class = "Firefox"                 } },
+            { id = 2, rule     = { class = "^XTerm$"                 } },
+            { id = 3, rule     = { class = "fox", instance = "Navig" } },
+            { id = 4, rule     = { class = "^[Gg]imp"                } },
+            { id = 5, rule_any = { class = { "XTerm", "mpv" }        } },
+            { id = 6, rule     = { class = "mpv"                     },
+                      rule_any = { type  = { "dialog" }              } },
+            { id = 7, rule     = { type  = "dialog", class = ""      } },
+            { id = 8, rule     = { instance = "term"                 } },
+            { id = 9, rule_every = { class = { "a" }                 } },
+            { id = 10, rule    = { role = "pop.up"                   } },
+            { id = 11, rule    = { class = "^XTerm$"                 },
+                       except  = { instance = "xterm"                } },
+            { id = 12, properties = { always = true                  } },
+        }
+
+        local objects = {
+            { class = "Firefox", instance = "Navigator", type = "normal" },
+            { class = "Firefox-esr", instance = "Navigator"              },
+            { class = "XTerm", instance = "xterm", type = "normal"       },
+            { class = "XTerm", instance = "uxterm"                       },
+            { class = "^XTerm$"                                          },
+            { class = "gimp", type = "dialog"                            },
+            { class = "Gimp-2.10", role = "popup"                        },
+            { class = "", type = "dialog"                                },
+            { class = "mpv", type = "dialog"                             },
+            { instance = "urxvt-term", role = "pop-up"                   },
+            { class = 42                                                 },
+            {                                                            },
+        }
+
+        it("matches the same rules in the same order", function()
+            local m = matcher()
+            m:append_rules("default", rules)
+
+            for _, o in ipairs(objects) do
+                assert.are.same(linear(m, o, rules), m:matching_rules(o, rules))
+            end
+        end)
+
+        it("notices direct changes to the rules", function()
+            local m = matcher()
+            m:append_rules("default", { rules[1], rules[2] })
+            local r = m._matching_rules["default"]
+
+            local o = { class = "Firefox" }
+            assert.are.same({ rules[1] }, m:matching_rules(o))
+
+            table.insert(r, 1, { id = "new", rule = { class = "Fire" } })
+            assert.are.same({ r[1], rules[1] }, m:matching_rules(o))
+
+            r[1].rule.class = "Ice"
+            assert.are.same({ rules[1] }, m:matching_rules(o))
+
+            table.remove(r, 1)
+            table.remove(r, 1)
+            assert.are.same({ rules[2] }, m:matching_rules({ class = "XTerm" }))
+        end)
+
+        it("does not index rules using property matchers", function()
+            local m = matcher()
+            m:append_rule("default", { rule = { class = "nope", screen = 1 } })
+            assert.are.same({}, m:matching_rules({ class = "XTerm" }))
+
+            m:add_property_matcher("screen", function() return true end)
+            assert.are.equal(1, #m:matching_rules({ class = "XTerm" }))
+        end)
+
+        it("notices property matchers added to indexed rules", function()
+            local m = matcher()
+            m:add_property_matcher("screen", function() return true end)
+            m:append_rule("default", { rule = { class = "nope" } })
+            assert.are.same({}, m:matching_rules({ class = "XTerm" }))
+
+            m._matching_rules["default"][1].rule.screen = 1
+            assert.are.equal(1, #m:matching_rules({ class = "XTerm" }))
+        end)
+    end)
+
      describe("check main vs. fallback rules", function()
         local m = matcher()
 
@@ -0,0 +1,78 @@
+---------------------------------------------------------------------------
+-- @author Abigail Teague
+-- @copyright 2026 Abigail Teague
+---------------------------------------------------------------------------
+
+local cache = require("menubar._cache")
+
+describe("menubar._cache", function()
+    local path
+
+    before_each(function()
+        path = os.tmpname()
+        os.remove(path)
+    end)
+
+    after_each(function()
+        os.remove(path)
+        os.remove(path .. ".tmp")
+    end)
+
+    it("saves and loads a table", function()
+        local data = {
+            dirs = {
+                ["/usr/share/applications"] = {
+                    mtime = 1700000000123456,
+                    children = {
+                        { path = "/usr/share/applications/a.desktop", program = false },
+                        { path = "/usr/share/applications/sub", dir = true },
+                    },
+                },
+            },
+            ratio = 0.1,
+            text = "quotes \" and \\ and\nnewlines",
+        }
+
+        assert.is_true(cache.save(path, "key 1", data))
+        assert.is.same(data, cache.load(path, "key 1"))
+
+        -- The file is replaced through a temporary one.
+        assert.is_nil(io.open(path .. ".tmp"))
+    end)
+
+    it("drops a table saved with another key", function()
+        assert.is_true(cache.save(path, "key 1", { 1, 2, 3 }))
+        assert.is_nil(cache.load(path, "key 2"))
+
+        -- Saving again replaces it.
+        assert.is_true(cache.save(path, "key 2", { 4 }))
+        assert.is.same({ 4 }, cache.load(path, "key 2"))
+        assert.is_nil(cache.load(path, "key 1"))
+    end)
+
+    it("ignores missing and invalid files", function()
+        assert.is_nil(cache.load(path, "key"))
+
+        for _, content in ipairs {
+            "",
+            "return {",
+            "return 42",
+            "return { key = 'key' }",
+            "error('boom')",
+            "return { key = 'key', data = os.exit() }",
+        } do
+            local file = assert(io.open(path, "w"))
+            file:write(content)
+            file:close()
+            assert.is_nil(cache.load(path, "key"), content)
+        end
+    end)
+
+    it("reports when it cannot save", function()
+        local ok, err = cache.save("/nonexistent/directory/file", "key", {})
+        assert.is_falsy(ok)
+        assert.is_not_nil(err)
+    end)
+end)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
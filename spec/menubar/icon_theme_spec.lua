@@ -14,6 +14,17 @@ local base_directories = {
 
 describe("menubar.icon_theme find_icon_path", function()
     local obj
+
+    -- Keep the directory listings out of the real cache directory.
+    setup(function()
+        icon_theme.index_file = os.tmpname()
+    end)
+
+    teardown(function()
+        os.remove(icon_theme.index_file)
+        icon_theme.index_file = nil
+    end)
+
     before_each(function()
         obj = icon_theme("awesome", base_directories)
     end)
@@ -60,4 +71,34 @@ describe("menubar.icon_theme find_icon_path", function()
     end
 end)
 
+describe("menubar.icon_theme.refresh", function()
+    local dir
+
+    setup(function()
+        icon_theme.index_file = false
+        dir = os.tmpname()
+        os.remove(dir)
+        require("gears.filesystem").make_directories(dir)
+    end)
+
+    teardown(function()
+        os.remove(dir .. "/new.png")
+        os.remove(dir)
+        icon_theme.index_file = nil
+    end)
+
+    it("finds the icons installed since the last lookup", function()
+        local obj = icon_theme("awesome", { dir })
+        assert.is_nil(obj:find_icon_path("new"))
+
+        local f = assert(io.open(dir .. "/new.png", "w"))
+        f:close()
+
+        -- The directories are only checked again after a refresh.
+        assert.is_nil(obj:find_icon_path("new"))
+        icon_theme.refresh()
+        assert.is.same(dir .. "/new.png", obj:find_icon_path("new"))
+    end)
+end)
+
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
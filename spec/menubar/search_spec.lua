@@ -0,0 +1,116 @@
+---------------------------------------------------------------------------
+-- @author Abigail Teague
+-- @copyright 2026 Abigail Teague
+---------------------------------------------------------------------------
+
+local search = require("menubar._search")
+local gstring = require("gears.string")
+
+local entries = {
+    { name = "Firefox",          cmdline = "firefox %u",           category = "Internet" },
+    { name = "Firefox Nightly",  cmdline = "firefox-nightly",      category = "Internet" },
+    { name = "GIMP",             cmdline = "gimp-2.10 %U",         category = "Graphics" },
+    { name = "Image Viewer",     cmdline = "eog",                  category = "Graphics" },
+    { name = "Terminal",         cmdline = "xterm -e bash",        category = "System"   },
+    { name = "Calc (50%)",       cmdline = "calc --percent",       category = "Office"   },
+    { name = "C++ IDE",          cmdline = "qtcreator",            category = "Development" },
+    { name = "[Bracketed]",      cmdline = "bracket.sh",           category = "Utility"  },
+    { name = "Mail.app",         cmdline = "thunderbird",          category = "Internet" },
+    { name = "Files",            cmdline = "nautilus --new-window", category = "System"  },
+}
+
+-- The matching of menubar before the index: a pattern match of every entry,
+-- and a higher priority for the prefix matches.
+local function pattern_matches(query, category)
+    local pattern = gstring.query_to_pattern(query)
+    local result = {}
+    for i, entry in ipairs(entries) do
+        if (not category or entry.category == category)
+            and (string.match(entry.name, pattern) or string.match(entry.cmdline, pattern)) then
+            local prefix = string.match(entry.name, "^" .. pattern)
+                or string.match(entry.cmdline, "^" .. pattern)
+            table.insert(result, { i = i, prio = prefix and 1 or 0 })
+        end
+    end
+    return result
+end
+
+-- The matching of menubar with the index.
+local function index_matches(index, query, category)
+    local lower_query = string.lower(query)
+    local result = {}
+    for _, i in ipairs(search.find(index, lower_query, category)) do
+        local prefix = gstring.startswith(index.names[i], lower_query)
+            or gstring.startswith(index.cmdlines[i], lower_query)
+        table.insert(result, { i = i, prio = prefix and 1 or 0 })
+    end
+    return result
+end
+
+-- Sort like menubar does, by priority, with the entry order breaking ties.
+local function ranked(matches)
+    table.sort(matches, function(a, b)
+        if a.prio == b.prio then
+            return a.i < b.i
+        end
+        return a.prio > b.prio
+    end)
+    return matches
+end
+
+local queries = {
+    "", "f", "F", "fi", "FIRE", "fox", "Nightly", "ox n", "refox", "x",
+    "gimp", "gImP-2", "2.10", ".", "%", "%u", "50%", "(50", "c++", "+",
+    "[b", "]", "-", "--", "e", "ter", "mail.", "l.a", "zzz", "  ",
+}
+
+describe("menubar._search", function()
+    it("matches like query_to_pattern", function()
+        local index = search.new(entries)
+        for _, query in ipairs(queries) do
+            assert.is.same(ranked(pattern_matches(query)), ranked(index_matches(index, query)),
+                "query: " .. query)
+        end
+    end)
+
+    it("matches like query_to_pattern within a category", function()
+        local index = search.new(entries)
+        for _, category in ipairs { "Internet", "Graphics", "System" } do
+            for _, query in ipairs(queries) do
+                assert.is.same(ranked(pattern_matches(query, category)),
+                    ranked(index_matches(index, query, category)),
+                    category .. " query: " .. query)
+            end
+        end
+    end)
+
+    it("matches like query_to_pattern while typing", function()
+        -- Each query refines the previous one, except when erasing or
+        -- switching category.
+        local index = search.new(entries)
+        local typed = {
+            { "f" }, { "fi" }, { "fir" }, { "fire" }, { "firef" }, { "fire" },
+            { "fi" }, { "fi", "Internet" }, { "fil" }, { "" }, { "e" }, { "e-" },
+            { "C" }, { "C+" }, { "C++" }, { "%" }, { "%U" },
+        }
+        for _, step in ipairs(typed) do
+            local query, category = step[1], step[2]
+            assert.is.same(ranked(pattern_matches(query, category)),
+                ranked(index_matches(index, query, category)),
+                tostring(category) .. " query: " .. query)
+        end
+    end)
+
+    it("ranks prefix matches first", function()
+        local index = search.new(entries)
+        local result = ranked(index_matches(index, "fi"))
+        -- Firefox, Firefox Nightly and Files start with "fi".
+        assert.is.same({ 1, 2, 10 }, { result[1].i, result[2].i, result[3].i })
+        assert.is.equal(1, result[3].prio)
+        for k = 4, #result do
+            assert.is.equal(0, result[k].prio)
+        end
+    end)
+end)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
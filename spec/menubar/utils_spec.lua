@@ -3,6 +3,8 @@
 -- @copyright 2017 Zach Peltzer
 ---------------------------------------------------------------------------
 
+package.loaded["gears.timer"] = {}
+
 local utils = require("menubar.utils")
 local theme = require("beautiful")
 local glib = require("lgi").GLib
@@ -40,12 +40,25 @@ local data2 = {-26.5, 25.0, -19.0, 38.0, 12.0 -19.0, -35.0, 16.5}
 
 local function push_data(widget, d, group_idx)
     -- Add in reverse, so that d could be compared with
-    -- the backing value array directly.
+    -- the stored values directly.
     for i = #d,1,-1 do
         widget:add_value(d[i], group_idx)
     end
 end
 
+-- The values of every data group, the newest first.
+local function stored_values(widget)
+    local result = {}
+    for group_idx, ring in ipairs(widget._private.values) do
+        local group_values = {}
+        for k = ring.last, ring.first, -1 do
+            table.insert(group_values, ring[k])
+        end
+        result[group_idx] = group_values
+    end
+    return result
+end
+
 describe("wibox.widget.graph", function()
     local widget
     local redraw_needed, layout_changed
@@ -172,14 +185,14 @@ describe("wibox.widget.graph", function()
 
     describe("values", function()
         it("are empty in a fresh instance", function()
-            assert.is.same({}, widget._private.values)
+            assert.is.same({}, stored_values(widget))
         end)
 
         describe("method add_value()", function()
             it("adds values", function()
                 push_data(widget, data)
                 -- Adds into the first datagroup by default.
-                assert.is.same({data}, widget._private.values)
+                assert.is.same({data}, stored_values(widget))
             end)
 
             it("defaults to NaN when no/falsy value is supplied", function()
@@ -191,28 +204,28 @@ describe("wibox.widget.graph", function()
                     widget:add_value(nil, 3)
                 end
 
-                assert.array(widget._private.values).has.no.holes()
-                assert.is.equal(3, #widget._private.values)
-                assert.is.equal(2*amount, #widget._private.values[1])
-                assert.is.equal(0, #widget._private.values[2])
-                assert.is.equal(2*amount, #widget._private.values[3])
+                assert.array(stored_values(widget)).has.no.holes()
+                assert.is.equal(3, #stored_values(widget))
+                assert.is.equal(2*amount, #stored_values(widget)[1])
+                assert.is.equal(0, #stored_values(widget)[2])
+                assert.is.equal(2*amount, #stored_values(widget)[3])
 
                 for i = 1, 2*amount do
-                    local tmp = widget._private.values[1][i]
+                    local tmp = stored_values(widget)[1][i]
                     assert.is_not.equal(tmp, tmp)
-                    tmp = widget._private.values[3][i]
+                    tmp = stored_values(widget)[3][i]
                     assert.is_not.equal(tmp, tmp)
                 end
             end)
 
             it("adds values into specific data group", function()
                 push_data(widget, data, 15)
-                assert.is.same(data, widget._private.values[15])
+                assert.is.same(data, stored_values(widget)[15])
 
                 -- Smaller datagroups are present too, but empty.
-                assert.array(widget._private.values).has.no.holes()
-                assert.is.equal(15, #widget._private.values)
-                for i, data_group in ipairs(widget._private.values) do
+                assert.array(stored_values(widget)).has.no.holes()
+                assert.is.equal(15, #stored_values(widget))
+                for i, data_group in ipairs(stored_values(widget)) do
                     assert.array(data_group).has.no.holes()
                     assert.is.equal(i ~= 15 and 0 or #data, #data_group)
                 end
@@ -220,14 +233,14 @@ describe("wibox.widget.graph", function()
                 -- Adding again to a different group
                 push_data(widget, data2, 30)
                 -- works
-                assert.is.same(data2, widget._private.values[30])
+                assert.is.same(data2, stored_values(widget)[30])
                 -- and doesn't affect the other group.
-                assert.is.same(data, widget._private.values[15])
+                assert.is.same(data, stored_values(widget)[15])
 
                 -- Smaller-index datagroups are present but empty.
-                assert.array(widget._private.values).has.no.holes()
-                assert.is.equal(30, #widget._private.values)
-                for i, data_group in ipairs(widget._private.values) do
+                assert.array(stored_values(widget)).has.no.holes()
+                assert.is.equal(30, #stored_values(widget))
+                for i, data_group in ipairs(stored_values(widget)) do
                     assert.array(data_group).has.no.holes()
                     if i ~= 15 and i ~= 30 then
                         assert.is.same({}, data_group)
@@ -248,7 +261,7 @@ describe("wibox.widget.graph", function()
                     end
                 end
 
-                assert.is.same({data, data2}, widget._private.values)
+                assert.is.same({data, data2}, stored_values(widget))
             end)
 
             it("doesn't work with non-natural datagroups", function()
@@ -288,9 +301,9 @@ describe("wibox.widget.graph", function()
                 -- but is not worth fixing. Adding an assert here
                 -- so that one would be reminded to change it to
                 -- a #values == 0 check, if one fixes it.
-                assert.is.equal(14, #widget._private.values)
-                assert.array(widget._private.values).has.no.holes()
-                for _, data_group in ipairs(widget._private.values) do
+                assert.is.equal(14, #stored_values(widget))
+                assert.array(stored_values(widget)).has.no.holes()
+                for _, data_group in ipairs(stored_values(widget)) do
                     assert.is.same({}, data_group)
                 end
             end)
@@ -310,7 +323,7 @@ describe("wibox.widget.graph", function()
                            {unpack(data, 1, expected_len)},
                            {unpack(data2, 1, expected_len)}
                         },
-                        widget._private.values
+                        stored_values(widget)
                     )
                 end
 
@@ -327,8 +340,8 @@ describe("wibox.widget.graph", function()
                 -- But setting the capacity property by itself doesn't do anything,
                 -- if add_value() wasn't called.
                 widget.capacity = 1
-                assert.is.equal(3, #widget._private.values[1])
-                assert.is.equal(3, #widget._private.values[2])
+                assert.is.equal(3, #stored_values(widget)[1])
+                assert.is.equal(3, #stored_values(widget)[2])
             end)
 
             it("stores up to 8192 values when no usage stats are available", function()
@@ -338,8 +351,8 @@ describe("wibox.widget.graph", function()
                     widget:add_value(i)
                     widget:add_value(i, 3)
                 end
-                assert.is.equal(8192, #widget._private.values[1])
-                assert.is.equal(8192, #widget._private.values[3])
+                assert.is.equal(8192, #stored_values(widget)[1])
+                assert.is.equal(8192, #stored_values(widget)[3])
             end)
 
             it("relies on usage stats, when capacity is unset", function()
@@ -352,8 +365,8 @@ describe("wibox.widget.graph", function()
                 end
 
                 -- The smallest multiple of 64 that is >= last_drawn_values_num + 64
-                assert.is.equal(192, #widget._private.values[1])
-                assert.is.equal(192, #widget._private.values[3])
+                assert.is.equal(192, #stored_values(widget)[1])
+                assert.is.equal(192, #stored_values(widget)[3])
 
                 -- so 192 elements will be kept with this too.
                 widget._private.last_drawn_values_num = 128
@@ -361,8 +374,8 @@ describe("wibox.widget.graph", function()
                 widget:add_value(0)
                 widget:add_value(0, 3)
 
-                assert.is.equal(192, #widget._private.values[1])
-                assert.is.equal(192, #widget._private.values[3])
+                assert.is.equal(192, #stored_values(widget)[1])
+                assert.is.equal(192, #stored_values(widget)[3])
 
                 -- But this is one is already one too many.
                 widget._private.last_drawn_values_num = 129
@@ -372,23 +385,41 @@ describe("wibox.widget.graph", function()
                     widget:add_value(i, 3)
                 end
 
-                assert.is.equal(256, #widget._private.values[1])
-                assert.is.equal(256, #widget._private.values[3])
+                assert.is.equal(256, #stored_values(widget)[1])
+                assert.is.equal(256, #stored_values(widget)[3])
 
                 -- Setting it back and calling add_value() once is enough
                 -- to purge overflowing elements,
                 widget._private.last_drawn_values_num = 128
                 widget:add_value(0)
-                assert.is.equal(192, #widget._private.values[1])
+                assert.is.equal(192, #stored_values(widget)[1])
                 -- but only in the group, for which add_value() happened to be
                 -- called during the time last_drawn_values_num was small enough,
                 -- even though it's probably not a very fair behavior and could
                 -- lead to weird visual artefacts.
-                assert.is.equal(256, #widget._private.values[3])
+                assert.is.equal(256, #stored_values(widget)[3])
 
                 -- Calling add_value for the other group puts it in line too.
                 widget:add_value(0, 3)
-                assert.is.equal(192, #widget._private.values[3])
+                assert.is.equal(192, #stored_values(widget)[3])
+            end)
+
+            it("keeps old values from piling up", function()
+                widget.capacity = 10
+                for i = 1, 5000 do
+                    widget:add_value(i)
+                end
+
+                -- The values are moved back to the start from time to time.
+                local ring = widget._private.values[1]
+                assert.is.equal(10, ring.last - ring.first + 1)
+                assert.is_true(ring.last < 300)
+
+                local expected = {}
+                for i = 5000, 4991, -1 do
+                    table.insert(expected, i)
+                end
+                assert.is.same({expected}, stored_values(widget))
             end)
 
 
@@ -397,15 +428,15 @@ describe("wibox.widget.graph", function()
         describe("method clear()", function()
             it("clears values", function()
                 local function check_clear(i)
-                    assert.is.same({}, widget._private.values)
+                    assert.is.same({}, stored_values(widget))
                     push_data(widget, data)
-                    assert.is.same({data}, widget._private.values)
+                    assert.is.same({data}, stored_values(widget))
                     widget:clear()
-                    assert.is.same({}, widget._private.values)
+                    assert.is.same({}, stored_values(widget))
                     push_data(widget, data2, 3*i)
-                    assert.is.same(data2, widget._private.values[3*i])
+                    assert.is.same(data2, stored_values(widget)[3*i])
                     widget:clear()
-                    assert.is.same({}, widget._private.values)
+                    assert.is.same({}, stored_values(widget))
                 end
 
                 for i = 1, 3 do
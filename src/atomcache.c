@@ -0,0 +1,271 @@
+/*
+ * atomcache.c - atom name cache
+ *
+ * Copyright © 2026 Abigail Teague <ateague063@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* Names and values of the atoms, in both directions.
+ *
+ * An atom is never freed by the server, so the cache never needs to be
+ * invalidated. It starts with the static atoms of atoms.list and grows with
+ * every atom looked up. The asynchronous functions send the requests for all
+ * the misses at once and handle their replies from the main loop.
+ */
+
+#include "atomcache.h"
+#include "common/atoms.h"
+#include "globalconf.h"
+#include "xreply.h"
+
+#include <glib.h>
+
+/** Names by atom, owning the names */
+static GHashTable *names = NULL;
+/** Atoms by name, sharing the names of the other table */
+static GHashTable *atoms = NULL;
+
+/** A batch of names being fetched */
+typedef struct {
+    size_t                     missing, resolved;
+    xcb_atom_t                *requested;
+    atomcache_names_callback_t callback;
+    void                      *data;
+} atomcache_fetch_t;
+
+/** An atom being interned */
+typedef struct {
+    char                     *name;
+    size_t                    len;
+    atomcache_atom_callback_t callback;
+    void                     *data;
+} atomcache_intern_t;
+
+/** Initialize the cache with the static atoms, once they are interned */
+void atomcache_init(void) {
+    names = g_hash_table_new_full(NULL, NULL, NULL, g_free);
+    atoms = g_hash_table_new(g_str_hash, g_str_equal);
+    atoms_foreach(atomcache_insert);
+}
+
+/** Get the name of an atom without asking the server.
+ * \param atom The atom.
+ * \return The name, or NULL if it is not cached yet.
+ */
+const char *atomcache_name(xcb_atom_t atom) {
+    return g_hash_table_lookup(names, GUINT_TO_POINTER(atom));
+}
+
+/** Get an atom by name without asking the server.
+ * \param name The name, not necessarily NUL-terminated.
+ * \param len The length of the name.
+ * \return The atom, or XCB_NONE if it is not cached yet.
+ */
+xcb_atom_t atomcache_atom(const char *name, size_t len) {
+    char    *key  = g_strndup(name, len);
+    gpointer atom = g_hash_table_lookup(atoms, key);
+    g_free(key);
+    return GPOINTER_TO_UINT(atom);
+}
+
+/** Remember the name of an atom.
+ * \param atom The atom.
+ * \param name The name, not necessarily NUL-terminated.
+ * \param len The length of the name.
+ */
+void atomcache_insert(xcb_atom_t atom, const char *name, size_t len) {
+    if (atom == XCB_NONE || g_hash_table_contains(names, GUINT_TO_POINTER(atom))) return;
+
+    char *copy = g_strndup(name, len);
+    g_hash_table_insert(names, GUINT_TO_POINTER(atom), copy);
+    g_hash_table_insert(atoms, copy, GUINT_TO_POINTER(atom));
+}
+
+static void atomcache_insert_reply(xcb_atom_t atom, xcb_get_atom_name_reply_t *reply) {
+    if (reply)
+        atomcache_insert(
+            atom, xcb_get_atom_name_name(reply), xcb_get_atom_name_name_length(reply));
+}
+
+/** Get the name of an atom, asking the server and waiting for it on a miss.
+ * \param atom The atom.
+ * \return The name, or NULL if the atom does not exist.
+ */
+const char *atomcache_get_name(xcb_atom_t atom) {
+    const char *name = atomcache_name(atom);
+
+    if (!name && atom != XCB_NONE) {
+        xcb_get_atom_name_reply_t *reply = xcb_get_atom_name_reply(
+            globalconf.connection, xcb_get_atom_name_unchecked(globalconf.connection, atom),
+            NULL);
+        atomcache_insert_reply(atom, reply);
+        p_delete(&reply);
+        name = atomcache_name(atom);
+    }
+
+    return name;
+}
+
+/** Intern an atom, asking the server and waiting for it on a miss.
+ * \param name The name, not necessarily NUL-terminated.
+ * \param len The length of the name.
+ * \return The atom, or XCB_NONE on error.
+ */
+xcb_atom_t atomcache_intern(const char *name, size_t len) {
+    xcb_atom_t atom;
+
+    atomcache_intern_many(1, &name, &len, &atom);
+    return atom;
+}
+
+/** Intern atoms, waiting for the misses in a single round trip.
+ * \param count The number of atoms.
+ * \param name_list The names.
+ * \param len_list The lengths of the names.
+ * \param atom_list Where to store the atoms, XCB_NONE on error.
+ */
+void atomcache_intern_many(
+    size_t             count,
+    const char *const *name_list,
+    const size_t      *len_list,
+    xcb_atom_t        *atom_list) {
+    xcb_intern_atom_cookie_t *cookies;
+
+    if (!count) return;
+
+    /* The count can come from a Lua table, so keep this off the stack */
+    cookies = p_new(xcb_intern_atom_cookie_t, count);
+
+    for (size_t i = 0; i < count; i++)
+        if ((atom_list[i] = atomcache_atom(name_list[i], len_list[i])) == XCB_NONE)
+            cookies[i] =
+                xcb_intern_atom_unchecked(globalconf.connection, false, len_list[i], name_list[i]);
+
+    for (size_t i = 0; i < count; i++) {
+        if (atom_list[i] != XCB_NONE) continue;
+
+        xcb_intern_atom_reply_t *reply =
+            xcb_intern_atom_reply(globalconf.connection, cookies[i], NULL);
+        if (reply) {
+            atom_list[i] = reply->atom;
+            atomcache_insert(reply->atom, name_list[i], len_list[i]);
+        }
+        p_delete(&reply);
+    }
+
+    p_delete(&cookies);
+}
+
+static void atomcache_fetch_cb(void *reply, xcb_generic_error_t *error, void *data) {
+    atomcache_fetch_t *fetch = data;
+
+    atomcache_insert_reply(fetch->requested[fetch->resolved++], reply);
+    if (fetch->resolved < fetch->missing) return;
+
+    fetch->callback(fetch->data);
+    p_delete(&fetch->requested);
+    p_delete(&fetch);
+}
+
+/** Make sure the names of atoms are cached.
+ *
+ * The names missing from the cache are requested at once. The function is
+ * only called if some are missing, once all the replies arrived. Atoms which
+ * do not exist stay missing.
+ *
+ * \param atom_list The atoms.
+ * \param count The number of atoms.
+ * \param callback The function to call.
+ * \param data Passed to the function.
+ * \return True if all the names are cached already and nothing was requested.
+ */
+bool atomcache_fetch_names(
+    const xcb_atom_t          *atom_list,
+    size_t                     count,
+    atomcache_names_callback_t callback,
+    void                      *data) {
+    atomcache_fetch_t *fetch = NULL;
+
+    for (size_t i = 0; i < count; i++) {
+        if (atom_list[i] == XCB_NONE || atomcache_name(atom_list[i])) continue;
+
+        if (!fetch) {
+            fetch            = p_new(atomcache_fetch_t, 1);
+            fetch->requested = p_new(xcb_atom_t, count);
+            fetch->callback  = callback;
+            fetch->data      = data;
+        }
+
+        /* Request each name only once */
+        bool requested = false;
+        for (size_t j = 0; j < fetch->missing && !requested; j++)
+            requested = fetch->requested[j] == atom_list[i];
+        if (requested) continue;
+
+        fetch->requested[fetch->missing++] = atom_list[i];
+        xreply_add(
+            xcb_get_atom_name(globalconf.connection, atom_list[i]).sequence, atomcache_fetch_cb,
+            fetch);
+    }
+
+    return fetch == NULL;
+}
+
+static void atomcache_intern_cb(void *reply, xcb_generic_error_t *error, void *data) {
+    atomcache_intern_t      *intern = data;
+    xcb_intern_atom_reply_t *atom_r = reply;
+    xcb_atom_t               atom   = atom_r ? atom_r->atom : XCB_NONE;
+
+    atomcache_insert(atom, intern->name, intern->len);
+    intern->callback(atom, intern->data);
+    p_delete(&intern->name);
+    p_delete(&intern);
+}
+
+/** Intern an atom without waiting.
+ *
+ * The function is called right away on a hit, from the main loop otherwise.
+ *
+ * \param name The name, not necessarily NUL-terminated.
+ * \param len The length of the name.
+ * \param callback The function to call with the atom, XCB_NONE on error.
+ * \param data Passed to the function.
+ */
+void atomcache_intern_async(
+    const char               *name,
+    size_t                    len,
+    atomcache_atom_callback_t callback,
+    void                     *data) {
+    xcb_atom_t atom = atomcache_atom(name, len);
+
+    if (atom != XCB_NONE) {
+        callback(atom, data);
+        return;
+    }
+
+    atomcache_intern_t *intern = p_new(atomcache_intern_t, 1);
+    intern->name               = p_dup(name, len);
+    intern->len                = len;
+    intern->callback           = callback;
+    intern->data               = data;
+
+    xreply_add(
+        xcb_intern_atom(globalconf.connection, false, len, name).sequence, atomcache_intern_cb,
+        intern);
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
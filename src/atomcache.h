@@ -0,0 +1,42 @@
+/*
+ * atomcache.h - atom name cache header
+ *
+ * Copyright © 2026 Abigail Teague <ateague063@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AWESOME_ATOMCACHE_H
+#define AWESOME_ATOMCACHE_H
+
+#include <stdbool.h>
+#include <xcb/xcb.h>
+
+typedef void (*atomcache_names_callback_t)(void *data);
+typedef void (*atomcache_atom_callback_t)(xcb_atom_t atom, void *data);
+
+void        atomcache_init(void);
+const char *atomcache_name(xcb_atom_t);
+xcb_atom_t  atomcache_atom(const char *, size_t);
+void        atomcache_insert(xcb_atom_t, const char *, size_t);
+const char *atomcache_get_name(xcb_atom_t);
+xcb_atom_t  atomcache_intern(const char *, size_t);
+void        atomcache_intern_many(size_t, const char *const *, const size_t *, xcb_atom_t *);
+bool        atomcache_fetch_names(const xcb_atom_t *, size_t, atomcache_names_callback_t, void *);
+void        atomcache_intern_async(const char *, size_t, atomcache_atom_callback_t, void *);
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -22,6 +22,7 @@
 
 #include "awesome.h"
 
+#include "atomcache.h"
 #include "banning.h"
 #include "common/atoms.h"
 #include "common/backtrace.h"
@@ -31,6 +32,7 @@
 #include "common/xutil.h"
 #include "dbus.h"
 #include "event.h"
+#include "eventlog.h"
 #include "ewmh.h"
 #include "globalconf.h"
 #include "objects/client.h"
@@ -39,6 +41,8 @@
 #include "spawn.h"
 #include "systray.h"
 #include "xkb.h"
+#include "xrdb.h"
+#include "xreply.h"
 #include "xwindow.h"
 
 #include <getopt.h>
@@ -131,6 +135,8 @@ void awesome_atexit(bool restart) {
 
     a_dbus_cleanup();
 
+    eventlog_cleanup();
+
     systray_cleanup();
 
     /* Close Lua */
@@ -390,6 +396,8 @@ static void a_xcb_check(void) {
         event_handle(mouse);
         p_delete(&mouse);
     }
+
+    xreply_poll();
 }
 
 static gboolean a_xcb_io_cb(GIOChannel *source, GIOCondition cond, gpointer data) {
@@ -411,7 +419,11 @@ static gint a_glib_poll(GPollFD *ufds, guint nfsd, gint timeout) {
     lua_State     *L = globalconf_get_lua_State();
 
     /* Do all deferred work now */
-    awesome_refresh();
+    if (globalconf.eventlog_replaying) {
+        gint64 start = g_get_monotonic_time();
+        awesome_refresh();
+        eventlog_measure(EVENTLOG_CATEGORY_REFRESH, start);
+    } else awesome_refresh();
 
     /* Check if the Lua stack is the way it should be */
     if (lua_gettop(L) != 0) {
@@ -425,6 +437,9 @@ static gint a_glib_poll(GPollFD *ufds, guint nfsd, gint timeout) {
     globalconf.pending_event = xcb_poll_for_event(globalconf.connection);
     if (globalconf.pending_event != NULL) timeout = 0;
 
+    /* Reading the events may have read replies too, which would not wake us up */
+    if (xreply_poll() > 0) timeout = 0;
+
     /* Check how long this main loop iteration took */
     gettimeofday(&now, NULL);
     timersub(&now, &last_wakeup, &length_time);
@@ -470,6 +485,7 @@ static gboolean reap_children(GIOChannel *channel, GIOCondition condition, gpoin
     if (result < 0) fatal("Error reading from signal pipe: %s", strerror(errno));
 
     while ((child = waitpid(-1, &status, WNOHANG)) > 0) {
+        if (globalconf.eventlog_recording) eventlog_record_child_exit(child, status);
         spawn_child_exited(child, status);
     }
     if (child < 0 && errno != ECHILD) warn("waitpid(-1) failed: %s", strerror(errno));
@@ -656,9 +672,7 @@ int main(int argc, char **argv) {
     if (xcb_cursor_context_new(globalconf.connection, globalconf.screen, &globalconf.cursor_ctx) <
         0)
         fatal("Failed to initialize xcb-cursor");
-    globalconf.xrmdb = xcb_xrm_database_from_default(globalconf.connection);
-    if (globalconf.xrmdb == NULL) globalconf.xrmdb = xcb_xrm_database_from_string("");
-    if (globalconf.xrmdb == NULL) fatal("Failed to initialize xcb-xrm");
+    xrdb_init();
 
     /* Did we get some usable data from the above X11 setup? */
     draw_test_cairo_xcb();
@@ -718,11 +732,15 @@ int main(int argc, char **argv) {
 
     event_init();
 
+    /* open the event log, if any, before we start receiving events */
+    eventlog_init();
+
     /* Allocate the key symbols */
     globalconf.keysyms = xcb_key_symbols_alloc(globalconf.connection);
 
     /* init atom cache */
     atoms_init(globalconf.connection);
+    atomcache_init();
 
     ewmh_init();
     systray_init();
@@ -812,6 +830,8 @@ int main(int argc, char **argv) {
 
     luaA_emit_startup();
 
+    eventlog_start();
+
     /* Setup the main context */
     g_main_context_set_poll_func(g_main_context_default(), &a_glib_poll);
     gettimeofday(&last_wakeup, NULL);
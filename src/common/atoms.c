@@ -57,4 +57,15 @@ atoms_init(xcb_connection_t *conn)
     }
 }
 
+/** Call a function with each static atom.
+ * \param callback The function, called with the atom, its name and the length
+ * of its name.
+ */
+void
+atoms_foreach(void (*callback)(xcb_atom_t, const char *, size_t))
+{
+    for(unsigned int i = 0; i < countof(ATOM_LIST); i++)
+        callback(*ATOM_LIST[i].atom, ATOM_LIST[i].name, ATOM_LIST[i].len);
+}
+
 // vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
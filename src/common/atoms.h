@@ -27,6 +27,7 @@
 #include "common/atoms-extern.h"
 
 void atoms_init(xcb_connection_t *);
+void atoms_foreach(void (*)(xcb_atom_t, const char *, size_t));
 
 #endif
 // vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -25,7 +25,7 @@
 #include "common/atoms.h"
 
 /* I should really include the correct header instead... */
-void luaA_systray_invalidate(void);
+void systray_embed_update(xembed_window_t *, bool);
 
 /** Send an XEMBED message to a window.
  * \param connection Connection to the X server.
@@ -124,6 +124,7 @@ xembed_property_update(xcb_connection_t *connection, xembed_window_t *emwin,
                        xcb_timestamp_t timestamp, xcb_get_property_reply_t *reply)
 {
     int flags_changed;
+    bool was_mapped = emwin->info.flags & XEMBED_MAPPED;
     xembed_info_t info = { 0, 0 };
 
     xembed_info_from_reply(&info, reply);
@@ -135,6 +136,7 @@ xembed_property_update(xcb_connection_t *connection, xembed_window_t *emwin,
     emwin->info.flags = info.flags;
     if(flags_changed & XEMBED_MAPPED)
     {
+        emwin->mapped = info.flags & XEMBED_MAPPED;
         if(info.flags & XEMBED_MAPPED)
         {
             xcb_map_window(connection, emwin->win);
@@ -146,7 +148,7 @@ xembed_property_update(xcb_connection_t *connection, xembed_window_t *emwin,
             xembed_window_deactivate(connection, emwin->win, timestamp);
             xembed_focus_out(connection, emwin->win, timestamp);
         }
-        luaA_systray_invalidate();
+        systray_embed_update(emwin, was_mapped);
     }
 }
 
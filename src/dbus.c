@@ -45,25 +45,39 @@
 #include <unistd.h>
 
 #include "event.h"
+#include "eventlog.h"
 #include "luaa.h"
 
 #define LUNA_DBUS_SIGNALS "lunaria.signals.dbus"
+#define LUNA_DBUS_LAZY    "lunaria.signals.dbus.lazy"
+#define LUNA_DBUS_MESSAGE "dbus.message"
 
 static DBusConnection *dbus_connection_session = NULL;
 static DBusConnection *dbus_connection_system  = NULL;
 static GSource        *session_source          = NULL;
 static GSource        *system_source           = NULL;
+static guint           session_idle            = 0;
+static guint           system_idle             = 0;
+
+/** The number of messages processed in one main loop iteration. A burst of
+ * messages is spread over several iterations instead of delaying the X events.
+ */
+#define DBUS_MESSAGE_BUDGET 32
 
 /** Clean up the D-Bus connection data members
  * \param dbus_connection The D-Bus connection to clean up
  * \param source The D-Bus source
+ * \param idle The idle source processing the remaining messages, or NULL
  */
-static void a_dbus_cleanup_bus(DBusConnection *dbus_connection, GSource **source) {
+static void a_dbus_cleanup_bus(DBusConnection *dbus_connection, GSource **source, guint *idle) {
     if (!dbus_connection) return;
 
     if (*source != NULL) g_source_destroy(*source);
     *source = NULL;
 
+    if (idle && *idle) g_source_remove(*idle);
+    if (idle) *idle = 0;
+
     /* This is a shared connection owned by libdbus
      * Do not close it, only unref
      */
@@ -81,174 +95,206 @@ static void a_dbus_cleanup_bus(DBusConnection *dbus_connection, GSource **source
         }                                                                \
     } break;
 
-#define DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(type, dbustype, pusher) \
-    case dbustype: {                                               \
-        type ui;                                                   \
-        dbus_message_iter_get_basic(iter, &ui);                    \
-        pusher(L, ui);                                             \
-    }                                                              \
-        nargs++;                                                   \
-        break;
+/** Push a value of a basic D-Bus type, or nil for the unsupported ones.
+ * \param L The Lua VM state.
+ * \param iter The D-Bus message iterator, on a basic value.
+ * \param type The type of the value.
+ */
+static void a_dbus_push_basic(lua_State *L, DBusMessageIter *iter, int type) {
+    DBusBasicValue value;
+
+    /* Getting a file descriptor dup()s it, and it is not supported anyway */
+    if (type == DBUS_TYPE_UNIX_FD) {
+        lua_pushnil(L);
+        return;
+    }
+
+    dbus_message_iter_get_basic(iter, &value);
+
+    switch (type) {
+        case DBUS_TYPE_BOOLEAN:
+            lua_pushboolean(L, value.bool_val);
+            break;
+        case DBUS_TYPE_BYTE:
+            lua_pushlstring(L, (const char *) &value.byt, 1);
+            break;
+        case DBUS_TYPE_INT16:
+            lua_pushinteger(L, value.i16);
+            break;
+        case DBUS_TYPE_UINT16:
+            lua_pushinteger(L, value.u16);
+            break;
+        case DBUS_TYPE_INT32:
+            lua_pushinteger(L, value.i32);
+            break;
+        case DBUS_TYPE_UINT32:
+            lua_pushinteger(L, value.u32);
+            break;
+        case DBUS_TYPE_INT64:
+            lua_pushinteger(L, value.i64);
+            break;
+        case DBUS_TYPE_UINT64:
+            lua_pushinteger(L, value.u64);
+            break;
+        case DBUS_TYPE_DOUBLE:
+            lua_pushnumber(L, value.dbl);
+            break;
+        case DBUS_TYPE_STRING:
+            lua_pushstring(L, value.str);
+            break;
+        default:
+            lua_pushnil(L);
+            break;
+    }
+}
 
-/** Iterate through the D-Bus messages counting each or traverse each sub message.
+/** Push the value a D-Bus message iterator is on.
+ *
+ * Containers are filled in place, element after element, so that the stack
+ * only grows with the nesting depth and not with the size of the arrays.
+ *
  * \param L The Lua VM state.
- * \param iter The D-Bus message iterator pointer
- * \return The number of arguments in the iterator
+ * \param iter The D-Bus message iterator pointer.
  */
-static int a_dbus_message_iter(lua_State *L, DBusMessageIter *iter) {
-    int nargs = 0;
-
-    do {
-        switch (dbus_message_iter_get_arg_type(iter)) {
-            default:
-                lua_pushnil(L);
-                nargs++;
-                break;
-            case DBUS_TYPE_INVALID:
-                break;
-            case DBUS_TYPE_VARIANT: {
-                DBusMessageIter subiter;
-                dbus_message_iter_recurse(iter, &subiter);
-                a_dbus_message_iter(L, &subiter);
-            }
-                nargs++;
-                break;
-            case DBUS_TYPE_DICT_ENTRY: {
-                DBusMessageIter subiter;
-
-                /* initialize a sub iterator */
-                dbus_message_iter_recurse(iter, &subiter);
-                /* create a new table to store the dict */
-                a_dbus_message_iter(L, &subiter);
-            }
-                nargs++;
-                break;
-            case DBUS_TYPE_STRUCT: {
-                DBusMessageIter subiter;
-                /* initialize a sub iterator */
-                dbus_message_iter_recurse(iter, &subiter);
-
-                int n = a_dbus_message_iter(L, &subiter);
-
-                /* create a new table to store all the value */
-                lua_createtable(L, n, 0);
-                /* move the table before array elements */
-                lua_insert(L, -n - 1);
-
-                for (int i = n; i > 0; i--)
-                    lua_rawseti(L, -i - 1, i);
+static void a_dbus_message_iter_value(lua_State *L, DBusMessageIter *iter) {
+    int             type = dbus_message_iter_get_arg_type(iter);
+    DBusMessageIter sub;
+
+    /* The D-Bus specification limits the nesting to 64 containers */
+    luaL_checkstack(L, 3, "D-Bus message nested too deeply");
+
+    if (dbus_type_is_basic(type)) {
+        a_dbus_push_basic(L, iter, type);
+        return;
+    }
+
+    switch (type) {
+        case DBUS_TYPE_VARIANT:
+            dbus_message_iter_recurse(iter, &sub);
+            a_dbus_message_iter_value(L, &sub);
+            break;
+        case DBUS_TYPE_STRUCT:
+            dbus_message_iter_recurse(iter, &sub);
+            lua_newtable(L);
+            for (int i = 1; dbus_message_iter_get_arg_type(&sub) != DBUS_TYPE_INVALID; i++) {
+                a_dbus_message_iter_value(L, &sub);
+                lua_rawseti(L, -2, i);
+                dbus_message_iter_next(&sub);
             }
-                nargs++;
-                break;
-            case DBUS_TYPE_ARRAY: {
-                int array_type = dbus_message_iter_get_element_type(iter);
-
-                if (dbus_type_is_fixed(array_type)) {
-                    DBusMessageIter sub;
-                    dbus_message_iter_recurse(iter, &sub);
-
-                    switch (array_type) {
-                        int datalen;
-                        DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(
-                            int16_t, DBUS_TYPE_INT16, lua_pushinteger)
-                        DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(
-                            uint16_t, DBUS_TYPE_UINT16, lua_pushinteger)
-                        DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(
-                            int32_t, DBUS_TYPE_INT32, lua_pushinteger)
-                        DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(
-                            uint32_t, DBUS_TYPE_UINT32, lua_pushinteger)
-                        DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(
-                            int64_t, DBUS_TYPE_INT64, lua_pushinteger)
-                        DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(
-                            uint64_t, DBUS_TYPE_UINT64, lua_pushinteger)
-                        DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(
-                            double, DBUS_TYPE_DOUBLE, lua_pushnumber)
-                        case DBUS_TYPE_BYTE: {
-                            const char *c;
-                            dbus_message_iter_get_fixed_array(&sub, &c, &datalen);
-                            lua_pushlstring(L, c, datalen);
-                        } break;
-                        case DBUS_TYPE_BOOLEAN: {
-                            const dbus_bool_t *b;
-                            dbus_message_iter_get_fixed_array(&sub, &b, &datalen);
-                            lua_createtable(L, datalen, 0);
-                            for (int i = 0; i < datalen; i++) {
-                                lua_pushboolean(L, b[i]);
-                                lua_rawseti(L, -2, i + 1);
-                            }
-                        } break;
-                    }
-                } else if (array_type == DBUS_TYPE_DICT_ENTRY) {
-                    DBusMessageIter subiter;
-                    /* initialize a sub iterator */
-                    dbus_message_iter_recurse(iter, &subiter);
-
-                    /* get the keys and the values
-                     * n is the number of entry in dict */
-                    int n = a_dbus_message_iter(L, &subiter);
-
-                    /* create a new table to store all the value */
-                    lua_createtable(L, n, 0);
-                    /* move the table before array elements */
-                    lua_insert(L, -(n * 2) - 1);
-
-                    for (int i = 0; i < n; i++)
-                        lua_rawset(L, -(n * 2) - 1 + i * 2);
-                } else {
-                    DBusMessageIter subiter;
-                    /* prepare to dig into the array*/
-                    dbus_message_iter_recurse(iter, &subiter);
-
-                    /* now iterate over every element of the array */
-                    int n = a_dbus_message_iter(L, &subiter);
-
-                    /* create a new table to store all the value */
-                    lua_createtable(L, n, 0);
-                    /* move the table before array elements */
-                    lua_insert(L, -n - 1);
-
-                    for (int i = n; i > 0; i--)
-                        lua_rawseti(L, -i - 1, i);
+            break;
+        case DBUS_TYPE_ARRAY: {
+            int array_type = dbus_message_iter_get_element_type(iter);
+
+            dbus_message_iter_recurse(iter, &sub);
+
+            if (dbus_type_is_fixed(array_type)) {
+                switch (array_type) {
+                    int datalen;
+                    DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(
+                        int16_t, DBUS_TYPE_INT16, lua_pushinteger)
+                    DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(
+                        uint16_t, DBUS_TYPE_UINT16, lua_pushinteger)
+                    DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(
+                        int32_t, DBUS_TYPE_INT32, lua_pushinteger)
+                    DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(
+                        uint32_t, DBUS_TYPE_UINT32, lua_pushinteger)
+                    DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(
+                        int64_t, DBUS_TYPE_INT64, lua_pushinteger)
+                    DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(
+                        uint64_t, DBUS_TYPE_UINT64, lua_pushinteger)
+                    DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(
+                        double, DBUS_TYPE_DOUBLE, lua_pushnumber)
+                    case DBUS_TYPE_BYTE: {
+                        const char *c;
+                        dbus_message_iter_get_fixed_array(&sub, &c, &datalen);
+                        lua_pushlstring(L, c, datalen);
+                    } break;
+                    case DBUS_TYPE_BOOLEAN: {
+                        const dbus_bool_t *b;
+                        dbus_message_iter_get_fixed_array(&sub, &b, &datalen);
+                        lua_createtable(L, datalen, 0);
+                        for (int i = 0; i < datalen; i++) {
+                            lua_pushboolean(L, b[i]);
+                            lua_rawseti(L, -2, i + 1);
+                        }
+                    } break;
+                    default:
+                        lua_pushnil(L);
+                        break;
                 }
-            }
-                nargs++;
-                break;
-            case DBUS_TYPE_BOOLEAN: {
-                dbus_bool_t b;
-                dbus_message_iter_get_basic(iter, &b);
-                lua_pushboolean(L, b);
-            }
-                nargs++;
-                break;
-            case DBUS_TYPE_BYTE: {
-                char c;
-                dbus_message_iter_get_basic(iter, &c);
-                lua_pushlstring(L, &c, 1);
-            }
-                nargs++;
-                break;
-                DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(int16_t, DBUS_TYPE_INT16, lua_pushinteger)
-                DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(uint16_t, DBUS_TYPE_UINT16, lua_pushinteger)
-                DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(int32_t, DBUS_TYPE_INT32, lua_pushinteger)
-                DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(uint32_t, DBUS_TYPE_UINT32, lua_pushinteger)
-                DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(int64_t, DBUS_TYPE_INT64, lua_pushinteger)
-                DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(uint64_t, DBUS_TYPE_UINT64, lua_pushinteger)
-                DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(double, DBUS_TYPE_DOUBLE, lua_pushnumber)
-            case DBUS_TYPE_STRING: {
-                char *s;
-                dbus_message_iter_get_basic(iter, &s);
-                lua_pushstring(L, s);
-            }
-                nargs++;
-                break;
-        }
-    } while (dbus_message_iter_next(iter));
+            } else if (array_type == DBUS_TYPE_DICT_ENTRY) {
+                /* a{sv} and friends, the most common container */
+                lua_newtable(L);
+                while (dbus_message_iter_get_arg_type(&sub) != DBUS_TYPE_INVALID) {
+                    DBusMessageIter entry;
 
-    return nargs;
+                    dbus_message_iter_recurse(&sub, &entry);
+                    a_dbus_message_iter_value(L, &entry);
+                    dbus_message_iter_next(&entry);
+                    a_dbus_message_iter_value(L, &entry);
+
+                    if (lua_isnil(L, -2)) lua_pop(L, 2);
+                    else lua_rawset(L, -3);
+
+                    dbus_message_iter_next(&sub);
+                }
+            } else if (array_type == DBUS_TYPE_STRING) {
+                /* as, no need to go through the generic path for each element */
+                lua_newtable(L);
+                for (int i = 1; dbus_message_iter_get_arg_type(&sub) != DBUS_TYPE_INVALID; i++) {
+                    const char *s;
+
+                    dbus_message_iter_get_basic(&sub, &s);
+                    lua_pushstring(L, s);
+                    lua_rawseti(L, -2, i);
+                    dbus_message_iter_next(&sub);
+                }
+            } else {
+                lua_newtable(L);
+                for (int i = 1; dbus_message_iter_get_arg_type(&sub) != DBUS_TYPE_INVALID; i++) {
+                    a_dbus_message_iter_value(L, &sub);
+                    lua_rawseti(L, -2, i);
+                    dbus_message_iter_next(&sub);
+                }
+            }
+        } break;
+        default:
+            lua_pushnil(L);
+            break;
+    }
 }
 
 #undef DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT
-#undef DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT
+
+/** Push the arguments of a D-Bus message.
+ *
+ * Messages made of basic types only, the usual case for signals, are decoded
+ * with a flat loop.
+ *
+ * \param L The Lua VM state.
+ * \param msg The D-Bus message.
+ * \return The number of arguments pushed.
+ */
+static int a_dbus_message_iter(lua_State *L, DBusMessage *msg) {
+    DBusMessageIter iter;
+    int             nargs = 0;
+    int             type;
+
+    if (!dbus_message_iter_init(msg, &iter)) return 0;
+
+    while ((type = dbus_message_iter_get_arg_type(&iter)) != DBUS_TYPE_INVALID) {
+        /* Drop the extra arguments rather than overflowing the stack */
+        if (!lua_checkstack(L, 1)) break;
+
+        if (dbus_type_is_basic(type)) a_dbus_push_basic(L, &iter, type);
+        else a_dbus_message_iter_value(L, &iter);
+
+        nargs++;
+        dbus_message_iter_next(&iter);
+    }
+
+    return nargs;
+}
 
 #define DBUS_MSG_RETURN_HANDLE_TYPE_NUMBER(type, dbustype)    \
     case dbustype: {                                          \
@@ -318,14 +364,105 @@ static bool a_dbus_convert_value(lua_State *L, int idx, DBusMessageIter *iter) {
 
 #undef DBUS_MSG_RETURN_HANDLE_TYPE_NUMBER
 
+/** A D-Bus message given to the handlers connected with `lazy`, decoding its
+ * arguments only when asked to.
+ */
+typedef struct {
+    DBusMessage *msg;
+} dbus_message_handle_t;
+
+static dbus_message_handle_t *luaA_dbus_checkmessage(lua_State *L, int idx) {
+    return luaL_checkudata(L, idx, LUNA_DBUS_MESSAGE);
+}
+
+/** Get all the arguments of the message.
+ * @return The arguments, decoded as for the non-lazy handlers.
+ * @method args
+ */
+static int luaA_dbus_message_args(lua_State *L) {
+    dbus_message_handle_t *handle = luaA_dbus_checkmessage(L, 1);
+
+    return a_dbus_message_iter(L, handle->msg);
+}
+
+/** Get one argument of the message, without decoding the previous ones.
+ * @tparam integer n The index of the argument, starting at 1.
+ * @return The argument, or nil.
+ * @method arg
+ */
+static int luaA_dbus_message_arg(lua_State *L) {
+    dbus_message_handle_t *handle = luaA_dbus_checkmessage(L, 1);
+    lua_Integer            n      = luaL_checkinteger(L, 2);
+    DBusMessageIter        iter;
+
+    if (n < 1 || !dbus_message_iter_init(handle->msg, &iter)) return 0;
+
+    while (--n > 0)
+        if (!dbus_message_iter_next(&iter)) return 0;
+
+    if (dbus_message_iter_get_arg_type(&iter) == DBUS_TYPE_INVALID) return 0;
+
+    a_dbus_message_iter_value(L, &iter);
+    return 1;
+}
+
+/** Get the D-Bus signature of the arguments.
+ * @treturn string The signature, such as `"susssasa{sv}i"`.
+ * @method signature
+ */
+static int luaA_dbus_message_signature(lua_State *L) {
+    dbus_message_handle_t *handle = luaA_dbus_checkmessage(L, 1);
+
+    lua_pushstring(L, dbus_message_get_signature(handle->msg));
+    return 1;
+}
+
+static int luaA_dbus_message_gc(lua_State *L) {
+    dbus_message_handle_t *handle = luaA_dbus_checkmessage(L, 1);
+
+    if (handle->msg) dbus_message_unref(handle->msg);
+    handle->msg = NULL;
+    return 0;
+}
+
+/** Push a handle on a D-Bus message.
+ * \param L The Lua VM state.
+ * \param msg The message, referenced until the handle is collected.
+ */
+static void luaA_dbus_pushmessage(lua_State *L, DBusMessage *msg) {
+    dbus_message_handle_t *handle = lua_newuserdatauv(L, sizeof(*handle), 0);
+
+    handle->msg = dbus_message_ref(msg);
+    luaL_setmetatable(L, LUNA_DBUS_MESSAGE);
+}
+
 /** Process a single request from D-Bus
- * \param dbus_connection  The connection to the D-Bus server.
+ * \param dbus_connection  The connection to the D-Bus server, or NULL when
+ * replaying a recorded message, in which case no reply is sent.
+ * \param system Whether the message came from the system bus.
  * \param msg The D-Bus message request being sent to the D-Bus connection.
  */
-static void a_dbus_process_request(DBusConnection *dbus_connection, DBusMessage *msg) {
+static void
+a_dbus_process_request(DBusConnection *dbus_connection, bool system, DBusMessage *msg) {
     const char *interface = dbus_message_get_interface(msg);
     lua_State  *L         = globalconf_get_lua_State();
     int         old_top   = lua_gettop(L);
+    int         nargs     = 1;
+
+    /* Look the handler up first, nothing is decoded for the messages nobody
+     * listens to */
+    luaL_getsubtable(L, LUA_REGISTRYINDEX, LUNA_DBUS_SIGNALS);
+    lua_pushstring(L, NONULL(interface));
+    if (lua_rawget(L, -2) == LUA_TNIL) {
+        lua_settop(L, old_top);
+        return;
+    }
+    lua_remove(L, -2);
+
+    luaL_getsubtable(L, LUA_REGISTRYINDEX, LUNA_DBUS_LAZY);
+    lua_pushstring(L, NONULL(interface));
+    bool lazy = lua_rawget(L, -2) != LUA_TNIL;
+    lua_pop(L, 2);
 
     lua_createtable(L, 0, 5);
 
@@ -366,31 +503,26 @@ static void a_dbus_process_request(DBusConnection *dbus_connection, DBusMessage
         lua_setfield(L, -2, "sender");
     }
 
-    if (dbus_connection == dbus_connection_system) lua_pushliteral(L, "system");
+    if (system) lua_pushliteral(L, "system");
     else lua_pushliteral(L, "session");
     lua_setfield(L, -2, "bus");
 
-    /* + 1 for the table above */
-    DBusMessageIter iter;
-    int             nargs = 1;
-
-    if (dbus_message_iter_init(msg, &iter)) nargs += a_dbus_message_iter(L, &iter);
+    if (lazy) {
+        luaA_dbus_pushmessage(L, msg);
+        nargs++;
+    } else nargs += a_dbus_message_iter(L, msg);
 
-    luaL_getsubtable(L, LUA_REGISTRYINDEX, LUNA_DBUS_SIGNALS);
-    lua_pushstring(L, NONULL(interface));
-    if (lua_rawget(L, -2) == LUA_TNIL) {
-        lua_settop(L, old_top);
-        return;
-    }
-    lua_remove(L, -2);
+    /* Move the handler above its arguments */
+    lua_rotate(L, old_top + 1, -1);
 
-    if (dbus_message_get_no_reply(msg)) luaA_dofunction(L, nargs, 0);
+    if (dbus_connection == NULL || dbus_message_get_no_reply(msg)) luaA_dofunction(L, nargs, 0);
     else {
         int n = lua_gettop(L) - nargs - 1;
         luaA_dofunction(L, nargs, LUA_MULTRET);
         n -= lua_gettop(L);
 
-        DBusMessage *reply = dbus_message_new_method_return(msg);
+        DBusMessageIter iter;
+        DBusMessage    *reply = dbus_message_new_method_return(msg);
         dbus_message_iter_init_append(reply, &iter);
 
         if (n % 2 != 0) {
@@ -421,24 +553,41 @@ static void a_dbus_process_request(DBusConnection *dbus_connection, DBusMessage
     lua_settop(L, old_top);
 }
 
-/** Attempt to process all the requests in the D-Bus connection.
+static gboolean a_dbus_process_remaining(gpointer data);
+
+/** Process the requests in the D-Bus connection, at most DBUS_MESSAGE_BUDGET
+ * of them. The rest is processed from an idle source.
  * \param dbus_connection The D-Bus connection to process from
  * \param source The D-Bus source
+ * \param idle The idle source processing the remaining messages
  */
-static void a_dbus_process_requests_on_bus(DBusConnection *dbus_connection, GSource **source) {
+static void
+a_dbus_process_requests_on_bus(DBusConnection *dbus_connection, GSource **source, guint *idle) {
     DBusMessage *msg;
-    int          nmsg = 0;
+    int          nmsg   = 0;
+    bool         system = dbus_connection == dbus_connection_system;
 
-    while (true) {
+    while (nmsg < DBUS_MESSAGE_BUDGET) {
         dbus_connection_read_write(dbus_connection, 0);
 
         if (!(msg = dbus_connection_pop_message(dbus_connection))) break;
 
         if (dbus_message_is_signal(msg, DBUS_INTERFACE_LOCAL, "Disconnected")) {
-            a_dbus_cleanup_bus(dbus_connection, source);
+            a_dbus_cleanup_bus(dbus_connection, source, idle);
             dbus_message_unref(msg);
             return;
-        } else a_dbus_process_request(dbus_connection, msg);
+        }
+
+        if (globalconf.eventlog_recording) {
+            char *data;
+            int   len;
+            if (dbus_message_marshal(msg, &data, &len)) {
+                eventlog_record_dbus(system, data, len);
+                dbus_free(data);
+            }
+        }
+
+        a_dbus_process_request(dbus_connection, system, msg);
 
         dbus_message_unref(msg);
 
@@ -446,18 +595,48 @@ static void a_dbus_process_requests_on_bus(DBusConnection *dbus_connection, GSou
     }
 
     if (nmsg) dbus_connection_flush(dbus_connection);
+
+    /* The messages libdbus already read from the socket do not wake the watch
+     * up again */
+    if (nmsg == DBUS_MESSAGE_BUDGET && *idle == 0
+        && dbus_connection_get_dispatch_status(dbus_connection) == DBUS_DISPATCH_DATA_REMAINS)
+        *idle = g_idle_add(a_dbus_process_remaining, GINT_TO_POINTER(system));
+}
+
+/** Process a message from an event log as if it had arrived on a bus.
+ * \param system Whether the message was received on the system bus.
+ * \param data The marshalled message.
+ * \param len The length of the marshalled message.
+ */
+void a_dbus_replay_message(bool system, const char *data, int len) {
+    DBusMessage *msg = dbus_message_demarshal(data, len, NULL);
+
+    if (msg == NULL) return;
+    a_dbus_process_request(NULL, system, msg);
+    dbus_message_unref(msg);
 }
 
 static gboolean a_dbus_process_requests_session(gpointer data) {
-    a_dbus_process_requests_on_bus(dbus_connection_session, &session_source);
+    a_dbus_process_requests_on_bus(dbus_connection_session, &session_source, &session_idle);
     return TRUE;
 }
 
 static gboolean a_dbus_process_requests_system(gpointer data) {
-    a_dbus_process_requests_on_bus(dbus_connection_system, &system_source);
+    a_dbus_process_requests_on_bus(dbus_connection_system, &system_source, &system_idle);
     return TRUE;
 }
 
+static gboolean a_dbus_process_remaining(gpointer data) {
+    if (GPOINTER_TO_INT(data)) {
+        system_idle = 0;
+        a_dbus_process_requests_system(NULL);
+    } else {
+        session_idle = 0;
+        a_dbus_process_requests_session(NULL);
+    }
+    return G_SOURCE_REMOVE;
+}
+
 /** Attempt to request a D-Bus name.
  * \param dbus_connection The application's connection to D-Bus.
  * \param name The D-Bus connection name to be requested.
@@ -553,7 +732,7 @@ a_dbus_connect(DBusBusType type, const char *type_name, GSourceFunc cb, GSource
             fcntl(fd, F_SETFD, FD_CLOEXEC);
         } else {
             warn("cannot get D-Bus connection file descriptor");
-            a_dbus_cleanup_bus(dbus_connection, source);
+            a_dbus_cleanup_bus(dbus_connection, source, NULL);
         }
     }
 
@@ -572,8 +751,8 @@ void a_dbus_init(void) {
 /** Cleanup the D-Bus session and system
  */
 void a_dbus_cleanup(void) {
-    a_dbus_cleanup_bus(dbus_connection_session, &session_source);
-    a_dbus_cleanup_bus(dbus_connection_system, &system_source);
+    a_dbus_cleanup_bus(dbus_connection_session, &session_source, &session_idle);
+    a_dbus_cleanup_bus(dbus_connection_system, &system_source, &system_idle);
 }
 
 /** Retrieve the D-Bus bus by its name.
@@ -657,9 +836,17 @@ static int luaA_dbus_remove_match(lua_State *L) {
 }
 
 /** Add a signal receiver on the D-Bus.
+ *
+ * The function is called with a table describing the message, with the
+ * `type`, `interface`, `path`, `member`, `sender` and `bus` keys, followed by
+ * the arguments. With `lazy`, it is called with the table and a message
+ * object instead, whose `args`, `arg` and `signature` methods decode the
+ * arguments on demand. This is cheaper when only some of them are used.
  *
  * @param interface A string with the interface name.
  * @param func The function to call.
+ * @tparam[opt=false] boolean lazy Whether to give a message object to the
+ * function instead of the decoded arguments.
  * @return true on success, nil + error if the signal could not be connected
  * because another function is already connected.
  * @function connect_signal
@@ -667,6 +854,8 @@ static int luaA_dbus_remove_match(lua_State *L) {
 static int luaA_dbus_connect_signal(lua_State *L) {
     const char *name = luaL_checkstring(L, 1);
     luaA_checkfunction(L, 2);
+    bool lazy = lua_toboolean(L, 3);
+    lua_settop(L, 2);
     luaL_getsubtable(L, LUA_REGISTRYINDEX, LUNA_DBUS_SIGNALS);
     lua_insert(L, 1);
     lua_pushvalue(L, 1);
@@ -678,6 +867,13 @@ static int luaA_dbus_connect_signal(lua_State *L) {
     } else {
         lua_pop(L, 1);
         lua_rawset(L, 1);
+
+        luaL_getsubtable(L, LUA_REGISTRYINDEX, LUNA_DBUS_LAZY);
+        lua_pushstring(L, name);
+        if (lazy) lua_pushboolean(L, 1);
+        else lua_pushnil(L);
+        lua_rawset(L, -3);
+
         lua_pushboolean(L, 1);
         return 1;
     }
@@ -695,6 +891,10 @@ static int luaA_dbus_disconnect_signal(lua_State *L) {
     lua_pushvalue(L, 1);
     lua_pushnil(L);
     lua_rawset(L, -3);
+    luaL_getsubtable(L, LUA_REGISTRYINDEX, LUNA_DBUS_LAZY);
+    lua_pushvalue(L, 1);
+    lua_pushnil(L);
+    lua_rawset(L, -3);
     return 0;
 }
 
@@ -767,6 +967,20 @@ void luaA_register_dbus(lua_State *L) {
         {NULL,         NULL                 }
     };
 
+    static const struct luaL_Reg awesome_dbus_message_methods[] = {
+        {"args",      luaA_dbus_message_args     },
+        {"arg",       luaA_dbus_message_arg      },
+        {"signature", luaA_dbus_message_signature},
+        {NULL,        NULL                       }
+    };
+
+    luaL_newmetatable(L, LUNA_DBUS_MESSAGE);
+    luaL_newlib(L, awesome_dbus_message_methods);
+    lua_setfield(L, -2, "__index");
+    lua_pushcfunction(L, luaA_dbus_message_gc);
+    lua_setfield(L, -2, "__gc");
+    lua_pop(L, 1);
+
     luaL_newlib(L, awesome_dbus_lib);
     luaL_newlib(L, awesome_dbus_meta);
     lua_setmetatable(L, -2);
@@ -781,5 +995,8 @@ void a_dbus_init(void) { }
 /** Empty stub if dbus is not enabled */
 void a_dbus_cleanup(void) { }
 
+/** Empty stub if dbus is not enabled */
+void a_dbus_replay_message(bool system, const char *data, int len) { }
+
 #endif
 // vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -23,9 +23,11 @@
 #ifndef AWESOME_DBUS_H
 #define AWESOME_DBUS_H
 #include <lua.h>
+#include <stdbool.h>
 
 void a_dbus_init(void);
 void a_dbus_cleanup(void);
+void a_dbus_replay_message(bool, const char *, int);
 void luaA_register_dbus(lua_State *L);
 
 #endif
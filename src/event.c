@@ -25,6 +25,7 @@
 #include "common/atoms.h"
 #include "common/signals.h"
 #include "common/xutil.h"
+#include "eventlog.h"
 #include "ewmh.h"
 #include "keygrabber.h"
 #include "luaa.h"
@@ -418,10 +419,7 @@ static void event_handle_destroynotify(xcb_destroy_notify_event_t *ev) {
     if ((c = client_getbywin(ev->window))) client_unmanage(c, CLIENT_UNMANAGE_DESTROYED);
     else
         for (int i = 0; i < globalconf.embedded.len; i++)
-            if (globalconf.embedded.tab[i].win == ev->window) {
-                xembed_window_array_take(&globalconf.embedded, i);
-                luaA_systray_invalidate();
-            }
+            if (globalconf.embedded.tab[i].win == ev->window) systray_embed_remove(i);
 }
 
 /** Record that the given drawable contains the pointer.
@@ -701,6 +699,8 @@ static void event_handle_maprequest(xcb_map_request_event_t *ev) {
     if (wa_r->override_redirect) goto bailout;
 
     if ((em = xembed_getbywin(&globalconf.embedded, ev->window))) {
+        bool was_mapped = em->info.flags & XEMBED_MAPPED;
+
         xcb_map_window(globalconf.connection, ev->window);
         xembed_window_activate(globalconf.connection, ev->window, globalconf.timestamp);
         /* The correct way to set this is via the _XEMBED_INFO property. Neither
@@ -709,7 +709,8 @@ static void event_handle_maprequest(xcb_map_request_event_t *ev) {
          * property. Let's simulate the XEMBED_MAPPED bit.
          */
         em->info.flags |= XEMBED_MAPPED;
-        luaA_systray_invalidate();
+        em->mapped = true;
+        systray_embed_update(em, was_mapped);
     } else if ((c = client_getbywin(ev->window))) {
         /* Check that it may be visible, but not asked to be hidden */
         if (client_on_selected_tags(c) && !c->hidden) {
@@ -862,9 +863,8 @@ static void event_handle_reparentnotify(xcb_reparent_notify_event_t *ev) {
         /* Embedded window moved elsewhere, end of embedding */
         for (int i = 0; i < globalconf.embedded.len; i++)
             if (globalconf.embedded.tab[i].win == ev->window) {
-                xembed_window_array_take(&globalconf.embedded, i);
+                systray_embed_remove(i);
                 xcb_change_save_set(globalconf.connection, XCB_SET_MODE_DELETE, ev->window);
-                luaA_systray_invalidate();
             }
     }
 }
@@ -936,7 +936,7 @@ static bool should_ignore(xcb_generic_event_t *event) {
     return false;
 }
 
-void event_handle(xcb_generic_event_t *event) {
+static void event_dispatch(xcb_generic_event_t *event) {
     uint8_t response_type = XCB_EVENT_RESPONSE_TYPE(event);
 
     if (should_ignore(event)) return;
@@ -987,6 +987,19 @@ void event_handle(xcb_generic_event_t *event) {
 #undef EXTENSION_EVENT
 }
 
+/** The main event handler.
+ * \param event The event.
+ */
+void event_handle(xcb_generic_event_t *event) {
+    if (globalconf.eventlog_recording) eventlog_record_xevent(event);
+
+    if (globalconf.eventlog_replaying) {
+        gint64 start = g_get_monotonic_time();
+        event_dispatch(event);
+        eventlog_measure(XCB_EVENT_RESPONSE_TYPE(event), start);
+    } else event_dispatch(event);
+}
+
 void event_init(void) {
     const xcb_query_extension_reply_t *reply;
 
@@ -0,0 +1,646 @@
+/*
+ * eventlog.c - event recording and replay
+ *
+ * Copyright © 2026 Abigail Teague <ateague063@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* The event log records everything that drives the Lua code: X11 events as
+ * they enter event_handle(), exits of spawned children, D-Bus messages and
+ * marks emitted from Lua (gears.timer emits one per timeout). It is meant to
+ * be attached to bug reports about performance regressions.
+ *
+ * File format (all integers in the header are little endian):
+ *
+ *   "AWEVLOG" <version:u8> <recorded root window:u32>
+ *   { <type:u8> <usec since previous record:varint> <length:varint> <payload> }*
+ *
+ * X11 events are stored as their 32 byte wire representation in host byte
+ * order, so logs can only be replayed on a machine with the same endianness.
+ *
+ * awesome.restart() re-executes awesome with the same --record option. Each
+ * restarted instance records to a new file, FILE.1, FILE.2 and so on, with the
+ * number of the run passed in the environment.
+ *
+ * Replaying (--replay) happens in a fresh instance after startup. Top-level
+ * windows that were created by clients are recreated as stand-in windows on a
+ * separate X11 connection, and MapRequests, ConfigureRequests, unmaps and
+ * destroys are re-issued on them so that the real server generates the same
+ * requests for awesome. Events which awesome caused itself (ReparentNotify,
+ * MapNotify, ConfigureNotify, ...) are skipped since the replaying instance
+ * generates its own. Everything else is fed to event_handle() with window IDs
+ * translated to the stand-ins. D-Bus messages are dispatched to Lua without
+ * sending replies. Child exits and marks are only counted, since the replaying
+ * instance runs its own children and timers.
+ *
+ * While replaying, the time spent in event_handle() and in each refresh is
+ * measured per event type and a latency report is printed to stdout before
+ * awesome quits.
+ */
+
+#include "eventlog.h"
+#include "common/util.h"
+#include "dbus.h"
+#include "event.h"
+#include "globalconf.h"
+
+#include <errno.h>
+#include <lauxlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <xcb/xcb_event.h>
+
+#define EVENTLOG_MAGIC "AWEVLOG"
+#define EVENTLOG_MAGIC_LEN (sizeof(EVENTLOG_MAGIC) - 1)
+#define EVENTLOG_VERSION 1
+#define EVENTLOG_HEADER_LEN (EVENTLOG_MAGIC_LEN + 1 + 4)
+#define EVENTLOG_XEVENT_LEN 32
+/** How long to wait for the consequences of the last record, in seconds */
+#define EVENTLOG_REPLAY_SETTLE 1
+/** Number of the run of a restarted instance which records */
+#define EVENTLOG_RUN_ENV "AWESOME_EVENTLOG_RUN"
+
+typedef enum {
+    EVENTLOG_RECORD_XEVENT = 1,
+    EVENTLOG_RECORD_CHILD_EXIT,
+    EVENTLOG_RECORD_DBUS,
+    EVENTLOG_RECORD_MARK,
+} eventlog_record_type_t;
+
+typedef struct {
+    uint8_t     type;
+    uint64_t    delta;
+    const char *payload;
+    uint64_t    len;
+    /** Read position after this record */
+    gsize       end;
+} eventlog_record_t;
+
+static struct {
+    char             *record_path;
+    char             *replay_path;
+    bool              max_speed;
+    /** Recording state */
+    FILE             *file;
+    unsigned int      run;
+    gint64            last_time;
+    /** Replay state */
+    gchar            *data;
+    gsize             len;
+    gsize             pos;
+    xcb_window_t      recorded_root;
+    gint64            start;
+    gint64            recorded_time;
+    uint32_t          records;
+    uint32_t          skipped;
+    uint32_t          markers[EVENTLOG_CATEGORY_COUNT];
+    xcb_connection_t *conn;
+    GHashTable       *standins;
+    GArray           *latencies[EVENTLOG_CATEGORY_COUNT];
+} eventlog;
+
+void eventlog_set_record(const char *path) {
+    p_delete(&eventlog.record_path);
+    eventlog.record_path = a_strdup(path);
+}
+
+void eventlog_set_replay(const char *path) {
+    p_delete(&eventlog.replay_path);
+    eventlog.replay_path = a_strdup(path);
+}
+
+void eventlog_set_replay_speed(const char *speed) {
+    if (A_STREQ(speed, "max")) eventlog.max_speed = true;
+    else if (A_STREQ(speed, "recorded")) eventlog.max_speed = false;
+    else fatal("The possible values of --replay-speed are \"recorded\" or \"max\"");
+}
+
+/* {{{ Recording */
+
+static void eventlog_write_varint(uint64_t value) {
+    uint8_t buf[10];
+    int     len = 0;
+
+    do {
+        buf[len] = value & 0x7f;
+        value >>= 7;
+        if (value) buf[len] |= 0x80;
+        len++;
+    } while (value);
+
+    fwrite(buf, 1, len, eventlog.file);
+}
+
+static void eventlog_write(eventlog_record_type_t type, const void *payload, size_t len) {
+    gint64 now = g_get_monotonic_time();
+
+    fputc(type, eventlog.file);
+    eventlog_write_varint(now - eventlog.last_time);
+    eventlog_write_varint(len);
+    fwrite(payload, 1, len, eventlog.file);
+    eventlog.last_time = now;
+
+    if (ferror(eventlog.file)) {
+        warn("Error writing event log %s, stopping recording", eventlog.record_path);
+        fclose(eventlog.file);
+        eventlog.file                 = NULL;
+        globalconf.eventlog_recording = false;
+    }
+}
+
+void eventlog_record_xevent(const xcb_generic_event_t *ev) {
+    eventlog_write(EVENTLOG_RECORD_XEVENT, ev, EVENTLOG_XEVENT_LEN);
+}
+
+void eventlog_record_child_exit(pid_t pid, int status) {
+    int32_t payload[2] = { pid, status };
+    eventlog_write(EVENTLOG_RECORD_CHILD_EXIT, payload, sizeof(payload));
+}
+
+void eventlog_record_dbus(bool system, const char *data, int len) {
+    /* The bus is stored as the first byte of the payload */
+    char *payload = p_new(char, len + 1);
+    payload[0]    = system;
+    memcpy(payload + 1, data, len);
+    eventlog_write(EVENTLOG_RECORD_DBUS, payload, len + 1);
+    p_delete(&payload);
+}
+
+/** Add a mark to the event log.
+ *
+ * This does nothing unless awesome was started with `--record`.
+ *
+ * @tparam[opt=""] string text A description of the mark.
+ * @staticfct _eventlog_mark
+ * @noreturn
+ */
+int luaA_eventlog_mark(lua_State *L) {
+    if (globalconf.eventlog_recording) {
+        size_t      len;
+        const char *text = luaL_optlstring(L, 1, "", &len);
+        eventlog_write(EVENTLOG_RECORD_MARK, text, len);
+    } else if (globalconf.eventlog_replaying) {
+        eventlog.markers[EVENTLOG_CATEGORY_MARK]++;
+    }
+    return 0;
+}
+
+/* }}} */
+
+/* {{{ Replay */
+
+static bool eventlog_read_varint(gsize *pos, uint64_t *value) {
+    uint64_t result = 0;
+
+    for (int shift = 0; shift < 64 && *pos < eventlog.len; shift += 7) {
+        uint8_t byte = eventlog.data[(*pos)++];
+        result |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/** Parse the record at the current read position without consuming it.
+ * \return False at the end of the log or if the log is truncated.
+ */
+static bool eventlog_peek(eventlog_record_t *record) {
+    gsize pos = eventlog.pos;
+
+    if (pos >= eventlog.len) return false;
+    record->type = eventlog.data[pos++];
+    if (!eventlog_read_varint(&pos, &record->delta) || !eventlog_read_varint(&pos, &record->len))
+        return false;
+    if (record->len > eventlog.len - pos) return false;
+
+    record->payload = eventlog.data + pos;
+    record->end     = pos + record->len;
+    return true;
+}
+
+static xcb_window_t eventlog_standin(xcb_window_t window) {
+    return GPOINTER_TO_UINT(g_hash_table_lookup(eventlog.standins, GUINT_TO_POINTER(window)));
+}
+
+static void eventlog_translate(xcb_window_t *window) {
+    xcb_window_t standin;
+
+    if (*window == eventlog.recorded_root) *window = globalconf.screen->root;
+    else if ((standin = eventlog_standin(*window)) != XCB_NONE) *window = standin;
+}
+
+static void eventlog_create_standin(xcb_create_notify_event_t *ev) {
+    xcb_window_t window;
+
+    /* Only recreate top-level windows of clients, awesome creates its own
+     * frames and drawins with override-redirect set. */
+    if (ev->parent != eventlog.recorded_root || ev->override_redirect) return;
+
+    window = xcb_generate_id(eventlog.conn);
+    xcb_create_window(
+        eventlog.conn, XCB_COPY_FROM_PARENT, window, globalconf.screen->root, ev->x, ev->y,
+        MAX(ev->width, 1), MAX(ev->height, 1), ev->border_width, XCB_WINDOW_CLASS_INPUT_OUTPUT,
+        XCB_COPY_FROM_PARENT, 0, NULL);
+    g_hash_table_insert(eventlog.standins, GUINT_TO_POINTER(ev->window), GUINT_TO_POINTER(window));
+}
+
+static void eventlog_configure_standin(xcb_configure_request_event_t *ev) {
+    xcb_window_t window = eventlog_standin(ev->window);
+    uint32_t     values[7];
+    int          n    = 0;
+    uint16_t     mask = ev->value_mask;
+
+    if (window == XCB_NONE) return;
+
+    /* Sibling windows may not exist in the replay, so ignore stacking */
+    mask &= ~(XCB_CONFIG_WINDOW_SIBLING | XCB_CONFIG_WINDOW_STACK_MODE);
+    if (mask & XCB_CONFIG_WINDOW_X) values[n++] = (uint32_t)ev->x;
+    if (mask & XCB_CONFIG_WINDOW_Y) values[n++] = (uint32_t)ev->y;
+    if (mask & XCB_CONFIG_WINDOW_WIDTH) values[n++] = ev->width;
+    if (mask & XCB_CONFIG_WINDOW_HEIGHT) values[n++] = ev->height;
+    if (mask & XCB_CONFIG_WINDOW_BORDER_WIDTH) values[n++] = ev->border_width;
+
+    xcb_configure_window(eventlog.conn, window, mask, values);
+}
+
+static void eventlog_replay_xevent(const eventlog_record_t *record) {
+    xcb_generic_event_t *ev;
+    xcb_window_t         standin;
+
+    if (record->len < EVENTLOG_XEVENT_LEN) {
+        eventlog.skipped++;
+        return;
+    }
+
+    /* xcb_generic_event_t is larger than the wire event because of
+     * full_sequence, which stays zero */
+    ev = p_new(xcb_generic_event_t, 1);
+    memcpy(ev, record->payload, EVENTLOG_XEVENT_LEN);
+
+    switch (XCB_EVENT_RESPONSE_TYPE(ev)) {
+        case XCB_CREATE_NOTIFY:
+            eventlog_create_standin((void *)ev);
+            break;
+        case XCB_MAP_REQUEST:
+            standin = eventlog_standin(((xcb_map_request_event_t *)ev)->window);
+            if (standin != XCB_NONE) xcb_map_window(eventlog.conn, standin);
+            else eventlog.skipped++;
+            break;
+        case XCB_CONFIGURE_REQUEST:
+            eventlog_configure_standin((void *)ev);
+            break;
+        case XCB_UNMAP_NOTIFY:
+            standin = eventlog_standin(((xcb_unmap_notify_event_t *)ev)->window);
+            if (standin != XCB_NONE) xcb_unmap_window(eventlog.conn, standin);
+            break;
+        case XCB_DESTROY_NOTIFY: {
+            xcb_window_t window = ((xcb_destroy_notify_event_t *)ev)->window;
+            if ((standin = eventlog_standin(window)) != XCB_NONE) {
+                xcb_destroy_window(eventlog.conn, standin);
+                g_hash_table_remove(eventlog.standins, GUINT_TO_POINTER(window));
+            }
+            break;
+        }
+        case 0:
+        case XCB_REPARENT_NOTIFY:
+        case XCB_MAP_NOTIFY:
+        case XCB_CONFIGURE_NOTIFY:
+        case XCB_GRAVITY_NOTIFY:
+        case XCB_CIRCULATE_NOTIFY:
+            /* The replaying instance generates these itself */
+            eventlog.skipped++;
+            break;
+        case XCB_KEY_PRESS:
+        case XCB_KEY_RELEASE:
+        case XCB_BUTTON_PRESS:
+        case XCB_BUTTON_RELEASE:
+        case XCB_MOTION_NOTIFY: {
+            /* All of these have the layout of a key press event */
+            xcb_key_press_event_t *e = (void *)ev;
+            eventlog_translate(&e->root);
+            eventlog_translate(&e->event);
+            eventlog_translate(&e->child);
+            event_handle(ev);
+            break;
+        }
+        case XCB_ENTER_NOTIFY:
+        case XCB_LEAVE_NOTIFY: {
+            xcb_enter_notify_event_t *e = (void *)ev;
+            eventlog_translate(&e->root);
+            eventlog_translate(&e->event);
+            eventlog_translate(&e->child);
+            event_handle(ev);
+            break;
+        }
+        case XCB_FOCUS_IN:
+            eventlog_translate(&((xcb_focus_in_event_t *)ev)->event);
+            event_handle(ev);
+            break;
+        case XCB_EXPOSE:
+            eventlog_translate(&((xcb_expose_event_t *)ev)->window);
+            event_handle(ev);
+            break;
+        case XCB_PROPERTY_NOTIFY:
+            eventlog_translate(&((xcb_property_notify_event_t *)ev)->window);
+            event_handle(ev);
+            break;
+        case XCB_CLIENT_MESSAGE:
+            eventlog_translate(&((xcb_client_message_event_t *)ev)->window);
+            event_handle(ev);
+            break;
+        default:
+            event_handle(ev);
+            break;
+    }
+
+    p_delete(&ev);
+}
+
+static void eventlog_replay_record(const eventlog_record_t *record) {
+    switch (record->type) {
+        case EVENTLOG_RECORD_XEVENT:
+            eventlog_replay_xevent(record);
+            break;
+        case EVENTLOG_RECORD_DBUS:
+            if (record->len > 0) {
+                gint64 start = g_get_monotonic_time();
+                a_dbus_replay_message(record->payload[0], record->payload + 1, record->len - 1);
+                eventlog_measure(EVENTLOG_CATEGORY_DBUS, start);
+            }
+            break;
+        case EVENTLOG_RECORD_CHILD_EXIT:
+            eventlog.markers[EVENTLOG_CATEGORY_CHILD_EXIT]++;
+            break;
+        case EVENTLOG_RECORD_MARK:
+            eventlog.markers[EVENTLOG_CATEGORY_MARK]++;
+            break;
+        default:
+            eventlog.skipped++;
+            break;
+    }
+    eventlog.records++;
+}
+
+static int eventlog_compare_latency(const void *a, const void *b) {
+    gint64 x = *(const gint64 *)a, y = *(const gint64 *)b;
+    return (x > y) - (x < y);
+}
+
+static const char *eventlog_category_name(int category, char *buf, size_t len) {
+    const char *label;
+
+    switch (category) {
+        case 0:
+            return "Error";
+        case EVENTLOG_CATEGORY_REFRESH:
+            return "refresh";
+        case EVENTLOG_CATEGORY_DBUS:
+            return "D-Bus message";
+        case EVENTLOG_CATEGORY_CHILD_EXIT:
+            return "child exit";
+        case EVENTLOG_CATEGORY_MARK:
+            return "mark";
+    }
+
+    if (category < 64 && (label = xcb_event_get_label(category)) != NULL) return label;
+
+    /* Extension events belong to the extension with the closest base */
+    const char *extension = NULL;
+    int         base      = 0;
+#define EXTENSION_EVENT(ext, name)                                                     \
+    if (globalconf.event_base_##ext != 0 && globalconf.event_base_##ext <= category && \
+        globalconf.event_base_##ext > base) {                                          \
+        extension = name;                                                              \
+        base      = globalconf.event_base_##ext;                                       \
+    }
+    EXTENSION_EVENT(randr, "RandR");
+    EXTENSION_EVENT(shape, "Shape");
+    EXTENSION_EVENT(xkb, "XKB");
+    EXTENSION_EVENT(xfixes, "XFixes");
+#undef EXTENSION_EVENT
+
+    if (extension) snprintf(buf, len, "%s+%d", extension, category - base);
+    else snprintf(buf, len, "event %d", category);
+    return buf;
+}
+
+static void eventlog_report(void) {
+    char buf[32];
+
+    printf(
+        "eventlog: replayed %u records (%u skipped) from %s in %.3f s at %s speed\n",
+        eventlog.records, eventlog.skipped, eventlog.replay_path,
+        (g_get_monotonic_time() - eventlog.start) / 1e6, eventlog.max_speed ? "max" : "recorded");
+    printf(
+        "eventlog: %-20s %8s %10s %10s %10s %10s %10s\n", "handled", "count", "total ms", "mean us",
+        "p50 us", "p95 us", "max us");
+
+    for (int i = 0; i < EVENTLOG_CATEGORY_COUNT; i++) {
+        GArray *latencies = eventlog.latencies[i];
+        gint64  total     = 0;
+
+        if (latencies == NULL || latencies->len == 0) continue;
+
+        g_array_sort(latencies, eventlog_compare_latency);
+        for (guint j = 0; j < latencies->len; j++)
+            total += g_array_index(latencies, gint64, j);
+
+        printf(
+            "eventlog: %-20s %8u %10.3f %10.1f %10" G_GINT64_FORMAT " %10" G_GINT64_FORMAT
+            " %10" G_GINT64_FORMAT "\n",
+            eventlog_category_name(i, buf, sizeof(buf)), latencies->len, total / 1000.0,
+            (double)total / latencies->len, g_array_index(latencies, gint64, latencies->len / 2),
+            g_array_index(latencies, gint64, latencies->len * 95 / 100),
+            g_array_index(latencies, gint64, latencies->len - 1));
+    }
+
+    for (int i = 0; i < EVENTLOG_CATEGORY_COUNT; i++)
+        if (eventlog.markers[i] > 0)
+            printf(
+                "eventlog: %-20s %8u (counted, not replayed)\n",
+                eventlog_category_name(i, buf, sizeof(buf)), eventlog.markers[i]);
+}
+
+static gboolean eventlog_replay_finish(gpointer unused) {
+    eventlog_report();
+    g_main_loop_quit(globalconf.loop);
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean eventlog_replay_step(gpointer unused) {
+    eventlog_record_t    record;
+    xcb_generic_event_t *ev;
+
+    /* Errors for stand-in windows are expected and uninteresting */
+    while ((ev = xcb_poll_for_event(eventlog.conn)) != NULL)
+        p_delete(&ev);
+
+    while (eventlog_peek(&record)) {
+        if (!eventlog.max_speed) {
+            gint64 due = eventlog.start + eventlog.recorded_time + record.delta;
+            gint64 now = g_get_monotonic_time();
+            if (due > now) {
+                g_timeout_add((due - now + 999) / 1000, eventlog_replay_step, NULL);
+                xcb_flush(eventlog.conn);
+                return G_SOURCE_REMOVE;
+            }
+        }
+
+        eventlog.pos = record.end;
+        eventlog.recorded_time += record.delta;
+        eventlog_replay_record(&record);
+
+        /* Let the main loop run between records, like it would have between
+         * wakeups */
+        if (eventlog.max_speed) {
+            xcb_flush(eventlog.conn);
+            return G_SOURCE_CONTINUE;
+        }
+    }
+
+    if (eventlog.pos < eventlog.len) warn("Event log %s is truncated", eventlog.replay_path);
+
+    xcb_flush(eventlog.conn);
+    g_timeout_add_seconds(EVENTLOG_REPLAY_SETTLE, eventlog_replay_finish, NULL);
+    return G_SOURCE_REMOVE;
+}
+
+/** Record how long handling something took while replaying.
+ * \param category An X11 response type or an eventlog_category_t.
+ * \param start When handling began, from g_get_monotonic_time().
+ */
+void eventlog_measure(int category, gint64 start) {
+    gint64 elapsed = g_get_monotonic_time() - start;
+
+    if (category < 0 || category >= EVENTLOG_CATEGORY_COUNT) return;
+    if (eventlog.latencies[category] == NULL)
+        eventlog.latencies[category] = g_array_new(FALSE, FALSE, sizeof(gint64));
+    g_array_append_val(eventlog.latencies[category], elapsed);
+}
+
+/* }}} */
+
+static void eventlog_init_replay(void) {
+    GError *error = NULL;
+
+    if (!g_file_get_contents(eventlog.replay_path, &eventlog.data, &eventlog.len, &error))
+        fatal("Cannot read event log: %s", error->message);
+
+    if (eventlog.len < EVENTLOG_HEADER_LEN ||
+        memcmp(eventlog.data, EVENTLOG_MAGIC, EVENTLOG_MAGIC_LEN) != 0)
+        fatal("%s is not an event log", eventlog.replay_path);
+    if ((uint8_t)eventlog.data[EVENTLOG_MAGIC_LEN] != EVENTLOG_VERSION)
+        fatal(
+            "Event log %s has unsupported version %d", eventlog.replay_path,
+            eventlog.data[EVENTLOG_MAGIC_LEN]);
+
+    memcpy(&eventlog.recorded_root, eventlog.data + EVENTLOG_MAGIC_LEN + 1, 4);
+    eventlog.recorded_root = GUINT32_FROM_LE(eventlog.recorded_root);
+    eventlog.pos           = EVENTLOG_HEADER_LEN;
+
+    /* Stand-in windows must belong to another client, otherwise the server
+     * does not redirect their MapRequests and ConfigureRequests to us. */
+    eventlog.conn = xcb_connect(NULL, NULL);
+    if (xcb_connection_has_error(eventlog.conn))
+        fatal(
+            "Cannot open display for replaying (error %d)",
+            xcb_connection_has_error(eventlog.conn));
+    eventlog.standins             = g_hash_table_new(g_direct_hash, g_direct_equal);
+    globalconf.eventlog_replaying = true;
+}
+
+static void eventlog_init_record(void) {
+    uint32_t    root = GUINT32_TO_LE(globalconf.screen->root);
+    const char *run  = g_getenv(EVENTLOG_RUN_ENV);
+
+    if (run) {
+        eventlog.run = strtoul(run, NULL, 10);
+        /* Children must not see it */
+        g_unsetenv(EVENTLOG_RUN_ENV);
+    }
+    if (eventlog.run) {
+        gchar *path = g_strdup_printf("%s.%u", eventlog.record_path, eventlog.run);
+        eventlog_set_record(path);
+        g_free(path);
+    }
+
+    if (!(eventlog.file = fopen(eventlog.record_path, "wb")))
+        fatal("Cannot open event log %s: %s", eventlog.record_path, strerror(errno));
+
+    fwrite(EVENTLOG_MAGIC, 1, EVENTLOG_MAGIC_LEN, eventlog.file);
+    fputc(EVENTLOG_VERSION, eventlog.file);
+    fwrite(&root, 1, sizeof(root), eventlog.file);
+
+    eventlog.last_time            = g_get_monotonic_time();
+    globalconf.eventlog_recording = true;
+}
+
+/** Open the event log given on the command line, if any. This has to be
+ * called after the X11 connection is set up. */
+void eventlog_init(void) {
+    if (eventlog.replay_path) {
+        if (eventlog.record_path) warn("Ignoring --record since --replay was given");
+        eventlog_init_replay();
+    } else if (eventlog.record_path) {
+        eventlog_init_record();
+    }
+}
+
+/** Start replaying, to be called once startup is complete. */
+void eventlog_start(void) {
+    if (!globalconf.eventlog_replaying) return;
+
+    eventlog.start = g_get_monotonic_time();
+    g_idle_add(eventlog_replay_step, NULL);
+}
+
+void eventlog_cleanup(void) {
+    if (eventlog.file) {
+        if (fclose(eventlog.file) != 0)
+            warn("Error writing event log %s: %s", eventlog.record_path, strerror(errno));
+        eventlog.file                 = NULL;
+        globalconf.eventlog_recording = false;
+    }
+
+    if (eventlog.record_path && !eventlog.replay_path) {
+        /* Do not overwrite this log if awesome is restarting */
+        gchar *run = g_strdup_printf("%u", eventlog.run + 1);
+        g_setenv(EVENTLOG_RUN_ENV, run, TRUE);
+        g_free(run);
+    }
+
+    if (globalconf.eventlog_replaying) {
+        globalconf.eventlog_replaying = false;
+        xcb_disconnect(eventlog.conn);
+        g_hash_table_destroy(eventlog.standins);
+        for (int i = 0; i < EVENTLOG_CATEGORY_COUNT; i++)
+            if (eventlog.latencies[i]) g_array_free(eventlog.latencies[i], TRUE);
+        g_free(eventlog.data);
+        p_delete(&eventlog.replay_path);
+        p_clear(&eventlog, 1);
+    }
+
+    p_delete(&eventlog.record_path);
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,55 @@
+/*
+ * eventlog.h - event recording and replay header
+ *
+ * Copyright © 2026 Abigail Teague <ateague063@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AWESOME_EVENTLOG_H
+#define AWESOME_EVENTLOG_H
+
+#include <glib.h>
+#include <lua.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include <xcb/xcb.h>
+
+/** Measurement categories that are not X11 event types */
+typedef enum {
+    EVENTLOG_CATEGORY_REFRESH = 128,
+    EVENTLOG_CATEGORY_DBUS,
+    EVENTLOG_CATEGORY_CHILD_EXIT,
+    EVENTLOG_CATEGORY_MARK,
+    EVENTLOG_CATEGORY_COUNT
+} eventlog_category_t;
+
+void eventlog_set_record(const char *);
+void eventlog_set_replay(const char *);
+void eventlog_set_replay_speed(const char *);
+void eventlog_init(void);
+void eventlog_start(void);
+void eventlog_cleanup(void);
+
+void eventlog_record_xevent(const xcb_generic_event_t *);
+void eventlog_record_child_exit(pid_t, int);
+void eventlog_record_dbus(bool, const char *, int);
+void eventlog_measure(int, gint64);
+
+int luaA_eventlog_mark(lua_State *);
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
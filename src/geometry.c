@@ -0,0 +1,325 @@
+/*
+ * geometry.c - native geometry and matrix helpers
+ *
+ * Copyright © 2026 Abigail Teague <ateague063@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* C versions of the hot functions of gears.geometry.rectangle and gears.matrix.
+ * The Lua modules use them when they are available and keep their API: the
+ * rectangles and matrices stay plain tables, the functions here read them
+ * directly and return their results unboxed where the Lua API allows it.
+ */
+
+#include "geometry.h"
+#include "common/lualib.h"
+#include "luaa.h"
+
+#include <math.h>
+
+typedef struct {
+    lua_Number x, y, width, height;
+} rectangle_t;
+
+typedef struct {
+    lua_Number xx, yx, xy, yy, x0, y0;
+} matrix_t;
+
+static lua_Number geometry_checkfield(lua_State *L, int idx, const char *name) {
+    lua_Number n;
+    int        isnum;
+
+    lua_getfield(L, idx, name);
+    n = lua_tonumberx(L, -1, &isnum);
+    if (!isnum) luaL_error(L, "field '%s' is not a number", name);
+    lua_pop(L, 1);
+
+    return n;
+}
+
+static rectangle_t rectangle_check(lua_State *L, int idx) {
+    rectangle_t r;
+
+    idx      = lua_absindex(L, idx);
+    r.x      = geometry_checkfield(L, idx, "x");
+    r.y      = geometry_checkfield(L, idx, "y");
+    r.width  = geometry_checkfield(L, idx, "width");
+    r.height = geometry_checkfield(L, idx, "height");
+
+    return r;
+}
+
+static void rectangle_push(lua_State *L, rectangle_t r) {
+    lua_createtable(L, 0, 4);
+    luaA_pushcoordinate(L, r.x);
+    lua_setfield(L, -2, "x");
+    luaA_pushcoordinate(L, r.y);
+    lua_setfield(L, -2, "y");
+    luaA_pushcoordinate(L, r.width);
+    lua_setfield(L, -2, "width");
+    luaA_pushcoordinate(L, r.height);
+    lua_setfield(L, -2, "height");
+}
+
+static inline bool rectangle_intersects(const rectangle_t *a, const rectangle_t *b) {
+    return b->x < a->x + a->width && b->x + b->width > a->x && b->y < a->y + a->height &&
+           b->y + b->height > a->y;
+}
+
+static rectangle_t rectangle_intersection(const rectangle_t *a, const rectangle_t *b) {
+    rectangle_t g;
+
+    g.x      = MAX(a->x, b->x);
+    g.y      = MAX(a->y, b->y);
+    g.width  = MIN(a->x + a->width, b->x + b->width) - g.x;
+    g.height = MIN(a->y + a->height, b->y + b->height) - g.y;
+    if (g.width <= 0 || g.height <= 0) g.width = g.height = 0;
+
+    return g;
+}
+
+/** Check if an area intersect another area.
+ * @tparam table a The area.
+ * @tparam table b The other area.
+ * @treturn boolean True if they intersect.
+ * @staticfct _rectangle_intersect
+ */
+int luaA_rectangle_intersect(lua_State *L) {
+    rectangle_t a = rectangle_check(L, 1), b = rectangle_check(L, 2);
+
+    lua_pushboolean(L, rectangle_intersects(&a, &b));
+    return 1;
+}
+
+/** Get the intersect area between two areas.
+ * @tparam table a The area.
+ * @tparam table b The other area.
+ * @treturn table The intersect area.
+ * @staticfct _rectangle_intersection
+ */
+int luaA_rectangle_intersection(lua_State *L) {
+    rectangle_t a = rectangle_check(L, 1), b = rectangle_check(L, 2);
+
+    rectangle_push(L, rectangle_intersection(&a, &b));
+    return 1;
+}
+
+/** Remove an area from a list of areas, in place.
+ *
+ * The list ends up exactly like with the Lua version: the areas which do not
+ * intersect `elem` keep their order (and identity), followed by the slabs of
+ * the ones which do, starting from the end of the list.
+ *
+ * @tparam table areas The list of areas.
+ * @tparam table elem The area to remove.
+ * @treturn table The `areas` list.
+ * @staticfct _rectangle_area_remove
+ */
+int luaA_rectangle_area_remove(lua_State *L) {
+    rectangle_t elem, *slabs;
+    bool       *removed;
+    int         n, count = 0, kept = 0;
+
+    luaA_checktable(L, 1);
+    elem = rectangle_check(L, 2);
+    n    = luaA_rawlen(L, 1);
+
+    /* Garbage collected, so nothing leaks if an area is invalid */
+    slabs   = lua_newuserdatauv(L, sizeof(rectangle_t) * 4 * n + 1, 0);
+    removed = lua_newuserdatauv(L, sizeof(bool) * n + 1, 0);
+
+    for (int i = n; i >= 1; i--) {
+        rectangle_t r, inter;
+
+        lua_rawgeti(L, 1, i);
+        r = rectangle_check(L, -1);
+        lua_pop(L, 1);
+
+        removed[i - 1] = rectangle_intersects(&r, &elem);
+        if (!removed[i - 1]) continue;
+
+        inter = rectangle_intersection(&r, &elem);
+
+        if (inter.x > r.x) slabs[count++] = (rectangle_t){r.x, r.y, inter.x - r.x, r.height};
+        if (inter.y > r.y) slabs[count++] = (rectangle_t){r.x, r.y, r.width, inter.y - r.y};
+        if (inter.x + inter.width < r.x + r.width)
+            slabs[count++] = (rectangle_t){inter.x + inter.width, r.y,
+                                           (r.x + r.width) - (inter.x + inter.width), r.height};
+        if (inter.y + inter.height < r.y + r.height)
+            slabs[count++] = (rectangle_t){r.x, inter.y + inter.height, r.width,
+                                           (r.y + r.height) - (inter.y + inter.height)};
+    }
+
+    for (int i = 1; i <= n; i++) {
+        if (removed[i - 1]) continue;
+        if (++kept == i) continue;
+        lua_rawgeti(L, 1, i);
+        lua_rawseti(L, 1, kept);
+    }
+
+    for (int i = 0; i < count; i++) {
+        rectangle_push(L, slabs[i]);
+        lua_rawseti(L, 1, kept + i + 1);
+    }
+
+    for (int i = kept + count + 1; i <= n; i++) {
+        lua_pushnil(L);
+        lua_rawseti(L, 1, i);
+    }
+
+    lua_pushvalue(L, 1);
+    return 1;
+}
+
+/** Return the closest rectangle from a list for a given point.
+ * @tparam table list A table of areas.
+ * @tparam number x The x coordinate.
+ * @tparam number y The y coordinate.
+ * @return The key of the closest area.
+ * @staticfct _rectangle_closest_by_coord
+ */
+int luaA_rectangle_closest_by_coord(lua_State *L) {
+    lua_Number x = luaL_checknumber(L, 2), y = luaL_checknumber(L, 3);
+    lua_Number dist = HUGE_VAL;
+
+    luaA_checktable(L, 1);
+    lua_settop(L, 3);
+    lua_pushnil(L); /* The result, at index 4 */
+
+    lua_pushnil(L);
+    while (lua_next(L, 1)) {
+        rectangle_t g      = rectangle_check(L, -1);
+        lua_Number  dist_x = 0, dist_y = 0, d;
+
+        if (x < g.x)
+            dist_x = g.x - x;
+        else if (x >= g.x + g.width)
+            dist_x = x - g.x - g.width + 1;
+        if (y < g.y)
+            dist_y = g.y - y;
+        else if (y >= g.y + g.height)
+            dist_y = y - g.y - g.height + 1;
+
+        d = dist_x * dist_x + dist_y * dist_y;
+        lua_pop(L, 1);
+        if (d < dist) {
+            dist = d;
+            lua_pushvalue(L, -1);
+            lua_replace(L, 4);
+        }
+    }
+
+    return 1;
+}
+
+static matrix_t matrix_check(lua_State *L, int idx) {
+    matrix_t m;
+
+    idx  = lua_absindex(L, idx);
+    m.xx = geometry_checkfield(L, idx, "xx");
+    m.yx = geometry_checkfield(L, idx, "yx");
+    m.xy = geometry_checkfield(L, idx, "xy");
+    m.yy = geometry_checkfield(L, idx, "yy");
+    m.x0 = geometry_checkfield(L, idx, "x0");
+    m.y0 = geometry_checkfield(L, idx, "y0");
+
+    return m;
+}
+
+static int matrix_push(lua_State *L, matrix_t m) {
+    luaA_pushcoordinate(L, m.xx);
+    luaA_pushcoordinate(L, m.yx);
+    luaA_pushcoordinate(L, m.xy);
+    luaA_pushcoordinate(L, m.yy);
+    luaA_pushcoordinate(L, m.x0);
+    luaA_pushcoordinate(L, m.y0);
+    return 6;
+}
+
+/** Multiply two matrices.
+ * @tparam gears.matrix|cairo.Matrix a The first matrix.
+ * @tparam gears.matrix|cairo.Matrix b The second matrix.
+ * @treturn number xx, yx, xy, yy, x0 and y0 of the result.
+ * @staticfct _matrix_multiply
+ */
+int luaA_matrix_multiply(lua_State *L) {
+    matrix_t a = matrix_check(L, 1), b = matrix_check(L, 2);
+
+    return matrix_push(L, (matrix_t){
+                              .xx = a.xx * b.xx + a.yx * b.xy,
+                              .yx = a.xx * b.yx + a.yx * b.yy,
+                              .xy = a.xy * b.xx + a.yy * b.xy,
+                              .yy = a.xy * b.yx + a.yy * b.yy,
+                              .x0 = a.x0 * b.xx + a.y0 * b.xy + b.x0,
+                              .y0 = a.x0 * b.yx + a.y0 * b.yy + b.y0,
+                          });
+}
+
+/** Invert a matrix.
+ * @tparam gears.matrix m The matrix.
+ * @treturn number xx, yx, xy, yy, x0 and y0 of the result.
+ * @staticfct _matrix_invert
+ */
+int luaA_matrix_invert(lua_State *L) {
+    matrix_t   m       = matrix_check(L, 1);
+    lua_Number inv_det = 1 / (m.xx * m.yy - m.yx * m.xy);
+
+    /* Results of a division are always floats in Lua */
+    lua_pushnumber(L, inv_det * m.yy);
+    lua_pushnumber(L, inv_det * -m.yx);
+    lua_pushnumber(L, inv_det * -m.xy);
+    lua_pushnumber(L, inv_det * m.xx);
+    lua_pushnumber(L, inv_det * (m.xy * m.y0 - m.yy * m.x0));
+    lua_pushnumber(L, inv_det * (m.yx * m.x0 - m.xx * m.y0));
+    return 6;
+}
+
+/** Calculate the bounding rectangle of a transformed rectangle.
+ * @tparam gears.matrix m The matrix.
+ * @tparam number x The x coordinate of the rectangle.
+ * @tparam number y The y coordinate of the rectangle.
+ * @tparam number width The width of the rectangle.
+ * @tparam number height The height of the rectangle.
+ * @treturn number x, y, width and height of the bounding rectangle.
+ * @staticfct _matrix_transform_rectangle
+ */
+int luaA_matrix_transform_rectangle(lua_State *L) {
+    matrix_t   m = matrix_check(L, 1);
+    lua_Number x = luaL_checknumber(L, 2), y = luaL_checknumber(L, 3);
+    lua_Number width = luaL_checknumber(L, 4), height = luaL_checknumber(L, 5);
+    lua_Number px[4] = {x, x, x + width, x + width};
+    lua_Number py[4] = {y, y + height, y + height, y};
+    lua_Number min_x = HUGE_VAL, min_y = HUGE_VAL, max_x = -HUGE_VAL, max_y = -HUGE_VAL;
+
+    for (int i = 0; i < 4; i++) {
+        lua_Number tx = m.x0 + (m.xx * px[i] + m.xy * py[i]);
+        lua_Number ty = m.y0 + (m.yx * px[i] + m.yy * py[i]);
+
+        min_x = MIN(min_x, tx);
+        max_x = MAX(max_x, tx);
+        min_y = MIN(min_y, ty);
+        max_y = MAX(max_y, ty);
+    }
+
+    luaA_pushcoordinate(L, min_x);
+    luaA_pushcoordinate(L, min_y);
+    luaA_pushcoordinate(L, max_x - min_x);
+    luaA_pushcoordinate(L, max_y - min_y);
+    return 4;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,36 @@
+/*
+ * geometry.h - native geometry and matrix helpers header
+ *
+ * Copyright © 2026 Abigail Teague <ateague063@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AWESOME_GEOMETRY_H
+#define AWESOME_GEOMETRY_H
+
+#include <lua.h>
+
+int luaA_rectangle_intersect(lua_State *);
+int luaA_rectangle_intersection(lua_State *);
+int luaA_rectangle_area_remove(lua_State *);
+int luaA_rectangle_closest_by_coord(lua_State *);
+int luaA_matrix_multiply(lua_State *);
+int luaA_matrix_invert(lua_State *);
+int luaA_matrix_transform_rectangle(lua_State *);
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -126,6 +126,10 @@ typedef struct {
     bool                  have_searchpaths;
     /** When --no-argb is used in the modeline or command line */
     bool                  had_overriden_depth;
+    /** Events are being written to an event log (--record) */
+    bool                  eventlog_recording;
+    /** Events are being replayed from an event log (--replay) */
+    bool                  eventlog_replaying;
     uint8_t               event_base_shape;
     uint8_t               event_base_xkb;
     uint8_t               event_base_randr;
@@ -176,6 +180,10 @@ typedef struct {
         drawin_t    *parent;
         /** Background color */
         uint32_t     background_pixel;
+        /** Number of embedded windows with XEMBED_MAPPED */
+        int          visible;
+        /** Size last given to the systray window */
+        uint16_t     width, height;
     } systray;
     /** The monitor of startup notifications */
     SnMonitorContext     *snmonitor;
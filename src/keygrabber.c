@@ -26,36 +26,74 @@
  * @module keygrabber
  */
 
+#include <glib.h>
 #include <lauxlib.h>
-#include <unistd.h>
 #include <xkbcommon/xkbcommon-x11.h>
 #include <xkbcommon/xkbcommon.h>
 
 #include "common/lualib.h"
+#include "common/signals.h"
 #include "globalconf.h"
 #include "keygrabber.h"
 #include "objects/key.h"
+#include "xreply.h"
+
+/** How long to keep trying to grab the keyboard, in microseconds */
+#define KEYGRABBER_GRAB_TIMEOUT G_USEC_PER_SEC
+/** Delay between two attempts to grab the keyboard, in milliseconds */
+#define KEYGRABBER_GRAB_RETRY 10
+
+/** The keyboard grab being acquired */
+static struct {
+    /** Changed when the keygrabber stops, the replies to older grabs are ignored */
+    unsigned int generation;
+    gint64       deadline;
+    guint        retry;
+} keygrabber_grab_state;
+
+static void keygrabber_grab(void);
+
+static gboolean keygrabber_grab_retry(gpointer data) {
+    keygrabber_grab_state.retry = 0;
+    keygrabber_grab();
+    return G_SOURCE_REMOVE;
+}
 
-/** Grab the keyboard.
- * \return True if keyboard was grabbed.
- */
-static bool keygrabber_grab(void) {
-    int                        i;
-    xcb_grab_keyboard_reply_t *xgb;
-
-    for (i = 1000; i; i--) {
-        if ((xgb = xcb_grab_keyboard_reply(
-                 globalconf.connection,
-                 xcb_grab_keyboard(
-                     globalconf.connection, true, globalconf.screen->root, XCB_CURRENT_TIME,
-                     XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC),
-                 NULL))) {
-            p_delete(&xgb);
-            return true;
-        }
-        usleep(1000);
+static void keygrabber_grab_cb(void *reply, xcb_generic_error_t *error, void *data) {
+    xcb_grab_keyboard_reply_t *grab = reply;
+    lua_State                 *L    = globalconf_get_lua_State();
+
+    if (GPOINTER_TO_UINT(data) != keygrabber_grab_state.generation) return;
+
+    if (grab && grab->status == XCB_GRAB_STATUS_SUCCESS) {
+        luna_emit_global_signal(L, "keygrabber::grabbed", 0);
+        return;
     }
-    return false;
+
+    /* Someone else has the grab, wait for them to release it */
+    if (grab && g_get_monotonic_time() < keygrabber_grab_state.deadline) {
+        keygrabber_grab_state.retry =
+            g_timeout_add(KEYGRABBER_GRAB_RETRY, keygrabber_grab_retry, NULL);
+        return;
+    }
+
+    warn("unable to grab keyboard");
+    keygrabber_grab_state.generation++;
+    luaA_unregister(L, &globalconf.keygrabber);
+    luna_emit_global_signal(L, "keygrabber::grab_failed", 0);
+}
+
+/** Ask to grab the keyboard.
+ * The reply is handled by keygrabber_grab_cb(), while the events keep being
+ * processed.
+ */
+static void keygrabber_grab(void) {
+    xcb_grab_keyboard_cookie_t cookie = xcb_grab_keyboard(
+        globalconf.connection, true, globalconf.screen->root, XCB_CURRENT_TIME,
+        XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
+
+    xreply_add(
+        cookie.sequence, keygrabber_grab_cb, GUINT_TO_POINTER(keygrabber_grab_state.generation));
 }
 
 /** Returns, whether the \0-terminated char in UTF8 is control char.
@@ -106,6 +144,10 @@ bool keygrabber_handlekpress(lua_State *L, xcb_key_press_event_t *e) {
  * each keypress, until `keygrabber.stop` is called.
  * The callback function receives three arguments:
  *
+ * The grab is acquired asynchronously. If another client holds it, it is
+ * retried for a second before giving up. `keygrabber::grabbed` or
+ * `keygrabber::grab_failed` is emitted on `awesome` once it is known.
+ *
  * @param callback A callback function as described above.
  * @deprecated keygrabber.run
  */
@@ -114,10 +156,8 @@ static int luaA_keygrabber_run(lua_State *L) {
 
     luaA_registerfct(L, 1, &globalconf.keygrabber);
 
-    if (!keygrabber_grab()) {
-        luaA_unregister(L, &globalconf.keygrabber);
-        luaL_error(L, "unable to grab keyboard");
-    }
+    keygrabber_grab_state.deadline = g_get_monotonic_time() + KEYGRABBER_GRAB_TIMEOUT;
+    keygrabber_grab();
 
     return 0;
 }
@@ -126,6 +166,13 @@ static int luaA_keygrabber_run(lua_State *L) {
  * @deprecated keygrabber.stop
  */
 int luaA_keygrabber_stop(lua_State *L) {
+    /* Forget about the grab being acquired */
+    keygrabber_grab_state.generation++;
+    if (keygrabber_grab_state.retry) {
+        g_source_remove(keygrabber_grab_state.retry);
+        keygrabber_grab_state.retry = 0;
+    }
+
     xcb_ungrab_keyboard(globalconf.connection, XCB_CURRENT_TIME);
     luaA_unregister(L, &globalconf.keygrabber);
     return 0;
@@ -0,0 +1,557 @@
+/*
+ * layout.c - native client layouts
+ *
+ * Copyright © 2026 Abigail Teague <ateague063@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* These are C versions of the layouts in lib/awful/layout/suit. They compute
+ * the geometry of every client in one pass and resize the clients directly,
+ * instead of building a table per client for client.batch_geometry().
+ *
+ * The results must be identical to the Lua versions, so the arithmetic below
+ * follows the Lua code step by step, including the order of operations and
+ * the behaviour of math.min()/math.max() with NaN. tests/test-awful-layout.lua
+ * compares both implementations.
+ */
+
+#include "layout.h"
+#include "common/lualib.h"
+#include "common/xutil.h"
+#include "globalconf.h"
+#include "objects/client.h"
+
+#include <math.h>
+#include <string.h>
+
+enum { AREA_X, AREA_Y, AREA_WIDTH, AREA_HEIGHT };
+
+/** A geometry computed for a client, before gaps and borders are removed */
+typedef struct {
+    client_t *c;
+    double    area[4];
+} layout_geometry_t;
+
+typedef struct {
+    layout_geometry_t *geometries;
+    int                count;
+} layout_result_t;
+
+/** math.max() with two arguments */
+static inline double layout_max(double a, double b) { return b > a ? b : a; }
+
+/** math.min() with two arguments */
+static inline double layout_min(double a, double b) { return b < a ? b : a; }
+
+static inline double layout_clamp(double value, double min, double max) {
+    return value < min ? min : value > max ? max : value;
+}
+
+static void
+layout_set(layout_result_t *result, client_t *c, double x, double y, double width, double height) {
+    layout_geometry_t *g = &result->geometries[result->count++];
+
+    g->c                 = c;
+    g->area[AREA_X]      = x;
+    g->area[AREA_Y]      = y;
+    g->area[AREA_WIDTH]  = width;
+    g->area[AREA_HEIGHT] = height;
+}
+
+static void layout_checkarea(lua_State *L, int idx, const char *field, double area[4]) {
+    static const char *const names[] = {"x", "y", "width", "height"};
+
+    lua_getfield(L, idx, field);
+    luaA_checktable(L, -1);
+    for (int i = 0; i < 4; i++) {
+        lua_getfield(L, -1, names[i]);
+        area[i] = lua_tonumber(L, -1);
+        lua_pop(L, 1);
+    }
+    lua_pop(L, 1);
+}
+
+/** Same as c:apply_size_hints(math.max(1, width), math.max(1, height)) with
+ * the border and the gap removed first and added back afterwards, like
+ * apply_size_hints() in awful.layout.suit.tile.
+ */
+static void
+layout_apply_size_hints(client_t *c, double width, double height, double gap, double size[2]) {
+    double bw       = c->border_width;
+    area_t geometry = c->geometry;
+
+    width  = width - 2 * bw - gap;
+    height = height - 2 * bw - gap;
+
+    if (!client_isfixed(c)) {
+        geometry.width  = ceil(layout_clamp(layout_max(1, width), MIN_X11_SIZE, MAX_X11_SIZE));
+        geometry.height = ceil(layout_clamp(layout_max(1, height), MIN_X11_SIZE, MAX_X11_SIZE));
+    }
+
+    if (c->size_hints_honor) geometry = client_apply_size_hints(c, geometry);
+
+    size[0] = geometry.width + 2 * bw + gap;
+    size[1] = geometry.height + 2 * bw + gap;
+}
+
+/* {{{ Tile */
+
+typedef struct {
+    double           wa[4];
+    /** Indexes into wa, swapped for the top and bottom orientations */
+    int              x, y, width, height;
+    double           gap;
+    client_t       **clients;
+    layout_result_t *result;
+} layout_tile_t;
+
+/** Push data[index] of the windowfact table, creating it when missing */
+static void layout_tile_getfact(lua_State *L, int data, int index) {
+    if (lua_rawgeti(L, data, index) == LUA_TNIL) {
+        lua_pop(L, 1);
+        lua_newtable(L);
+        lua_pushvalue(L, -1);
+        lua_rawseti(L, data, index);
+    }
+}
+
+static double layout_tile_group(
+    lua_State *L, layout_tile_t *t, int fact, int first, int last, double coord, double size) {
+    double available  = t->wa[t->width] - (coord - t->wa[t->x]);
+    double total_fact = 0;
+    double min_fact   = 1;
+    /** Where min_fact came from, 0 for the initial value */
+    int    min_index  = 0;
+
+    for (int c = first; c <= last; c++) {
+        client_t *client    = t->clients[c - 1];
+        int       i         = c - first + 1;
+        double    size_hint = 0;
+        double    value;
+
+        if (t->width == AREA_WIDTH) {
+            if (client->size_hints.flags & XCB_ICCCM_SIZE_HINT_P_MIN_SIZE)
+                size_hint = client->size_hints.min_width;
+            else if (client->size_hints.flags & XCB_ICCCM_SIZE_HINT_BASE_SIZE)
+                size_hint = client->size_hints.base_width;
+        } else {
+            if (client->size_hints.flags & XCB_ICCCM_SIZE_HINT_P_MIN_SIZE)
+                size_hint = client->size_hints.min_height;
+            else if (client->size_hints.flags & XCB_ICCCM_SIZE_HINT_BASE_SIZE)
+                size_hint = client->size_hints.base_height;
+        }
+        size = layout_max(size_hint, size);
+
+        if (lua_rawgeti(L, fact, i) == LUA_TNIL || !lua_toboolean(L, -1)) {
+            /* Store the same Lua value the Lua version would have */
+            if (min_index == 0) lua_pushinteger(L, 1);
+            else lua_rawgeti(L, fact, min_index);
+            lua_rawseti(L, fact, i);
+            value = min_fact;
+        } else {
+            value = lua_tonumber(L, -1);
+            if (!(min_fact < value)) {
+                min_fact  = value;
+                min_index = i;
+            }
+        }
+        lua_pop(L, 1);
+        total_fact += value;
+    }
+    size = layout_max(1, layout_min(size, available));
+
+    double y         = t->wa[t->y];
+    double used_size = 0;
+    double unused    = t->wa[t->height];
+
+    for (int c = first; c <= last; c++) {
+        client_t *client = t->clients[c - 1];
+        /* Both are indexed like an area, hints only uses the size */
+        double    geom[4], hints[4];
+        double    value;
+
+        lua_rawgeti(L, fact, c - first + 1);
+        value = lua_tonumber(L, -1);
+        lua_pop(L, 1);
+
+        geom[t->width]  = size;
+        geom[t->height] = layout_max(1, floor(unused * value / total_fact));
+        geom[t->x]      = coord;
+        geom[t->y]      = y;
+        layout_set(
+            t->result, client, geom[AREA_X], geom[AREA_Y], geom[AREA_WIDTH], geom[AREA_HEIGHT]);
+
+        layout_apply_size_hints(client, geom[AREA_WIDTH], geom[AREA_HEIGHT], t->gap, &hints[2]);
+        y          = y + hints[t->height];
+        unused     = unused - hints[t->height];
+        total_fact = total_fact - value;
+        used_size  = layout_max(used_size, hints[t->width]);
+    }
+
+    return used_size;
+}
+
+static void layout_tile(
+    lua_State *L, int p, int options, client_t **clients, int n, layout_result_t *result) {
+    layout_tile_t t = {.clients = clients, .result = result};
+    const char   *orientation;
+    bool          place_master, grow_master, flipped, swapped;
+    int           nmaster, nother, ncol, data;
+    double        mwfact, coord;
+
+    layout_checkarea(L, p, "workarea", t.wa);
+    t.gap = luaA_getopt_number(L, p, "useless_gap", 0);
+
+    lua_getfield(L, options, "orientation");
+    orientation = luaL_optstring(L, -1, "right");
+    lua_pop(L, 1);
+    swapped = A_STREQ(orientation, "top") || A_STREQ(orientation, "bottom");
+    flipped = A_STREQ(orientation, "left") || A_STREQ(orientation, "top");
+
+    t.x      = swapped ? AREA_Y : AREA_X;
+    t.y      = swapped ? AREA_X : AREA_Y;
+    t.width  = swapped ? AREA_HEIGHT : AREA_WIDTH;
+    t.height = swapped ? AREA_WIDTH : AREA_HEIGHT;
+
+    nmaster = luaA_getopt_integer(L, options, "master_count", 1);
+    nmaster = MIN(nmaster, n);
+    nother  = MAX(n - nmaster, 0);
+    mwfact  = luaA_getopt_number(L, options, "master_width_factor", 0.5);
+    ncol    = luaA_getopt_integer(L, options, "column_count", 1);
+
+    lua_getfield(L, options, "master_fill_policy");
+    grow_master = A_STREQ(lua_tostring(L, -1), "expand");
+    lua_pop(L, 1);
+
+    lua_getfield(L, options, "windowfact");
+    luaA_checktable(L, -1);
+    data = lua_gettop(L);
+
+    coord        = t.wa[t.x];
+    place_master = !flipped;
+
+    for (int pass = 0; pass < 2; pass++) {
+        if (place_master && nmaster > 0) {
+            double size = t.wa[t.width];
+            if (nother > 0 || !grow_master)
+                size = layout_min(t.wa[t.width] * mwfact, t.wa[t.width] - (coord - t.wa[t.x]));
+            if (nother == 0 && !grow_master) coord = coord + (t.wa[t.width] - size) / 2;
+
+            layout_tile_getfact(L, data, 0);
+            coord = coord + layout_tile_group(L, &t, lua_gettop(L), 1, nmaster, coord, size);
+            lua_pop(L, 1);
+        }
+
+        if (!place_master && nother > 0) {
+            int    last   = nmaster;
+            double wasize = t.wa[t.width];
+
+            if (nmaster > 0 && flipped) wasize = t.wa[t.width] - t.wa[t.width] * mwfact;
+
+            for (int i = 1; i <= ncol; i++) {
+                /* Try to get equal width among remaining columns */
+                double size  = (wasize - (coord - t.wa[t.x])) / (ncol - i + 1);
+                int    first = last + 1;
+                last         = last + floor((double)(n - last) / (ncol - i + 1));
+
+                layout_tile_getfact(L, data, i);
+                coord = coord + layout_tile_group(L, &t, lua_gettop(L), first, last, coord, size);
+                lua_pop(L, 1);
+            }
+        }
+        place_master = !place_master;
+    }
+
+    lua_pop(L, 1);
+}
+
+/* }}} */
+
+static void layout_fair(
+    lua_State *L, int p, int options, client_t **clients, int n, layout_result_t *result) {
+    double wa[4];
+    bool   east;
+    int    rows, cols;
+
+    layout_checkarea(L, p, "workarea", wa);
+    lua_getfield(L, options, "orientation");
+    east = A_STREQ(lua_tostring(L, -1), "east");
+    lua_pop(L, 1);
+
+    if (east) {
+        double tmp;
+        tmp             = wa[AREA_WIDTH];
+        wa[AREA_WIDTH]  = wa[AREA_HEIGHT];
+        wa[AREA_HEIGHT] = tmp;
+        tmp             = wa[AREA_X];
+        wa[AREA_X]      = wa[AREA_Y];
+        wa[AREA_Y]      = tmp;
+    }
+
+    if (n == 0) return;
+
+    if (n == 2) {
+        rows = 1;
+        cols = 2;
+    } else {
+        rows = ceil(sqrt(n));
+        cols = ceil((double)n / rows);
+    }
+
+    for (int k = 0; k < n; k++) {
+        int    row = k % rows, col = k / rows;
+        int    lrows, lcols = cols;
+        double x, y, width, height;
+
+        if (k >= rows * cols - rows) lrows = n - (rows * cols - rows);
+        else lrows = rows;
+
+        if (row == lrows - 1) {
+            height = wa[AREA_HEIGHT] - ceil(wa[AREA_HEIGHT] / lrows) * row;
+            y      = wa[AREA_HEIGHT] - height;
+        } else {
+            height = ceil(wa[AREA_HEIGHT] / lrows);
+            y      = height * row;
+        }
+
+        if (col == lcols - 1) {
+            width = wa[AREA_WIDTH] - ceil(wa[AREA_WIDTH] / lcols) * col;
+            x     = wa[AREA_WIDTH] - width;
+        } else {
+            width = ceil(wa[AREA_WIDTH] / lcols);
+            x     = width * col;
+        }
+
+        y = y + wa[AREA_Y];
+        x = x + wa[AREA_X];
+
+        if (east) layout_set(result, clients[k], y, x, height, width);
+        else layout_set(result, clients[k], x, y, width, height);
+    }
+}
+
+static void layout_spiral(
+    lua_State *L, int p, int options, client_t **clients, int n, layout_result_t *result) {
+    double wa[4];
+    double old_width, old_height, tmp;
+    bool   is_spiral;
+
+    layout_checkarea(L, p, "workarea", wa);
+    lua_getfield(L, options, "spiral");
+    is_spiral = lua_toboolean(L, -1);
+    lua_pop(L, 1);
+
+    old_width  = wa[AREA_WIDTH];
+    old_height = 2 * wa[AREA_HEIGHT];
+
+    for (int k = 1; k <= n; k++) {
+        if (k % 2 == 0) {
+            tmp             = ceil(old_width / 2);
+            old_width       = wa[AREA_WIDTH];
+            wa[AREA_WIDTH]  = tmp;
+            if (k != n) {
+                tmp             = floor(wa[AREA_HEIGHT] / 2);
+                old_height      = wa[AREA_HEIGHT];
+                wa[AREA_HEIGHT] = tmp;
+            }
+        } else {
+            tmp             = ceil(old_height / 2);
+            old_height      = wa[AREA_HEIGHT];
+            wa[AREA_HEIGHT] = tmp;
+            if (k != n) {
+                tmp            = floor(wa[AREA_WIDTH] / 2);
+                old_width      = wa[AREA_WIDTH];
+                wa[AREA_WIDTH] = tmp;
+            }
+        }
+
+        if (k % 4 == 0 && is_spiral) wa[AREA_X] = wa[AREA_X] - wa[AREA_WIDTH];
+        else if (k % 2 == 0) wa[AREA_X] = wa[AREA_X] + old_width;
+        else if (k % 4 == 3 && k < n && is_spiral) wa[AREA_X] = wa[AREA_X] + ceil(old_width / 2);
+
+        if (k % 4 == 1 && k != 1 && is_spiral) wa[AREA_Y] = wa[AREA_Y] - wa[AREA_HEIGHT];
+        else if (k % 2 == 1 && k != 1) wa[AREA_Y] = wa[AREA_Y] + old_height;
+        else if (k % 4 == 0 && k < n && is_spiral) wa[AREA_Y] = wa[AREA_Y] + ceil(old_height / 2);
+
+        layout_set(
+            result, clients[k - 1], wa[AREA_X], wa[AREA_Y], wa[AREA_WIDTH], wa[AREA_HEIGHT]);
+    }
+}
+
+static void layout_magnifier(
+    lua_State *L, int p, int options, client_t **clients, int n, layout_result_t *result) {
+    double    area[4], geometry[4];
+    double    mwfact;
+    client_t *focus = NULL;
+    int       fidx  = 0;
+
+    layout_checkarea(L, p, "workarea", area);
+    mwfact = luaA_getopt_number(L, options, "master_width_factor", 0.5);
+
+    lua_getfield(L, options, "focus");
+    if (!lua_isnil(L, -1)) focus = luaC_checkuclass(L, -1, "Client");
+    lua_pop(L, 1);
+
+    if (!focus) {
+        if (n == 0) return;
+        focus = clients[0];
+        fidx  = 1;
+    }
+
+    if (n > 1) {
+        geometry[AREA_WIDTH]  = area[AREA_WIDTH] * sqrt(mwfact);
+        geometry[AREA_HEIGHT] = area[AREA_HEIGHT] * sqrt(mwfact);
+        geometry[AREA_X]      = area[AREA_X] + (area[AREA_WIDTH] - geometry[AREA_WIDTH]) / 2;
+        geometry[AREA_Y]      = area[AREA_Y] + (area[AREA_HEIGHT] - geometry[AREA_HEIGHT]) / 2;
+    } else {
+        memcpy(geometry, area, sizeof(geometry));
+    }
+    layout_set(
+        result, focus, geometry[AREA_X], geometry[AREA_Y], geometry[AREA_WIDTH],
+        geometry[AREA_HEIGHT]);
+
+    if (n > 1) {
+        geometry[AREA_X]      = area[AREA_X];
+        geometry[AREA_Y]      = area[AREA_Y];
+        geometry[AREA_HEIGHT] = area[AREA_HEIGHT] / (n - 1);
+        geometry[AREA_WIDTH]  = area[AREA_WIDTH];
+
+        for (int k = 0; !fidx && k < n; k++)
+            if (clients[k] == focus) fidx = k + 1;
+        if (!fidx) luaL_error(L, "the focused client is not one of the clients to arrange");
+
+        for (int k = fidx + 1; k <= n; k++) {
+            layout_set(
+                result, clients[k - 1], geometry[AREA_X], geometry[AREA_Y], geometry[AREA_WIDTH],
+                geometry[AREA_HEIGHT]);
+            geometry[AREA_Y] = geometry[AREA_Y] + geometry[AREA_HEIGHT];
+        }
+
+        for (int k = 1; k <= fidx - 1; k++) {
+            layout_set(
+                result, clients[k - 1], geometry[AREA_X], geometry[AREA_Y], geometry[AREA_WIDTH],
+                geometry[AREA_HEIGHT]);
+            geometry[AREA_Y] = geometry[AREA_Y] + geometry[AREA_HEIGHT];
+        }
+    }
+}
+
+static void layout_max_arrange(
+    lua_State *L, int p, int options, client_t **clients, int n, layout_result_t *result) {
+    double area[4];
+
+    lua_getfield(L, options, "fullscreen");
+    layout_checkarea(L, p, lua_toboolean(L, -1) ? "geometry" : "workarea", area);
+    lua_pop(L, 1);
+
+    for (int k = 0; k < n; k++)
+        layout_set(
+            result, clients[k], area[AREA_X], area[AREA_Y], area[AREA_WIDTH], area[AREA_HEIGHT]);
+}
+
+/** Remove the gap and the border from a geometry, like awful.layout.arrange()
+ * does before client.batch_geometry().
+ */
+static area_t layout_finish(layout_geometry_t *g, double useless_gap) {
+    client_t *c = g->c;
+    area_t    geometry;
+    double    width  = layout_max(1, g->area[AREA_WIDTH] - c->border_width * 2 - useless_gap * 2);
+    double    height = layout_max(1, g->area[AREA_HEIGHT] - c->border_width * 2 - useless_gap * 2);
+
+    geometry.x = round(
+        layout_clamp(g->area[AREA_X] + useless_gap, MIN_X11_COORDINATE, MAX_X11_COORDINATE));
+    geometry.y = round(
+        layout_clamp(g->area[AREA_Y] + useless_gap, MIN_X11_COORDINATE, MAX_X11_COORDINATE));
+    if (client_isfixed(c)) {
+        geometry.width  = c->geometry.width;
+        geometry.height = c->geometry.height;
+    } else {
+        geometry.width  = ceil(layout_clamp(width, MIN_X11_SIZE, MAX_X11_SIZE));
+        geometry.height = ceil(layout_clamp(height, MIN_X11_SIZE, MAX_X11_SIZE));
+    }
+
+    return geometry;
+}
+
+typedef void (*layout_arrange_t)(lua_State *, int, int, client_t **, int, layout_result_t *);
+
+static const struct {
+    const char      *name;
+    layout_arrange_t arrange;
+} layout_algorithms[] = {
+    {"tile",      layout_tile       },
+    {"fair",      layout_fair       },
+    {"spiral",    layout_spiral     },
+    {"magnifier", layout_magnifier  },
+    {"max",       layout_max_arrange},
+};
+
+/** Arrange clients with one of the native layouts.
+ *
+ * This is used by the built-in layouts of `awful.layout.suit` when
+ * `awful.layout.native` is set.
+ *
+ * @tparam string algorithm One of "tile", "fair", "spiral", "magnifier" or "max".
+ * @tparam table p The layout parameters from `awful.layout.parameters`.
+ * @tparam table options The tag settings used by the algorithm.
+ * @staticfct _layout_arrange
+ * @noreturn
+ */
+int luaA_layout_arrange(lua_State *L) {
+    const char        *name    = luaL_checkstring(L, 1);
+    layout_arrange_t   arrange = NULL;
+    layout_result_t    result  = {0};
+    client_t         **clients;
+    client_geometry_t *geometries;
+    double             useless_gap;
+    int                n;
+
+    luaA_checktable(L, 2);
+    luaA_checktable(L, 3);
+
+    for (int i = 0; i < countof(layout_algorithms); i++)
+        if (A_STREQ(name, layout_algorithms[i].name)) arrange = layout_algorithms[i].arrange;
+    if (!arrange) return luaL_error(L, "unknown layout algorithm: %s", name);
+
+    useless_gap = luaA_getopt_number(L, 2, "useless_gap", 0);
+
+    lua_getfield(L, 2, "clients");
+    luaA_checktable(L, -1);
+    n       = luaA_rawlen(L, -1);
+    clients = p_alloca(client_t *, n + 1);
+    for (int i = 0; i < n; i++) {
+        lua_rawgeti(L, -1, i + 1);
+        clients[i] = luaC_checkuclass(L, -1, "Client");
+        lua_pop(L, 1);
+    }
+    lua_pop(L, 1);
+
+    /* The magnifier may also place a focused client that is not tiled */
+    result.geometries = p_alloca(layout_geometry_t, n + 1);
+    arrange(L, 2, 3, clients, n, &result);
+
+    geometries = p_alloca(client_geometry_t, result.count);
+    for (int i = 0; i < result.count; i++) {
+        geometries[i].client   = result.geometries[i].c;
+        geometries[i].geometry = layout_finish(&result.geometries[i], useless_gap);
+    }
+    client_resize_batch(geometries, result.count);
+
+    return 0;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -51,8 +51,11 @@
 #include "config.h"
 #include "dbus.h"
 #include "event.h"
+#include "eventlog.h"
+#include "geometry.h"
 #include "globalconf.h"
 #include "keygrabber.h"
+#include "layout.h"
 #include "mouse.h"
 #include "mousegrabber.h"
 #include "objects/client.h"
@@ -65,8 +68,10 @@
 #include "objects/selection_transfer.h"
 #include "objects/selection_watcher.h"
 #include "objects/tag.h"
+#include "placement.h"
 #include "property.h"
 #include "root.h"
+#include "sampler.h"
 #include "selection.h"
 #include "spawn.h"
 #include "systray.h"
@@ -152,6 +157,37 @@
  * @signal xkb::group_changed.
  */
 
+/** The keyboard was grabbed after `keygrabber.run` was called.
+ *
+ * The grab is acquired asynchronously, while another client holds it.
+ * @signal keygrabber::grabbed
+ */
+
+/** The keyboard could not be grabbed after `keygrabber.run` was called.
+ *
+ * The keygrabber is stopped. It is used in `awful.keygrabber` to stop the
+ * current instance.
+ * @signal keygrabber::grab_failed
+ */
+
+/** The mouse pointer was grabbed after `mousegrabber.run` was called.
+ * @signal mousegrabber::grabbed
+ */
+
+/** The mouse pointer could not be grabbed after `mousegrabber.run` was called.
+ *
+ * The mousegrabber is stopped.
+ * @signal mousegrabber::grab_failed
+ */
+
+/** The X resources have changed.
+ *
+ * This signal is emitted when the `RESOURCE_MANAGER` property of the root
+ * window changes, for example after `xrdb -merge`. The values returned by
+ * `xrdb_get_value` and `xrdb_get_values` are up to date by then.
+ * @signal xrdb::changed
+ */
+
 /** Refresh.
  *
  * This signal is emitted as a kind of idle signal in the event loop.
@@ -981,28 +1017,42 @@ static void add_to_search_path(lua_State *L, string_array_t *searchpath, bool fo
 void luaA_init(xdgHandle *xdg, string_array_t *searchpath) {
     lua_State                   *L;
     static const struct luaL_Reg awesome_lib[] = {
-        {"quit",                    luaA_quit                     },
-        {"exec",                    luaA_exec                     },
-        {"spawn",                   luaA_spawn                    },
-        {"restart",                 luaA_restart                  },
-        {"connect_signal",          luaA_awesome_connect_signal   },
-        {"disconnect_signal",       luaA_awesome_disconnect_signal},
-        {"emit_signal",             luaA_awesome_emit_signal      },
-        {"systray",                 luaA_systray                  },
-        {"load_image",              luaA_load_image               },
-        {"pixbuf_to_surface",       luaA_pixbuf_to_surface        },
-        {"set_preferred_icon_size", luaA_set_preferred_icon_size  },
-        {"register_xproperty",      luaA_register_xproperty       },
-        {"set_xproperty",           luaA_set_xproperty            },
-        {"get_xproperty",           luaA_get_xproperty            },
-        {"xkb_set_layout_group",    luaA_xkb_set_layout_group     },
-        {"xkb_get_layout_group",    luaA_xkb_get_layout_group     },
-        {"xkb_get_group_names",     luaA_xkb_get_group_names      },
-        {"xrdb_get_value",          luaA_xrdb_get_value           },
-        {"kill",                    luaA_kill                     },
-        {"sync",                    luaA_sync                     },
-        {"_get_key_name",           luaA_get_key_name             },
-        {NULL,                      NULL                          }
+        {"quit",                        luaA_quit                      },
+        {"exec",                        luaA_exec                      },
+        {"spawn",                       luaA_spawn                     },
+        {"restart",                     luaA_restart                   },
+        {"connect_signal",              luaA_awesome_connect_signal    },
+        {"disconnect_signal",           luaA_awesome_disconnect_signal },
+        {"emit_signal",                 luaA_awesome_emit_signal       },
+        {"systray",                     luaA_systray                   },
+        {"load_image",                  luaA_load_image                },
+        {"pixbuf_to_surface",           luaA_pixbuf_to_surface         },
+        {"set_preferred_icon_size",     luaA_set_preferred_icon_size   },
+        {"register_xproperty",          luaA_register_xproperty        },
+        {"set_xproperty",               luaA_set_xproperty             },
+        {"get_xproperty",               luaA_get_xproperty             },
+        {"xkb_set_layout_group",        luaA_xkb_set_layout_group      },
+        {"xkb_get_layout_group",        luaA_xkb_get_layout_group      },
+        {"xkb_get_group_names",         luaA_xkb_get_group_names       },
+        {"xrdb_get_value",              luaA_xrdb_get_value            },
+        {"xrdb_get_values",             luaA_xrdb_get_values           },
+        {"kill",                        luaA_kill                      },
+        {"sync",                        luaA_sync                      },
+        {"_get_key_name",               luaA_get_key_name              },
+        {"_eventlog_mark",              luaA_eventlog_mark             },
+        {"_layout_arrange",             luaA_layout_arrange            },
+        {"_placement_free_areas",       luaA_placement_free_areas      },
+        {"_spawn_backend",              luaA_spawn_backend             },
+        {"_spawn_read",                 luaA_spawn_read                },
+        {"_sampler_read",               luaA_sampler_read              },
+        {"_rectangle_intersect",        luaA_rectangle_intersect       },
+        {"_rectangle_intersection",     luaA_rectangle_intersection    },
+        {"_rectangle_area_remove",      luaA_rectangle_area_remove     },
+        {"_rectangle_closest_by_coord", luaA_rectangle_closest_by_coord},
+        {"_matrix_multiply",            luaA_matrix_multiply           },
+        {"_matrix_invert",              luaA_matrix_invert             },
+        {"_matrix_transform_rectangle", luaA_matrix_transform_rectangle},
+        {NULL,                          NULL                           }
     };
 
     static const struct luaL_Reg awesome_meta[] = {
@@ -96,6 +96,21 @@ static inline int luaA_pusharea(lua_State *L, area_t geometry) {
     return 1;
 }
 
+/** Push a number, as an integer if it has an integral value.
+ * Coordinates computed in C then behave like the ones computed with Lua's
+ * integer arithmetic.
+ * \param L The Lua VM state.
+ * \param n The number to push.
+ */
+static inline void luaA_pushcoordinate(lua_State *L, lua_Number n) {
+    lua_Integer i;
+
+    if (lua_numbertointeger(n, &i) && (lua_Number) i == n)
+        lua_pushinteger(L, i);
+    else
+        lua_pushnumber(L, n);
+}
+
 typedef bool luaA_config_callback(const char *);
 
 void        luaA_init(xdgHandle *, string_array_t *);
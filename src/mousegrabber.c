@@ -28,36 +28,78 @@
 
 #include "mousegrabber.h"
 #include "common/lualib.h"
+#include "common/signals.h"
 #include "common/xcursor.h"
 #include "globalconf.h"
 #include "mouse.h"
+#include "xreply.h"
 
+#include <glib.h>
 #include <lauxlib.h>
 #include <stdbool.h>
-#include <unistd.h>
 
-/** Grab the mouse.
- * \param cursor The cursor to use while grabbing.
- * \return True if mouse was grabbed.
- */
-static bool mousegrabber_grab(xcb_cursor_t cursor) {
-    xcb_window_t root = globalconf.screen->root;
-
-    for (int i = 1000; i; i--) {
-        xcb_grab_pointer_reply_t *grab_ptr_r;
-        xcb_grab_pointer_cookie_t grab_ptr_c = xcb_grab_pointer_unchecked(
-            globalconf.connection, false, root,
-            XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE |
-                XCB_EVENT_MASK_POINTER_MOTION,
-            XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC, root, cursor, XCB_CURRENT_TIME);
-
-        if ((grab_ptr_r = xcb_grab_pointer_reply(globalconf.connection, grab_ptr_c, NULL))) {
-            p_delete(&grab_ptr_r);
-            return true;
-        }
-        usleep(1000);
+/** How long to keep trying to grab the mouse, in microseconds */
+#define MOUSEGRABBER_GRAB_TIMEOUT G_USEC_PER_SEC
+/** Delay between two attempts to grab the mouse, in milliseconds */
+#define MOUSEGRABBER_GRAB_RETRY 10
+
+/** The mouse grab being acquired */
+static struct {
+    /** Changed when the mousegrabber stops, the replies to older grabs are ignored */
+    unsigned int generation;
+    gint64       deadline;
+    guint        retry;
+    xcb_cursor_t cursor;
+} mousegrabber_grab_state;
+
+static void mousegrabber_grab(void);
+
+static gboolean mousegrabber_grab_retry(gpointer data) {
+    mousegrabber_grab_state.retry = 0;
+    mousegrabber_grab();
+    return G_SOURCE_REMOVE;
+}
+
+static void mousegrabber_grab_cb(void *reply, xcb_generic_error_t *error, void *data) {
+    xcb_grab_pointer_reply_t *grab = reply;
+    lua_State                *L    = globalconf_get_lua_State();
+
+    if (GPOINTER_TO_UINT(data) != mousegrabber_grab_state.generation) return;
+
+    if (grab && grab->status == XCB_GRAB_STATUS_SUCCESS) {
+        luna_emit_global_signal(L, "mousegrabber::grabbed", 0);
+        return;
+    }
+
+    /* Someone else has the grab, wait for them to release it */
+    if (grab && g_get_monotonic_time() < mousegrabber_grab_state.deadline) {
+        mousegrabber_grab_state.retry =
+            g_timeout_add(MOUSEGRABBER_GRAB_RETRY, mousegrabber_grab_retry, NULL);
+        return;
     }
-    return false;
+
+    warn("unable to grab mouse pointer");
+    mousegrabber_grab_state.generation++;
+    luaA_unregister(L, &globalconf.mousegrabber);
+    luna_emit_global_signal(L, "mousegrabber::grab_failed", 0);
+}
+
+/** Ask to grab the mouse, with the cursor of the grab state.
+ * The reply is handled by mousegrabber_grab_cb(), while the events keep being
+ * processed.
+ */
+static void mousegrabber_grab(void) {
+    xcb_window_t              root   = globalconf.screen->root;
+    xcb_grab_pointer_cookie_t cookie = xcb_grab_pointer(
+        globalconf.connection, false, root,
+        XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE |
+            XCB_EVENT_MASK_POINTER_MOTION,
+        XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC, root, mousegrabber_grab_state.cursor,
+        XCB_CURRENT_TIME);
+
+    xreply_add(
+        cookie.sequence, mousegrabber_grab_cb,
+        GUINT_TO_POINTER(mousegrabber_grab_state.generation));
 }
 
 /** Handle mouse motion events.
@@ -81,6 +123,10 @@ void mousegrabber_handleevent(lua_State *L, int x, int y, uint16_t mask) {
  *@DOC_cursor_c_COMMON@
  *
  *
+ * The grab is acquired asynchronously. If another client holds it, it is
+ * retried for a second before giving up. `mousegrabber::grabbed` or
+ * `mousegrabber::grab_failed` is emitted on `awesome` once it is known.
+ *
  * @tparam function func A callback function as described above.
  * @tparam string|nil cursor The name of an X cursor to use while grabbing or `nil`
  * to not change the cursor.
@@ -104,10 +150,9 @@ static int luaA_mousegrabber_run(lua_State *L) {
 
     luaA_registerfct(L, 1, &globalconf.mousegrabber);
 
-    if (!mousegrabber_grab(cursor)) {
-        luaA_unregister(L, &globalconf.mousegrabber);
-        luaL_error(L, "unable to grab mouse pointer");
-    }
+    mousegrabber_grab_state.cursor   = cursor;
+    mousegrabber_grab_state.deadline = g_get_monotonic_time() + MOUSEGRABBER_GRAB_TIMEOUT;
+    mousegrabber_grab();
 
     return 0;
 }
@@ -118,6 +163,13 @@ static int luaA_mousegrabber_run(lua_State *L) {
  * @noreturn
  */
 int luaA_mousegrabber_stop(lua_State *L) {
+    /* Forget about the grab being acquired */
+    mousegrabber_grab_state.generation++;
+    if (mousegrabber_grab_state.retry) {
+        g_source_remove(mousegrabber_grab_state.retry);
+        mousegrabber_grab_state.retry = 0;
+    }
+
     xcb_ungrab_pointer(globalconf.connection, XCB_CURRENT_TIME);
     luaA_unregister(L, &globalconf.mousegrabber);
     return 0;
@@ -2252,7 +2252,7 @@ void client_send_configure(client_t *c) {
 
 /** Apply size hints to the client's new geometry.
  */
-static area_t client_apply_size_hints(client_t *c, area_t geometry) {
+area_t client_apply_size_hints(client_t *c, area_t geometry) {
     int32_t minw = 0, minh = 0;
     int32_t basew = 0, baseh = 0, real_basew = 0, real_baseh = 0;
 
@@ -2338,17 +2338,19 @@ static area_t client_apply_size_hints(client_t *c, area_t geometry) {
     return geometry;
 }
 
-static void client_resize_do(client_t *c, area_t geometry) {
+/** Emit the signals for a geometry change and update everything that depends
+ * on the geometry.
+ * \param c The client, which already has its new geometry.
+ * \param old_geometry The geometry before the change.
+ */
+static void client_resize_finish(client_t *c, area_t old_geometry) {
     lua_State *L         = globalconf_get_lua_State();
+    area_t     geometry  = c->geometry;
 
     screen_t *new_screen = c->screen;
     if (!screen_area_in_screen(new_screen, geometry))
         new_screen = screen_getbycoord(geometry.x, geometry.y);
 
-    /* Also store geometry including border */
-    area_t old_geometry = c->geometry;
-    c->geometry         = geometry;
-
     luna_object_push(L, c);
     if (!AREA_EQUAL(old_geometry, geometry))
         luna_object_emit_signal(L, -1, ":property.geometry", 0);
@@ -2389,14 +2391,23 @@ static void client_resize_do(client_t *c, area_t geometry) {
     }
 }
 
-/** Resize client window.
- * The sizes given as parameters are with borders!
+static void client_resize_do(client_t *c, area_t geometry) {
+    /* Also store geometry including border */
+    area_t old_geometry = c->geometry;
+    c->geometry         = geometry;
+
+    client_resize_finish(c, old_geometry);
+}
+
+/** Validate a new client geometry and apply the size hints to it.
  * \param c Client to resize.
- * \param geometry New window geometry.
+ * \param geometry New window geometry, replaced by the one to apply.
  * \param honor_hints Use size hints.
- * \return true if an actual resize occurred.
+ * \return true if the client should be resized.
  */
-bool client_resize(client_t *c, area_t geometry, bool honor_hints) {
+static bool client_resize_check(client_t *c, area_t *_geometry, bool honor_hints) {
+    area_t geometry = *_geometry;
+
     if (honor_hints) {
         /* We could get integer underflows in client_remove_titlebar_geometry()
          * without these checks here.
@@ -2419,13 +2430,54 @@ bool client_resize(client_t *c, area_t geometry, bool honor_hints) {
 
     if (geometry.width == 0 || geometry.height == 0) return false;
 
-    if (!AREA_EQUAL(c->geometry, geometry)) {
-        client_resize_do(c, geometry);
+    *_geometry = geometry;
+    return !AREA_EQUAL(c->geometry, geometry);
+}
+
+/** Resize client window.
+ * The sizes given as parameters are with borders!
+ * \param c Client to resize.
+ * \param geometry New window geometry.
+ * \param honor_hints Use size hints.
+ * \return true if an actual resize occurred.
+ */
+bool client_resize(client_t *c, area_t geometry, bool honor_hints) {
+    if (!client_resize_check(c, &geometry, honor_hints)) return false;
 
-        return true;
+    client_resize_do(c, geometry);
+    return true;
+}
+
+/** Resize many clients at once.
+ * All clients get their new geometry before any signal is emitted, so that
+ * signal handlers see a consistent state. Each client then emits its geometry
+ * signals once. The windows are configured in the next refresh, like with
+ * client_resize(). Size hints are honored if the client wants it.
+ * \param geometries The clients and their new geometries, with borders. The
+ * geometry is replaced by the one that was applied.
+ * \param count The number of entries.
+ * \return The number of clients which were actually resized.
+ */
+int client_resize_batch(client_geometry_t *geometries, int count) {
+    area_t *old_geometries = p_alloca(area_t, count);
+    bool   *resized        = p_alloca(bool, count);
+    int     n              = 0;
+
+    for (int i = 0; i < count; i++) {
+        client_t *c = geometries[i].client;
+
+        resized[i] = client_resize_check(c, &geometries[i].geometry, c->size_hints_honor);
+        if (resized[i]) {
+            old_geometries[i] = c->geometry;
+            c->geometry       = geometries[i].geometry;
+            n++;
+        }
     }
 
-    return false;
+    for (int i = 0; i < count; i++)
+        if (resized[i]) client_resize_finish(geometries[i].client, old_geometries[i]);
+
+    return n;
 }
 
 /** Set a client minimized, or not.
@@ -3372,6 +3424,33 @@ HANDLE_TITLEBAR(right, CLIENT_TITLEBAR_RIGHT)
 HANDLE_TITLEBAR(bottom, CLIENT_TITLEBAR_BOTTOM)
 HANDLE_TITLEBAR(left, CLIENT_TITLEBAR_LEFT)
 
+/** Get a client geometry from a table, like the `geometry` method does.
+ * \param L The Lua VM state.
+ * \param idx The index of the table.
+ * \param c The client, for the fields that are missing.
+ * \return The geometry.
+ */
+static area_t luaA_client_checkgeometry(lua_State *L, int idx, client_t *c) {
+    area_t geometry;
+
+    luaA_checktable(L, idx);
+    geometry.x = round(luaA_getopt_number_range(
+        L, idx, "x", c->geometry.x, MIN_X11_COORDINATE, MAX_X11_COORDINATE));
+    geometry.y = round(luaA_getopt_number_range(
+        L, idx, "y", c->geometry.y, MIN_X11_COORDINATE, MAX_X11_COORDINATE));
+    if (client_isfixed(c)) {
+        geometry.width  = c->geometry.width;
+        geometry.height = c->geometry.height;
+    } else {
+        geometry.width  = ceil(luaA_getopt_number_range(
+            L, idx, "width", c->geometry.width, MIN_X11_SIZE, MAX_X11_SIZE));
+        geometry.height = ceil(luaA_getopt_number_range(
+            L, idx, "height", c->geometry.height, MIN_X11_SIZE, MAX_X11_SIZE));
+    }
+
+    return geometry;
+}
+
 /** Return or set client geometry.
  *
  * @DOC_sequences_client_geometry1_EXAMPLE@
@@ -3392,28 +3471,56 @@ HANDLE_TITLEBAR(left, CLIENT_TITLEBAR_LEFT)
 static int luaA_client_geometry(lua_State *L) {
     client_t *c = luaC_checkuclass(L, 1, "Client");
 
-    if (lua_gettop(L) == 2 && !lua_isnil(L, 2)) {
-        area_t geometry;
+    if (lua_gettop(L) == 2 && !lua_isnil(L, 2))
+        client_resize(c, luaA_client_checkgeometry(L, 2, c), c->size_hints_honor);
 
-        luaA_checktable(L, 2);
-        geometry.x = round(luaA_getopt_number_range(
-            L, 2, "x", c->geometry.x, MIN_X11_COORDINATE, MAX_X11_COORDINATE));
-        geometry.y = round(luaA_getopt_number_range(
-            L, 2, "y", c->geometry.y, MIN_X11_COORDINATE, MAX_X11_COORDINATE));
-        if (client_isfixed(c)) {
-            geometry.width  = c->geometry.width;
-            geometry.height = c->geometry.height;
-        } else {
-            geometry.width  = ceil(luaA_getopt_number_range(
-                L, 2, "width", c->geometry.width, MIN_X11_SIZE, MAX_X11_SIZE));
-            geometry.height = ceil(luaA_getopt_number_range(
-                L, 2, "height", c->geometry.height, MIN_X11_SIZE, MAX_X11_SIZE));
-        }
+    return luaA_pusharea(L, c->geometry);
+}
+
+/** Set the geometry of several clients at once.
+ *
+ * This is the same as calling `geometry` for each client, but all the
+ * geometries are checked before anything changes, all clients are moved
+ * before any signal is emitted and the windows are configured together.
+ * Each client emits its `property::geometry`, `property::position` and
+ * `property::size` signals once, after all clients got their new geometry.
+ * `awful.layout` uses this to apply a layout.
+ *
+ * @tparam table geometries A table with clients as keys and tables with
+ *  `x`, `y`, `width` and `height` as values. Missing fields keep their
+ *  current value.
+ * @treturn integer The number of clients whose geometry changed.
+ * @staticfct batch_geometry
+ * @see geometry
+ */
+static int luaA_client_batch_geometry(lua_State *L) {
+    client_geometry_t *geometries;
+    int                count = 0;
+
+    luaA_checktable(L, 1);
 
-        client_resize(c, geometry, c->size_hints_honor);
+    lua_pushnil(L);
+    while (lua_next(L, 1)) {
+        count++;
+        lua_pop(L, 1);
     }
 
-    return luaA_pusharea(L, c->geometry);
+    geometries = p_alloca(client_geometry_t, count);
+    count      = 0;
+
+    /* Check everything before changing anything */
+    lua_pushnil(L);
+    while (lua_next(L, 1)) {
+        client_t *c = luaC_checkuclass(L, -2, "Client");
+        luaA_checktable(L, -1);
+        geometries[count].client   = c;
+        geometries[count].geometry = luaA_client_checkgeometry(L, lua_gettop(L), c);
+        count++;
+        lua_pop(L, 1);
+    }
+
+    lua_pushinteger(L, client_resize_batch(geometries, count));
+    return 1;
 }
 
 /** Apply size hints to a size.
@@ -4236,6 +4343,9 @@ void luaC_register_client(lua_State *L) {
     lua_pushstring(L, "get");
     lua_pushcfunction(L, luaA_client_get);
     lua_rawset(L, -3);
+    lua_pushstring(L, "batch_geometry");
+    lua_pushcfunction(L, luaA_client_batch_geometry);
+    lua_rawset(L, -3);
 
     lua_getmetatable(L, -1);
     lua_pushstring(L, "__index");
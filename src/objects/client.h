@@ -196,18 +196,26 @@ struct client_t {
 
 ARRAY_FUNCS(client_t *, client, DO_NOTHING)
 
+/** A client and a new geometry for it, see client_resize_batch() */
+typedef struct {
+    client_t *client;
+    area_t    geometry;
+} client_geometry_t;
+
 /** Client class */
 
 bool      client_on_selected_tags(client_t *);
 client_t *client_getbywin(xcb_window_t);
 client_t *client_getbynofocuswin(xcb_window_t);
 client_t *client_getbyframewin(xcb_window_t);
+area_t    client_apply_size_hints(client_t *, area_t);
 
 void client_ban(client_t *);
 void client_ban_unfocus(client_t *);
 void client_unban(client_t *);
 void client_manage(xcb_window_t, xcb_get_geometry_reply_t *, xcb_get_window_attributes_reply_t *);
 bool client_resize(client_t *, area_t, bool);
+int  client_resize_batch(client_geometry_t *, int);
 void client_unmanage(client_t *, client_unmanage_t);
 void client_kill(client_t *);
 void client_set_sticky(lua_State *, int, bool);
@@ -46,6 +46,7 @@
  */
 
 #include "objects/screen.h"
+#include "atomcache.h"
 #include "banning.h"
 #include "event.h"
 #include "luaa.h"
@@ -574,27 +575,15 @@ static void lunaL_screen_gc(lua_State *L, void *p) {
 static screen_output_t screen_get_randr_output(
     lua_State                         *L,
     xcb_randr_monitor_info_iterator_t *it) {
-    screen_output_t            output;
-    xcb_randr_output_t        *randr_outputs;
-    xcb_get_atom_name_cookie_t name_c;
-    xcb_get_atom_name_reply_t *name_r;
+    screen_output_t     output;
+    xcb_randr_output_t *randr_outputs;
+    const char         *name;
 
     output.mm_width  = it->data->width_in_millimeters;
     output.mm_height = it->data->height_in_millimeters;
 
-    name_c           = xcb_get_atom_name_unchecked(globalconf.connection, it->data->name);
-    name_r           = xcb_get_atom_name_reply(globalconf.connection, name_c, NULL);
-
-    if (name_r) {
-        const char *name = xcb_get_atom_name_name(name_r);
-        size_t      len  = xcb_get_atom_name_name_length(name_r);
-
-        output.name      = memcpy(p_new(char *, len + 1), name, len);
-        output.name[len] = '\0';
-        p_delete(&name_r);
-    } else {
-        output.name = a_strdup("unknown");
-    }
+    name             = atomcache_get_name(it->data->name);
+    output.name      = a_strdup(name ? name : "unknown");
 
     randr_output_array_init(&output.outputs);
 
@@ -21,6 +21,7 @@
  */
 
 #include "objects/selection_acquire.h"
+#include "atomcache.h"
 #include "common/lualib.h"
 #include "common/object.h"
 #include "globalconf.h"
@@ -120,7 +121,6 @@ void selection_handle_selectionrequest(xcb_selection_request_event_t *ev) {
 static int luaA_selection_acquire_new(lua_State *L) {
     size_t                           name_length;
     const char                      *name;
-    xcb_intern_atom_reply_t         *reply;
     xcb_get_selection_owner_reply_t *selection_reply;
     xcb_atom_t                       name_atom;
     selection_acquire_t             *selection;
@@ -131,11 +131,7 @@ static int luaA_selection_acquire_new(lua_State *L) {
     name  = luaL_checklstring(L, -1, &name_length);
 
     /* Get the atom identifying the selection */
-    reply = xcb_intern_atom_reply(
-        globalconf.connection,
-        xcb_intern_atom_unchecked(globalconf.connection, false, name_length, name), NULL);
-    name_atom = reply ? reply->atom : XCB_NONE;
-    p_delete(&reply);
+    name_atom = atomcache_intern(name, name_length);
 
     selection            = lua_touserdata(L, 1);
     selection->selection = name_atom;
@@ -21,20 +21,47 @@
  */
 
 #include "objects/selection_getter.h"
+#include "atomcache.h"
 #include "common/atoms.h"
 #include "common/lualib.h"
 #include "common/object.h"
 #include "globalconf.h"
+#include "xreply.h"
+
+#include <glib.h>
 
 #define REGISTRY_GETTER_TABLE_INDEX "luna_selection_getters"
 
+/* Nothing here waits for the X server. The requests are sent and their reply
+ * handled by a callback from the main loop, which looks the getter up by its
+ * window since it may have been collected in the meantime.
+ */
+
 typedef struct selection_getter_t {
     /** Reference in the special table to this object */
     int          ref;
     /** Window used for the transfer */
     xcb_window_t window;
+    /** The atoms identifying the request, until both are interned */
+    xcb_atom_t   selection, target;
+    /** Number of those atoms still being interned */
+    int          pending_atoms;
+    /** Whether this is an incremental transfer */
+    bool         incremental;
+    /** Number of TARGETS replies waiting for their atom names */
+    int          pending_names;
+    /** Whether the transfer ended while some atom names were pending */
+    bool         end_pending;
 } selection_getter_t;
 
+/** A TARGETS reply waiting for the names of its atoms */
+typedef struct {
+    xcb_window_t window;
+    bool         final;
+    size_t       count;
+    xcb_atom_t  *atoms;
+} selection_targets_t;
+
 static void lunaL_selection_getter_alloc(lua_State *L) {
     selection_getter_t *s = lua_newuserdatauv(L, sizeof(selection_getter_t), 1);
     p_clear(s, 1);
@@ -44,13 +71,57 @@ static void lunaL_selection_getter_gc(lua_State *L, void *selection) {
     xcb_destroy_window(globalconf.connection, ((selection_getter_t *)selection)->window);
 }
 
+static int selection_getter_find_by_window(lua_State *L, xcb_window_t window) {
+    /* Iterate over all active selection getters */
+    lua_pushliteral(L, REGISTRY_GETTER_TABLE_INDEX);
+    lua_rawget(L, LUA_REGISTRYINDEX);
+    lua_pushnil(L);
+    while (lua_next(L, -2) != 0) {
+        if (lua_type(L, -1) == LUA_TUSERDATA) {
+            selection_getter_t *selection = lua_touserdata(L, -1);
+            if (selection->window == window) {
+                /* Found the right selection, remove table and key */
+                lua_remove(L, -2);
+                lua_remove(L, -2);
+                return 1;
+            }
+        }
+        /* Remove the value, leaving only the key */
+        lua_pop(L, 1);
+    }
+    /* Remove the getter table */
+    lua_pop(L, 1);
+
+    return 0;
+}
+
+/** Convert the selection once both atoms are interned */
+static void selection_intern_cb(lua_State *L, xcb_window_t window, xcb_atom_t atom, bool target) {
+    if (selection_getter_find_by_window(L, window) == 0) return;
+
+    selection_getter_t *selection = lua_touserdata(L, -1);
+    if (target) selection->target = atom;
+    else selection->selection = atom;
+
+    if (--selection->pending_atoms == 0)
+        xcb_convert_selection(
+            globalconf.connection, selection->window, selection->selection, selection->target,
+            AWESOME_SELECTION_ATOM, globalconf.timestamp);
+    lua_pop(L, 1);
+}
+
+static void selection_intern_selection_cb(xcb_atom_t atom, void *data) {
+    selection_intern_cb(globalconf_get_lua_State(), GPOINTER_TO_UINT(data), atom, false);
+}
+
+static void selection_intern_target_cb(xcb_atom_t atom, void *data) {
+    selection_intern_cb(globalconf_get_lua_State(), GPOINTER_TO_UINT(data), atom, true);
+}
+
 static int luaA_selection_getter_new(lua_State *L) {
     size_t                   name_length, target_length;
     const char              *name, *target;
-    xcb_intern_atom_cookie_t cookies[2];
-    xcb_intern_atom_reply_t *reply;
     selection_getter_t      *selection;
-    xcb_atom_t               name_atom, target_atom;
 
     luaA_checktable(L, 2);
     lua_pushliteral(L, "selection");
@@ -75,27 +146,35 @@ static int luaA_selection_getter_new(lua_State *L) {
     selection->ref = luaL_ref(L, -2);
     lua_pop(L, 1);
 
-    /* Get the atoms identifying the request */
-    cookies[0] = xcb_intern_atom_unchecked(globalconf.connection, false, name_length, name);
-    cookies[1] = xcb_intern_atom_unchecked(globalconf.connection, false, target_length, target);
-
-    reply      = xcb_intern_atom_reply(globalconf.connection, cookies[0], NULL);
-    name_atom  = reply ? reply->atom : XCB_NONE;
-    p_delete(&reply);
-
-    reply       = xcb_intern_atom_reply(globalconf.connection, cookies[1], NULL);
-    target_atom = reply ? reply->atom : XCB_NONE;
-    p_delete(&reply);
-
-    xcb_convert_selection(
-        globalconf.connection, selection->window, name_atom, target_atom, AWESOME_SELECTION_ATOM,
-        globalconf.timestamp);
+    /* Get the atoms identifying the request, the selection is converted once
+     * both are known */
+    selection->pending_atoms = 2;
+    atomcache_intern_async(
+        name, name_length, selection_intern_selection_cb, GUINT_TO_POINTER(selection->window));
+    atomcache_intern_async(
+        target, target_length, selection_intern_target_cb, GUINT_TO_POINTER(selection->window));
 
     return 1;
 }
 
 static void selection_transfer_finished(lua_State *L, int ud) {
-    selection_getter_t *selection = lua_touserdata(L, ud);
+    selection_getter_t *selection;
+
+    ud        = luaA_absindex(L, ud);
+    selection = lua_touserdata(L, ud);
+
+    /* The data is still being prepared */
+    if (selection->pending_names > 0) {
+        selection->end_pending = true;
+        return;
+    }
+
+    /* Tell the streaming receivers that this was the last chunk */
+    if (selection->incremental) {
+        lua_pushliteral(L, "");
+        lua_pushboolean(L, true);
+        luna_object_emit_signal(L, ud, "data", 2);
+    }
 
     /* Unreference the selection object; it's dead */
     lua_pushliteral(L, REGISTRY_GETTER_TABLE_INDEX);
@@ -108,30 +187,118 @@ static void selection_transfer_finished(lua_State *L, int ud) {
     luna_object_emit_signal(L, ud, "data_end", 0);
 }
 
-static void selection_push_data(lua_State *L, xcb_get_property_reply_t *property) {
+static void selection_push_targets(lua_State *L, xcb_atom_t *atoms, size_t count) {
+    lua_createtable(L, count, 0);
+    for (size_t i = 0; i < count; i++) {
+        const char *name = atomcache_name(atoms[i]);
+        if (name) {
+            lua_pushstring(L, name);
+            lua_rawseti(L, -2, i + 1);
+        }
+    }
+}
+
+static void selection_atom_names_cb(void *data) {
+    lua_State           *L       = globalconf_get_lua_State();
+    selection_targets_t *targets = data;
+
+    if (selection_getter_find_by_window(L, targets->window)) {
+        selection_getter_t *selection = lua_touserdata(L, -1);
+
+        selection_push_targets(L, targets->atoms, targets->count);
+        lua_pushboolean(L, targets->final);
+        luna_object_emit_signal(L, -3, "data", 2);
+
+        if (--selection->pending_names == 0 && selection->end_pending)
+            selection_transfer_finished(L, -1);
+        lua_pop(L, 1);
+    }
+
+    p_delete(&targets->atoms);
+    p_delete(&targets);
+}
+
+/** Emit the data of a property, or defer it until the atom names are known.
+ * \param ud The selection getter.
+ * \param property The property.
+ * \param final Whether this is the last chunk.
+ */
+static void selection_emit_data(
+    lua_State *L, int ud, xcb_get_property_reply_t *property, bool final) {
+    ud = luaA_absindex(L, ud);
+
     if (property->type == XCB_ATOM_ATOM && property->format == 32) {
-        size_t                     num_atoms = xcb_get_property_value_length(property) / 4;
-        xcb_atom_t                *atoms     = xcb_get_property_value(property);
-        xcb_get_atom_name_cookie_t cookies[num_atoms];
-
-        for (size_t i = 0; i < num_atoms; i++)
-            cookies[i] = xcb_get_atom_name_unchecked(globalconf.connection, atoms[i]);
-
-        lua_newtable(L);
-        for (size_t i = 0; i < num_atoms; i++) {
-            xcb_get_atom_name_reply_t *reply =
-                xcb_get_atom_name_reply(globalconf.connection, cookies[i], NULL);
-            if (reply) {
-                lua_pushlstring(
-                    L, xcb_get_atom_name_name(reply), xcb_get_atom_name_name_length(reply));
-                lua_rawseti(L, -2, i + 1);
-            }
-            p_delete(&reply);
+        size_t               num_atoms = xcb_get_property_value_length(property) / 4;
+        xcb_atom_t          *atoms     = xcb_get_property_value(property);
+        selection_getter_t  *selection = lua_touserdata(L, ud);
+        selection_targets_t *targets   = p_new(selection_targets_t, 1);
+
+        targets->window                = selection->window;
+        targets->final                 = final;
+        targets->count                 = num_atoms;
+        targets->atoms                 = p_dup(atoms, num_atoms);
+
+        /* Request the unknown names at once and emit when they arrive */
+        if (!atomcache_fetch_names(atoms, num_atoms, selection_atom_names_cb, targets)) {
+            selection->pending_names++;
+            return;
         }
+
+        p_delete(&targets->atoms);
+        p_delete(&targets);
+        selection_push_targets(L, atoms, num_atoms);
     } else {
         lua_pushlstring(
             L, xcb_get_property_value(property), xcb_get_property_value_length(property));
     }
+
+    lua_pushboolean(L, final);
+    luna_object_emit_signal(L, ud, "data", 2);
+}
+
+static void selection_property_cb(void *reply, xcb_generic_error_t *error, void *data) {
+    lua_State                *L          = globalconf_get_lua_State();
+    xcb_get_property_reply_t *property_r = reply;
+
+    if (selection_getter_find_by_window(L, GPOINTER_TO_UINT(data)) == 0) return;
+
+    if (property_r && property_r->type == INCR) {
+        /* This is an incremental transfer. The GetProperty had delete=true.
+         * This indicates to the other end that the transfer should start now.
+         * Right now we only get an estimate of the size of the data to be
+         * transferred, which we ignore.
+         */
+        selection_getter_t *selection = lua_touserdata(L, -1);
+        selection->incremental        = true;
+    } else {
+        if (property_r) selection_emit_data(L, -1, property_r, true);
+        selection_transfer_finished(L, -1);
+    }
+
+    lua_pop(L, 1);
+}
+
+static void selection_chunk_cb(void *reply, xcb_generic_error_t *error, void *data) {
+    lua_State                *L          = globalconf_get_lua_State();
+    xcb_get_property_reply_t *property_r = reply;
+
+    if (!property_r) return;
+    if (selection_getter_find_by_window(L, GPOINTER_TO_UINT(data)) == 0) return;
+
+    if (property_r->value_len > 0)
+        selection_emit_data(L, -1, property_r, false);
+    else
+        /* Transfer finished */
+        selection_transfer_finished(L, -1);
+
+    lua_pop(L, 1);
+}
+
+static void selection_get_property(xcb_window_t window, xreply_callback_t callback) {
+    xcb_get_property_cookie_t cookie = xcb_get_property(
+        globalconf.connection, true, window, AWESOME_SELECTION_ATOM, XCB_GET_PROPERTY_TYPE_ANY, 0,
+        0xffffffff);
+    xreply_add(cookie.sequence, callback, GUINT_TO_POINTER(window));
 }
 
 static void selection_handle_selectionnotify(lua_State *L, int ud, xcb_atom_t property) {
@@ -140,59 +307,16 @@ static void selection_handle_selectionnotify(lua_State *L, int ud, xcb_atom_t pr
     ud        = luaA_absindex(L, ud);
     selection = lua_touserdata(L, ud);
 
-    if (property != XCB_NONE) {
-        xcb_change_window_attributes(
-            globalconf.connection, selection->window, XCB_CW_EVENT_MASK,
-            (uint32_t[]) {XCB_EVENT_MASK_PROPERTY_CHANGE});
-
-        xcb_get_property_reply_t *property_r = xcb_get_property_reply(
-            globalconf.connection,
-            xcb_get_property(
-                globalconf.connection, true, selection->window, AWESOME_SELECTION_ATOM,
-                XCB_GET_PROPERTY_TYPE_ANY, 0, 0xffffffff),
-            NULL);
-
-        if (property_r) {
-            if (property_r->type == INCR) {
-                /* This is an incremental transfer. The above GetProperty had
-                 * delete=true. This indicates to the other end that the
-                 * transfer should start now. Right now we only get an estimate
-                 * of the size of the data to be transferred, which we ignore.
-                 */
-                p_delete(&property_r);
-                return;
-            }
-            selection_push_data(L, property_r);
-            luna_object_emit_signal(L, ud, "data", 1);
-            p_delete(&property_r);
-        }
+    if (property == XCB_NONE) {
+        selection_transfer_finished(L, ud);
+        return;
     }
 
-    selection_transfer_finished(L, ud);
-}
-
-static int selection_getter_find_by_window(lua_State *L, xcb_window_t window) {
-    /* Iterate over all active selection getters */
-    lua_pushliteral(L, REGISTRY_GETTER_TABLE_INDEX);
-    lua_rawget(L, LUA_REGISTRYINDEX);
-    lua_pushnil(L);
-    while (lua_next(L, -2) != 0) {
-        if (lua_type(L, -1) == LUA_TUSERDATA) {
-            selection_getter_t *selection = lua_touserdata(L, -1);
-            if (selection->window == window) {
-                /* Found the right selection, remove table and key */
-                lua_remove(L, -2);
-                lua_remove(L, -2);
-                return 1;
-            }
-        }
-        /* Remove the value, leaving only the key */
-        lua_pop(L, 1);
-    }
-    /* Remove the getter table */
-    lua_pop(L, 1);
+    xcb_change_window_attributes(
+        globalconf.connection, selection->window, XCB_CW_EVENT_MASK,
+        (uint32_t[]) {XCB_EVENT_MASK_PROPERTY_CHANGE});
 
-    return 0;
+    selection_get_property(selection->window, selection_property_cb);
 }
 
 void property_handle_awesome_selection_atom(uint8_t state, xcb_window_t window) {
@@ -202,26 +326,9 @@ void property_handle_awesome_selection_atom(uint8_t state, xcb_window_t window)
 
     if (selection_getter_find_by_window(L, window) == 0) return;
 
-    selection_getter_t *selection        = lua_touserdata(L, -1);
-
-    xcb_get_property_reply_t *property_r = xcb_get_property_reply(
-        globalconf.connection,
-        xcb_get_property(
-            globalconf.connection, true, selection->window, AWESOME_SELECTION_ATOM,
-            XCB_GET_PROPERTY_TYPE_ANY, 0, 0xffffffff),
-        NULL);
-
-    if (property_r) {
-        if (property_r->value_len > 0) {
-            selection_push_data(L, property_r);
-            luna_object_emit_signal(L, -2, "data", 1);
-        } else {
-            /* Transfer finished */
-            selection_transfer_finished(L, -1);
-        }
-
-        p_delete(&property_r);
-    }
+    /* The reply to the GetProperty deleting INCR comes first, so the getter
+     * knows the transfer is incremental by the time this one arrives */
+    selection_get_property(window, selection_chunk_cb);
 
     lua_pop(L, 1);
 }
@@ -21,14 +21,28 @@
  */
 
 #include "objects/selection_transfer.h"
+#include "atomcache.h"
 #include "common/atoms.h"
 #include "common/lualib.h"
 #include "common/object.h"
 #include "globalconf.h"
 #include "luaa.h"
 
+#include <errno.h>
+#include <fcntl.h>
+#include <glib-unix.h>
+#include <glib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #define REGISTRY_TRANSFER_TABLE_INDEX "luna_selection_transfers"
 #define TRANSFER_DATA_INDEX "data_for_next_chunk"
+#define TRANSFER_SELECTION_INDEX "selection_waiting_for_target_name"
+
+/* Seconds to wait for the requestor of an incremental transfer to take the
+ * next piece before giving up on it */
+#define TRANSFER_TIMEOUT 30
 
 enum transfer_state {
     TRANSFER_WAIT_FOR_DATA,
@@ -52,11 +66,20 @@ typedef struct selection_transfer_t {
     size_t              offset;
     /* Can there be more data coming from Lua? */
     bool                more_data;
+    /* File the data is read from instead, or -1 */
+    int                 fd;
+    /* Whether the file is read at offset, or is a pipe read in order */
+    bool                seekable;
+    /* Source waiting for the pipe to be readable, or 0 */
+    guint               read_source;
+    /* Source giving up on the requestor, or 0 */
+    guint               timeout_source;
 } selection_transfer_t;
 
 static void lunaL_selection_transfer_alloc(lua_State *L) {
     selection_transfer_t *s = lua_newuserdatauv(L, sizeof(selection_transfer_t), 1);
     p_clear(s, 1);
+    s->fd = -1;
 }
 
 static size_t max_property_length(void) {
@@ -92,9 +115,37 @@ void selection_transfer_reject(
     selection_transfer_notify(requestor, selection, target, XCB_NONE, time);
 }
 
+/** Push a transfer given its reference in the transfer table.
+ * \param L The Lua VM state.
+ * \param ref The reference.
+ * \return The transfer.
+ */
+static selection_transfer_t *transfer_push(lua_State *L, int ref) {
+    lua_pushliteral(L, REGISTRY_TRANSFER_TABLE_INDEX);
+    lua_rawget(L, LUA_REGISTRYINDEX);
+    lua_rawgeti(L, -1, ref);
+    lua_remove(L, -2);
+    return lua_touserdata(L, -1);
+}
+
 static void transfer_done(lua_State *L, selection_transfer_t *transfer) {
     transfer->state = TRANSFER_DONE;
 
+    /* Their callbacks find the transfer through its reference */
+    if (transfer->read_source) {
+        g_source_remove(transfer->read_source);
+        transfer->read_source = 0;
+    }
+    if (transfer->timeout_source) {
+        g_source_remove(transfer->timeout_source);
+        transfer->timeout_source = 0;
+    }
+
+    if (transfer->fd >= 0) {
+        close(transfer->fd);
+        transfer->fd = -1;
+    }
+
     lua_pushliteral(L, REGISTRY_TRANSFER_TABLE_INDEX);
     lua_rawget(L, LUA_REGISTRYINDEX);
     luaL_unref(L, -1, transfer->ref);
@@ -102,6 +153,112 @@ static void transfer_done(lua_State *L, selection_transfer_t *transfer) {
     lua_pop(L, 1);
 }
 
+/** Read the next piece of a file transfer.
+ * \param transfer The transfer.
+ * \param buffer Where to store the data.
+ * \param length The size of the buffer.
+ * \return The number of bytes read, 0 at the end of the file or on error, -1
+ * if a pipe has no data yet.
+ */
+static ssize_t transfer_read(selection_transfer_t *transfer, char *buffer, size_t length) {
+    ssize_t done;
+
+    do
+        done = transfer->seekable ? pread(transfer->fd, buffer, length, transfer->offset)
+                                  : read(transfer->fd, buffer, length);
+    while (done < 0 && errno == EINTR);
+
+    if (done < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return -1;
+
+    if (done < 0) {
+        warn("Selection transfer failed to read its file: %s", strerror(errno));
+        return 0;
+    }
+
+    transfer->offset += done;
+    return done;
+}
+
+static void transfer_end_incremental(lua_State *L, selection_transfer_t *transfer) {
+    xcb_change_property(
+        globalconf.connection, XCB_PROP_MODE_REPLACE, transfer->requestor, transfer->property,
+        UTF8_STRING, 8, 0, NULL);
+    xcb_change_window_attributes(
+        globalconf.connection, transfer->requestor, XCB_CW_EVENT_MASK, (uint32_t[]) {0});
+    transfer_done(L, transfer);
+}
+
+/** Give up on a requestor which did not take the last piece in time */
+static gboolean transfer_timeout_cb(gpointer data) {
+    lua_State            *L        = globalconf_get_lua_State();
+    selection_transfer_t *transfer = transfer_push(L, GPOINTER_TO_INT(data));
+
+    transfer->timeout_source       = 0;
+    xcb_change_window_attributes(
+        globalconf.connection, transfer->requestor, XCB_CW_EVENT_MASK, (uint32_t[]) {0});
+    transfer_done(L, transfer);
+    lua_pop(L, 1);
+
+    return G_SOURCE_REMOVE;
+}
+
+/** Wait for the requestor to delete the property holding the last piece */
+static void transfer_wait_requestor(selection_transfer_t *transfer) {
+    if (transfer->timeout_source) g_source_remove(transfer->timeout_source);
+    transfer->timeout_source = g_timeout_add_seconds(
+        TRANSFER_TIMEOUT, transfer_timeout_cb, GINT_TO_POINTER(transfer->ref));
+}
+
+/** Send a piece of a file, or end the transfer when there is none */
+static void transfer_send_piece(
+    lua_State *L, selection_transfer_t *transfer, const char *buffer, size_t length) {
+    if (length > 0) {
+        xcb_change_property(
+            globalconf.connection, XCB_PROP_MODE_REPLACE, transfer->requestor, transfer->property,
+            UTF8_STRING, 8, length, buffer);
+        transfer_wait_requestor(transfer);
+    } else transfer_end_incremental(L, transfer);
+}
+
+/** Send the next piece of a pipe, once it has some data */
+static gboolean transfer_readable_cb(gint fd, GIOCondition condition, gpointer data) {
+    lua_State            *L        = globalconf_get_lua_State();
+    selection_transfer_t *transfer = transfer_push(L, GPOINTER_TO_INT(data));
+    size_t                length   = max_property_length();
+    char                 *buffer   = p_new(char, length);
+    ssize_t               done     = transfer_read(transfer, buffer, length);
+
+    if (done >= 0) {
+        transfer->read_source = 0;
+        transfer_send_piece(L, transfer, buffer, done);
+    }
+
+    p_delete(&buffer);
+    lua_pop(L, 1);
+
+    return done >= 0 ? G_SOURCE_REMOVE : G_SOURCE_CONTINUE;
+}
+
+/** Send the next piece of a file, the data never goes through Lua.
+ * Pipes are read from the main loop once they have data, never blocking it.
+ */
+static void transfer_continue_file(lua_State *L, selection_transfer_t *transfer) {
+    if (!transfer->seekable) {
+        if (!transfer->read_source)
+            transfer->read_source = g_unix_fd_add(
+                transfer->fd, G_IO_IN | G_IO_HUP | G_IO_ERR, transfer_readable_cb,
+                GINT_TO_POINTER(transfer->ref));
+        return;
+    }
+
+    size_t  length = max_property_length();
+    char   *buffer = p_new(char, length);
+    ssize_t done   = transfer_read(transfer, buffer, length);
+
+    transfer_send_piece(L, transfer, buffer, MAX(done, 0));
+    p_delete(&buffer);
+}
+
 static void transfer_continue_incremental(lua_State *L, int ud) {
     const char           *data;
     size_t                data_length;
@@ -109,6 +266,17 @@ static void transfer_continue_incremental(lua_State *L, int ud) {
 
     ud                             = luaA_absindex(L, ud);
 
+    /* The requestor took the last piece */
+    if (transfer->timeout_source) {
+        g_source_remove(transfer->timeout_source);
+        transfer->timeout_source = 0;
+    }
+
+    if (transfer->fd >= 0) {
+        transfer_continue_file(L, transfer);
+        return;
+    }
+
     /* Get the data that is to be sent next */
     lua_getiuservalue(L, ud, 1);
     lua_pushliteral(L, TRANSFER_DATA_INDEX);
@@ -128,12 +296,7 @@ static void transfer_continue_incremental(lua_State *L, int ud) {
             }
         }
         /* End of transfer */
-        xcb_change_property(
-            globalconf.connection, XCB_PROP_MODE_REPLACE, transfer->requestor, transfer->property,
-            UTF8_STRING, 8, 0, NULL);
-        xcb_change_window_attributes(
-            globalconf.connection, transfer->requestor, XCB_CW_EVENT_MASK, (uint32_t[]) {0});
-        transfer_done(L, transfer);
+        transfer_end_incremental(L, transfer);
     } else {
         /* Send next piece of data */
         assert(transfer->offset < data_length);
@@ -142,10 +305,57 @@ static void transfer_continue_incremental(lua_State *L, int ud) {
             globalconf.connection, XCB_PROP_MODE_REPLACE, transfer->requestor, transfer->property,
             UTF8_STRING, 8, next_length, &data[transfer->offset]);
         transfer->offset += next_length;
+        transfer_wait_requestor(transfer);
     }
     lua_pop(L, 1);
 }
 
+/** Ask Lua for the data, once the name of the target is known.
+ * \param L The Lua VM state.
+ * \param ud The selection acquire object.
+ * \param transfer_ud The transfer object.
+ */
+static void transfer_emit_request(lua_State *L, int ud, int transfer_ud) {
+    selection_transfer_t *transfer = lua_touserdata(L, transfer_ud);
+    const char           *name     = atomcache_name(transfer->target);
+
+    ud                             = luaA_absindex(L, ud);
+    transfer_ud                    = luaA_absindex(L, transfer_ud);
+
+    /* Emit the request signal with target and transfer object */
+    if (name) lua_pushstring(L, name);
+    else lua_pushnil(L);
+    lua_pushvalue(L, transfer_ud);
+    luna_object_emit_signal(L, ud, "request", 2);
+
+    /* Reject the transfer if Lua did not do anything */
+    if (transfer->state == TRANSFER_WAIT_FOR_DATA) {
+        selection_transfer_reject(
+            transfer->requestor, transfer->selection, transfer->target, transfer->time);
+        transfer_done(L, transfer);
+    }
+}
+
+static void transfer_target_name_cb(void *data) {
+    lua_State *L = globalconf_get_lua_State();
+
+    /* The transfer cannot be done before Lua saw it, so its reference is
+     * still valid */
+    transfer_push(L, GPOINTER_TO_INT(data));
+
+    /* Take the selection object back from the transfer */
+    lua_getiuservalue(L, -1, 1);
+    lua_pushliteral(L, TRANSFER_SELECTION_INDEX);
+    lua_rawget(L, -2);
+    lua_pushliteral(L, TRANSFER_SELECTION_INDEX);
+    lua_pushnil(L);
+    lua_rawset(L, -4);
+    lua_remove(L, -2);
+
+    transfer_emit_request(L, -1, -2);
+    lua_pop(L, 2);
+}
+
 void selection_transfer_begin(
     lua_State      *L,
     int             ud,
@@ -173,28 +383,98 @@ void selection_transfer_begin(
     transfer->ref = luaL_ref(L, -2);
     lua_pop(L, 1);
 
-    /* Get the atom name */
-    xcb_get_atom_name_reply_t *reply = xcb_get_atom_name_reply(
-        globalconf.connection, xcb_get_atom_name_unchecked(globalconf.connection, target), NULL);
-    if (reply) {
-        lua_pushlstring(L, xcb_get_atom_name_name(reply), xcb_get_atom_name_name_length(reply));
-        p_delete(&reply);
-    } else lua_pushnil(L);
-
-    /* Emit the request signal with target and transfer object */
-    lua_pushvalue(L, -2);
-    luna_object_emit_signal(L, ud, "request", 2);
-
-    /* Reject the transfer if Lua did not do anything */
-    if (transfer->state == TRANSFER_WAIT_FOR_DATA) {
-        selection_transfer_reject(requestor, selection, target, time);
-        transfer_done(L, transfer);
+    /* Get the atom name, waiting for it without blocking on a miss */
+    if (atomcache_fetch_names(
+            &target, 1, transfer_target_name_cb, GINT_TO_POINTER(transfer->ref)))
+        transfer_emit_request(L, ud, -1);
+    else {
+        lua_getiuservalue(L, -1, 1);
+        lua_pushliteral(L, TRANSFER_SELECTION_INDEX);
+        lua_pushvalue(L, ud);
+        lua_rawset(L, -3);
+        lua_pop(L, 1);
     }
 
     /* Remove the transfer object from the stack */
     lua_pop(L, 1);
 }
 
+/** Open the file to transfer, given as a `file` path or an `fd`.
+ * \param L The Lua VM state.
+ * \param transfer The transfer.
+ * \return The size of the file, or -1 if it is unknown.
+ */
+static off_t transfer_open_file(lua_State *L, selection_transfer_t *transfer) {
+    struct stat st;
+    int         fd;
+
+    lua_pushliteral(L, "file");
+    lua_rawget(L, 2);
+    if (lua_isstring(L, -1)) {
+        const char *path = lua_tostring(L, -1);
+        /* Opening a FIFO does not wait for a writer */
+        fd               = open(path, O_RDONLY | O_CLOEXEC | O_NONBLOCK);
+        if (fd < 0) luaL_error(L, "Cannot open '%s': %s", path, strerror(errno));
+    } else {
+        lua_pushliteral(L, "fd");
+        lua_rawget(L, 2);
+        if (!lua_isinteger(L, -1)) luaL_error(L, "The file descriptor must be an integer");
+        /* The caller keeps its own descriptor */
+        fd = fcntl(lua_tointeger(L, -1), F_DUPFD_CLOEXEC, 0);
+        if (fd == -1) luaL_error(L, "Invalid file descriptor: %s", strerror(errno));
+        lua_pop(L, 1);
+    }
+    lua_pop(L, 1);
+
+    transfer->fd       = fd;
+    transfer->offset   = 0;
+    transfer->seekable = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+
+    return transfer->seekable ? st.st_size : -1;
+}
+
+static void transfer_send_file(lua_State *L, selection_transfer_t *transfer) {
+    size_t max_length = max_property_length();
+    off_t  size       = transfer_open_file(L, transfer);
+
+    if (size >= 0 && (size_t)size < max_length) {
+        /* Small enough to be sent at once */
+        char   *buffer = p_new(char, size + 1);
+        ssize_t length = transfer_read(transfer, buffer, size);
+
+        xcb_change_property(
+            globalconf.connection, XCB_PROP_MODE_REPLACE, transfer->requestor, transfer->property,
+            UTF8_STRING, 8, MAX(length, 0), buffer);
+        p_delete(&buffer);
+    } else {
+        /* The size is only a lower bound: 0 for pipes, at most 4 GiB for files */
+        uint32_t incr_size = MIN(MAX(size, 0), (off_t)UINT32_MAX);
+
+        xcb_change_window_attributes(
+            globalconf.connection, transfer->requestor, XCB_CW_EVENT_MASK,
+            (uint32_t[]) {XCB_EVENT_MASK_PROPERTY_CHANGE});
+
+        xcb_change_property(
+            globalconf.connection, XCB_PROP_MODE_REPLACE, transfer->requestor, transfer->property,
+            INCR, 32, 1, (const uint32_t[]) {incr_size});
+
+        transfer->state = TRANSFER_INCREMENTAL_SENDING;
+        transfer_wait_requestor(transfer);
+    }
+
+    selection_transfer_notify(
+        transfer->requestor, transfer->selection, transfer->target, transfer->property,
+        transfer->time);
+    if (transfer->state != TRANSFER_INCREMENTAL_SENDING) transfer_done(L, transfer);
+}
+
+/** Send the data of a transfer.
+ *
+ * The table has either a `data` string, optionally with `continue` to send
+ * it in pieces, or a `data` table of atom names with `format = "atom"`, or a
+ * `file` path or `fd` whose content is streamed without going through Lua.
+ * Pipes are read as their data arrives, without blocking.
+ */
 static int luaA_selection_transfer_send(lua_State *L) {
     size_t data_length;
     bool   incr                    = false;
@@ -206,6 +486,19 @@ static int luaA_selection_transfer_send(lua_State *L) {
 
     luaA_checktable(L, 2);
 
+    lua_pushliteral(L, "file");
+    lua_rawget(L, 2);
+    lua_pushliteral(L, "fd");
+    lua_rawget(L, 2);
+    if (!lua_isnil(L, -1) || !lua_isnil(L, -2)) {
+        if (transfer->state != TRANSFER_WAIT_FOR_DATA)
+            luaL_error(L, "Cannot send a file as a piece of a transfer");
+        lua_pop(L, 2);
+        transfer_send_file(L, transfer);
+        return 0;
+    }
+    lua_pop(L, 2);
+
     lua_pushliteral(L, "continue");
     lua_rawget(L, 2);
     transfer->more_data = incr = lua_toboolean(L, -1);
@@ -255,18 +548,8 @@ static int luaA_selection_transfer_send(lua_State *L) {
             lua_pop(L, 1);
         }
 
-        xcb_intern_atom_cookie_t cookies[len];
-        xcb_atom_t               atoms[len];
-        for (size_t i = 0; i < len; i++) {
-            cookies[i] = xcb_intern_atom_unchecked(
-                globalconf.connection, false, atom_lengths[i], atom_strings[i]);
-        }
-        for (size_t i = 0; i < len; i++) {
-            xcb_intern_atom_reply_t *reply =
-                xcb_intern_atom_reply(globalconf.connection, cookies[i], NULL);
-            atoms[i] = reply ? reply->atom : XCB_NONE;
-            p_delete(&reply);
-        }
+        xcb_atom_t atoms[len];
+        atomcache_intern_many(len, atom_strings, atom_lengths, atoms);
 
         xcb_change_property(
             globalconf.connection, XCB_PROP_MODE_REPLACE, transfer->requestor, transfer->property,
@@ -297,6 +580,7 @@ static int luaA_selection_transfer_send(lua_State *L) {
 
             transfer->state  = TRANSFER_INCREMENTAL_SENDING;
             transfer->offset = 0;
+            transfer_wait_requestor(transfer);
         } else {
             xcb_change_property(
                 globalconf.connection, XCB_PROP_MODE_REPLACE, transfer->requestor,
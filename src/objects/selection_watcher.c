@@ -21,6 +21,7 @@
  */
 
 #include "objects/selection_watcher.h"
+#include "atomcache.h"
 #include "common/object.h"
 #include "globalconf.h"
 #include "luaa.h"
@@ -74,7 +75,6 @@ void event_handle_xfixes_selection_notify(xcb_generic_event_t *ev) {
 static int luaA_selection_watcher_new(lua_State *L) {
     size_t                   name_length;
     const char              *name;
-    xcb_intern_atom_reply_t *reply;
     selection_watcher_t     *selection;
 
     name                  = luaL_checklstring(L, 2, &name_length);
@@ -83,13 +83,7 @@ static int luaA_selection_watcher_new(lua_State *L) {
     selection->window     = XCB_NONE;
 
     /* Get the atom identifying the selection to watch */
-    reply                 = xcb_intern_atom_reply(
-        globalconf.connection,
-        xcb_intern_atom_unchecked(globalconf.connection, false, name_length, name), NULL);
-    if (reply) {
-        selection->selection = reply->atom;
-        p_delete(&reply);
-    }
+    selection->selection  = atomcache_intern(name, name_length);
 
     return 1;
 }
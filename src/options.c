@@ -21,6 +21,7 @@
 
 #include "options.h"
 #include "common/version.h"
+#include "eventlog.h"
 
 #include <unistd.h>
 #include <stdio.h>
@@ -393,7 +394,11 @@ exit_help(int exit_code)
   -a, --no-argb          disable client transparency support\n\
   -l  --api-level LEVEL  select a different API support level than the current version \n\
   -m, --screen on|off    enable or disable automatic screen creation (default: on)\n\
-  -r, --replace          replace an existing window manager\n");
+  -r, --replace          replace an existing window manager\n\
+      --record FILE      record incoming events to FILE\n\
+      --replay FILE      replay the events recorded in FILE and report latencies\n\
+      --replay-speed recorded|max\n\
+                         replay with the recorded timing or as fast as possible\n");
     exit(exit_code);
 }
 
@@ -417,6 +422,9 @@ options_check_args(int argc, char **argv, int *init_flags, string_array_t *paths
         { "screen"    , ARG   , NULL, 'm'  },
         { "api-level" , ARG   , NULL, 'l'  },
         { "reap"      , ARG   , NULL, '\1' },
+        { "record"    , ARG   , NULL, '\2' },
+        { "replay"    , ARG   , NULL, '\3' },
+        { "replay-speed", ARG , NULL, '\4' },
         { NULL        , NO_ARG, NULL, 0    }
     };
 
@@ -475,6 +483,15 @@ options_check_args(int argc, char **argv, int *init_flags, string_array_t *paths
           case '\1':
             /* Silently ignore --reap and its argument */
             break;
+          case '\2':
+            eventlog_set_record(optarg);
+            break;
+          case '\3':
+            eventlog_set_replay(optarg);
+            break;
+          case '\4':
+            eventlog_set_replay_speed(optarg);
+            break;
           default:
             if (! ((*init_flags) & INIT_FLAG_ALLOW_FALLBACK))
                 exit_help(EXIT_FAILURE);
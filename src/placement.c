@@ -0,0 +1,174 @@
+/*
+ * placement.c - native client placement helpers
+ *
+ * Copyright © 2026 Abigail Teague <ateague063@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* The free space of a screen is kept as a list of maximal rectangles: every
+ * free rectangle that is not contained in another free rectangle. Removing an
+ * obstacle splits each rectangle it intersects in (at most) four slabs, exactly
+ * like gears.geometry.rectangle.area_remove(), but slabs that are contained in
+ * another free rectangle are dropped right away. The list then only grows with
+ * the number of distinct free regions, instead of with every split.
+ *
+ * Only slabs can be contained in something: a rectangle that was maximal before
+ * the split and does not intersect the obstacle is not contained in any slab,
+ * since a slab is contained in the rectangle it was cut from.
+ */
+
+#include "placement.h"
+#include "common/array.h"
+#include "common/lualib.h"
+#include "luaa.h"
+
+typedef struct {
+    lua_Number x, y, width, height;
+} free_area_t;
+
+DO_ARRAY(free_area_t, free_area, DO_NOTHING)
+
+static inline bool free_area_intersects(const free_area_t *a, const free_area_t *b) {
+    return b->x < a->x + a->width && b->x + b->width > a->x && b->y < a->y + a->height &&
+           b->y + b->height > a->y;
+}
+
+/** Is `a` contained in `b`? */
+static inline bool free_area_contained(const free_area_t *a, const free_area_t *b) {
+    return a->x >= b->x && a->y >= b->y && a->x + a->width <= b->x + b->width &&
+           a->y + a->height <= b->y + b->height;
+}
+
+static free_area_t free_area_check(lua_State *L, int idx) {
+    free_area_t area;
+
+    luaA_checktable(L, idx);
+    area.x      = luaA_getopt_number(L, idx, "x", 0);
+    area.y      = luaA_getopt_number(L, idx, "y", 0);
+    area.width  = luaA_getopt_number(L, idx, "width", 0);
+    area.height = luaA_getopt_number(L, idx, "height", 0);
+
+    return area;
+}
+
+/** Remove an obstacle from the free space.
+ * \param areas The maximal free rectangles, updated in place.
+ * \param slabs Scratch space for the new rectangles.
+ * \param elem The obstacle.
+ */
+static void free_area_remove(free_area_array_t *areas, free_area_array_t *slabs,
+                             const free_area_t *elem) {
+    int kept = 0;
+
+    slabs->len = 0;
+
+    /* Same iteration order as area_remove(), the order of the result decides
+     * between free areas of the same size. */
+    for (int i = areas->len - 1; i >= 0; i--) {
+        free_area_t r = areas->tab[i];
+
+        if (!free_area_intersects(&r, elem)) continue;
+
+        lua_Number ix = MAX(r.x, elem->x), iy = MAX(r.y, elem->y);
+        lua_Number ir = MIN(r.x + r.width, elem->x + elem->width);
+        lua_Number ib = MIN(r.y + r.height, elem->y + elem->height);
+
+        if (ix > r.x) free_area_append(slabs, (free_area_t){r.x, r.y, ix - r.x, r.height});
+        if (iy > r.y) free_area_append(slabs, (free_area_t){r.x, r.y, r.width, iy - r.y});
+        if (ir < r.x + r.width)
+            free_area_append(slabs, (free_area_t){ir, r.y, r.x + r.width - ir, r.height});
+        if (ib < r.y + r.height)
+            free_area_append(slabs, (free_area_t){r.x, ib, r.width, r.y + r.height - ib});
+
+        areas->tab[i].width = -1;
+    }
+
+    /* Compact the rectangles that were not split */
+    for (int i = 0; i < areas->len; i++)
+        if (areas->tab[i].width >= 0) areas->tab[kept++] = areas->tab[i];
+    areas->len = kept;
+
+    for (int i = 0; i < slabs->len; i++) {
+        const free_area_t *s         = &slabs->tab[i];
+        bool               contained = false;
+
+        for (int j = 0; j < kept && !contained; j++)
+            contained = free_area_contained(s, &areas->tab[j]);
+
+        /* Of two equal slabs, keep the first one */
+        for (int j = 0; j < slabs->len && !contained; j++)
+            if (j != i && free_area_contained(s, &slabs->tab[j]))
+                contained = j < i || !free_area_contained(&slabs->tab[j], s);
+
+        if (!contained) free_area_append(areas, *s);
+    }
+}
+
+/** Get the free space left in an area by a list of obstacles.
+ *
+ * This returns the same free areas as successive calls to
+ * `gears.geometry.rectangle.area_remove`, without the ones which are contained
+ * in another free area.
+ *
+ * @tparam table area The area to place things in, usually a workarea.
+ * @tparam table obstacles A list of geometries to avoid.
+ * @treturn table The list of maximal free areas.
+ * @staticfct _placement_free_areas
+ */
+int luaA_placement_free_areas(lua_State *L) {
+    free_area_array_t areas, slabs;
+    free_area_t       area, *obstacles;
+    int               n;
+
+    /* Check all arguments before allocating anything */
+    area = free_area_check(L, 1);
+    luaA_checktable(L, 2);
+    n         = luaA_rawlen(L, 2);
+    obstacles = p_alloca(free_area_t, n + 1);
+    for (int i = 0; i < n; i++) {
+        lua_rawgeti(L, 2, i + 1);
+        obstacles[i] = free_area_check(L, -1);
+        lua_pop(L, 1);
+    }
+
+    free_area_array_init(&areas);
+    free_area_array_init(&slabs);
+
+    free_area_append(&areas, area);
+    for (int i = 0; i < n; i++) free_area_remove(&areas, &slabs, &obstacles[i]);
+
+    lua_createtable(L, areas.len, 0);
+    for (int i = 0; i < areas.len; i++) {
+        lua_createtable(L, 0, 4);
+        luaA_pushcoordinate(L, areas.tab[i].x);
+        lua_setfield(L, -2, "x");
+        luaA_pushcoordinate(L, areas.tab[i].y);
+        lua_setfield(L, -2, "y");
+        luaA_pushcoordinate(L, areas.tab[i].width);
+        lua_setfield(L, -2, "width");
+        luaA_pushcoordinate(L, areas.tab[i].height);
+        lua_setfield(L, -2, "height");
+        lua_rawseti(L, -2, i + 1);
+    }
+
+    free_area_array_wipe(&areas);
+    free_area_array_wipe(&slabs);
+
+    return 1;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -21,6 +21,7 @@
  */
 
 #include "property.h"
+#include "atomcache.h"
 #include "common/atoms.h"
 #include "common/signals.h"
 #include "common/xutil.h"
@@ -29,6 +30,7 @@
 #include "objects/drawin.h"
 #include "objects/selection_getter.h"
 #include "objects/selection_transfer.h"
+#include "xrdb.h"
 #include "xwindow.h"
 
 #include <xcb/xcb_atom.h>
@@ -332,6 +334,10 @@ static void property_handle_xrootpmap_id(uint8_t state, xcb_window_t window) {
     luna_emit_global_signal(L, "wallpaper_changed", 0);
 }
 
+static void property_handle_resource_manager(uint8_t state, xcb_window_t window) {
+    if (window == globalconf.screen->root) xrdb_refresh();
+}
+
 /** The property notify event handler handling xproperties.
  * \param ev The event.
  */
@@ -412,6 +418,9 @@ void property_handle_propertynotify(xcb_property_notify_event_t *ev) {
     /* background change */
     HANDLE(_XROOTPMAP_ID, property_handle_xrootpmap_id)
 
+    /* X resources change */
+    HANDLE(XCB_ATOM_RESOURCE_MANAGER, property_handle_resource_manager)
+
     /* selection transfers */
     HANDLE(AWESOME_SELECTION_ATOM, property_handle_awesome_selection_atom)
 
@@ -436,7 +445,6 @@ int luaA_register_xproperty(lua_State *L) {
     struct xproperty         property;
     struct xproperty        *found;
     const char *const        args[] = {"string", "number", "boolean"};
-    xcb_intern_atom_reply_t *atom_r;
     int                      type;
 
     name = luaL_checkstring(L, 1);
@@ -445,13 +453,8 @@ int luaA_register_xproperty(lua_State *L) {
     else if (type == 1) property.type = PROP_NUMBER;
     else property.type = PROP_BOOLEAN;
 
-    atom_r = xcb_intern_atom_reply(
-        globalconf.connection,
-        xcb_intern_atom_unchecked(globalconf.connection, false, a_strlen(name), name), NULL);
-    if (!atom_r) return 0;
-
-    property.atom = atom_r->atom;
-    p_delete(&atom_r);
+    property.atom = atomcache_intern(name, a_strlen(name));
+    if (property.atom == XCB_NONE) return 0;
 
     found = xproperty_array_lookup(&globalconf.xproperties, &property);
     if (found) {
@@ -46,6 +46,7 @@
 #include "common/xutil.h"
 #include "objects/button.h"
 #include "objects/key.h"
+#include "xkb.h"
 #include "xwindow.h"
 
 #include "math.h"
@@ -201,11 +202,11 @@ void root_update_wallpaper(void) {
 }
 
 static xcb_keycode_t _string_to_key_code(const char *s) {
-    xcb_keysym_t   keysym;
-    xcb_keycode_t *keycodes;
+    xcb_keysym_t         keysym;
+    const xcb_keycode_t *keycodes;
 
     keysym   = XStringToKeysym(s);
-    keycodes = xcb_key_symbols_get_keycode(globalconf.keysyms, keysym);
+    keycodes = xkb_get_keycodes(keysym);
 
     if (keycodes) {
         return keycodes[0]; /* XXX only returning the first is probably not
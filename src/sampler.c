@@ -0,0 +1,447 @@
+/*
+ * sampler.c - native /proc and /sys sampler
+ *
+ * Copyright © 2026 Abigail Teague <ateague063@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* System statistics for status bar widgets, without spawning anything.
+ *
+ * All files are opened once and read again with pread() at offset 0, which
+ * makes procfs and sysfs generate their content again. Counters (CPU time,
+ * network bytes) are turned into rates here, so that Lua only gets the values
+ * a widget displays. The devices in /sys/class are looked up again every
+ * SAMPLER_RESCAN samples to notice hotplugged batteries and the like.
+ */
+
+#include "sampler.h"
+#include "common/lualib.h"
+#include "common/util.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <glib.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SAMPLER_RESCAN 30
+
+#define POWER_SUPPLY_DIR "/sys/class/power_supply"
+#define THERMAL_DIR "/sys/class/thermal"
+
+/** A file which stays open between samples */
+typedef struct {
+    char *path;
+    int   fd;
+} sampler_file_t;
+
+/** CPU times of the previous sample */
+typedef struct {
+    uint64_t total, idle;
+} sampler_cpu_t;
+
+/** Network counters of the previous sample */
+typedef struct {
+    uint64_t rx, tx;
+} sampler_net_t;
+
+enum { POWER_STATUS, POWER_CAPACITY, POWER_ONLINE, POWER_ENERGY_NOW, POWER_POWER_NOW, POWER_COUNT };
+
+static const char *const power_attributes[POWER_COUNT] = {
+    [POWER_STATUS] = "status",         [POWER_CAPACITY] = "capacity",
+    [POWER_ONLINE] = "online",         [POWER_ENERGY_NOW] = "energy_now",
+    [POWER_POWER_NOW] = "power_now",
+};
+
+/** An entry of /sys/class/power_supply or a thermal zone */
+typedef struct {
+    char          *name;
+    char          *type;
+    sampler_file_t files[POWER_COUNT];
+} sampler_device_t;
+
+static struct {
+    sampler_file_t stat, meminfo, netdev;
+    /** Buffer for file contents, grown as needed */
+    char          *buf;
+    size_t         buf_size;
+    /** Previous CPU times, index 0 is the "cpu" line with the sum of all */
+    sampler_cpu_t *cpus;
+    int            cpu_count;
+    /** Interface name to sampler_net_t */
+    GHashTable    *net;
+    GPtrArray     *power_supplies;
+    GPtrArray     *thermal_zones;
+    gint64         last_time;
+    unsigned int   samples;
+} sampler = {
+    .stat    = {"/proc/stat", -1},
+    .meminfo = {"/proc/meminfo", -1},
+    .netdev  = {"/proc/net/dev", -1},
+};
+
+/** Read a whole file from the start.
+ * \param file The file, opened on first use.
+ * \return The content in sampler.buf, NUL-terminated, or NULL.
+ */
+static const char *sampler_read_file(sampler_file_t *file) {
+    size_t len = 0;
+
+    if (file->fd < 0) file->fd = open(file->path, O_RDONLY | O_CLOEXEC);
+    if (file->fd < 0) return NULL;
+
+    if (!sampler.buf) {
+        sampler.buf_size = 4096;
+        sampler.buf      = p_new(char, sampler.buf_size);
+    }
+
+    for (;;) {
+        ssize_t got = pread(file->fd, sampler.buf + len, sampler.buf_size - len - 1, len);
+
+        if (got < 0 && errno == EINTR) continue;
+        if (got < 0) {
+            /* The device may be gone, open it again next time */
+            close(file->fd);
+            file->fd = -1;
+            return NULL;
+        }
+        if (got == 0) break;
+
+        len += got;
+        if (len + 1 == sampler.buf_size) {
+            sampler.buf_size *= 2;
+            p_realloc(&sampler.buf, sampler.buf_size);
+        }
+    }
+
+    sampler.buf[len] = '\0';
+    return sampler.buf;
+}
+
+static void sampler_file_close(sampler_file_t *file) {
+    if (file->fd >= 0) close(file->fd);
+    g_free(file->path);
+    file->fd   = -1;
+    file->path = NULL;
+}
+
+static void sampler_device_free(gpointer data) {
+    sampler_device_t *device = data;
+
+    for (int i = 0; i < POWER_COUNT; i++) sampler_file_close(&device->files[i]);
+    g_free(device->name);
+    g_free(device->type);
+    g_free(device);
+}
+
+/** Read a small attribute file once, without keeping it open */
+static char *sampler_read_attribute(const char *dir, const char *name, const char *attribute) {
+    char *path = g_build_filename(dir, name, attribute, NULL);
+    char *content;
+
+    if (!g_file_get_contents(path, &content, NULL, NULL)) content = NULL;
+    else g_strchomp(content);
+    g_free(path);
+
+    return content;
+}
+
+/** List the devices of a /sys/class directory.
+ * \param dir The directory.
+ * \param prefix Only use the entries starting with this.
+ * \param attributes The attributes to keep open.
+ * \param count The number of attributes.
+ * \param type_attribute The attribute describing the device type.
+ */
+static GPtrArray *sampler_scan_devices(
+    const char *dir, const char *prefix, const char *const *attributes, int count,
+    const char *type_attribute) {
+    GPtrArray     *devices = g_ptr_array_new_with_free_func(sampler_device_free);
+    DIR           *d       = opendir(dir);
+    struct dirent *entry;
+
+    if (!d) return devices;
+
+    while ((entry = readdir(d))) {
+        sampler_device_t *device;
+
+        if (entry->d_name[0] == '.' || !g_str_has_prefix(entry->d_name, prefix)) continue;
+
+        device       = g_new0(sampler_device_t, 1);
+        device->name = g_strdup(entry->d_name);
+        device->type = sampler_read_attribute(dir, entry->d_name, type_attribute);
+        for (int i = 0; i < POWER_COUNT; i++) {
+            device->files[i].fd = -1;
+            if (i < count)
+                device->files[i].path = g_build_filename(dir, entry->d_name, attributes[i], NULL);
+        }
+        g_ptr_array_add(devices, device);
+    }
+    closedir(d);
+
+    return devices;
+}
+
+/** Push a counter difference divided by the elapsed time */
+static void sampler_push_rate(lua_State *L, uint64_t now, uint64_t before, double seconds) {
+    /* Counters can go back when an interface is recreated */
+    if (seconds > 0 && now >= before) lua_pushnumber(L, (now - before) / seconds);
+    else lua_pushnil(L);
+}
+
+static void sampler_push_cpu(lua_State *L) {
+    const char *content = sampler_read_file(&sampler.stat);
+    int         index   = 0;
+
+    if (!content) return;
+
+    lua_newtable(L);
+
+    for (const char *line = content; line && g_str_has_prefix(line, "cpu"); index++) {
+        uint64_t v[8] = {0}, total = 0, idle;
+        int      core = -1;
+
+        /* "cpu" is the sum, followed by "cpuN" for every core */
+        if (line[3] != ' ') core = atoi(line + 3);
+        sscanf(strchr(line, ' '), "%" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64
+                                  " %" SCNu64 " %" SCNu64 " %" SCNu64,
+               &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]);
+        for (int i = 0; i < countof(v); i++) total += v[i];
+        idle = v[3] + v[4];
+
+        if (index >= sampler.cpu_count) {
+            p_realloc(&sampler.cpus, index + 1);
+            sampler.cpus[index] = (sampler_cpu_t){0};
+            sampler.cpu_count   = index + 1;
+        }
+
+        /* Usage in percent since the previous sample */
+        if (sampler.cpus[index].total && total > sampler.cpus[index].total) {
+            uint64_t dt = total - sampler.cpus[index].total;
+            uint64_t di = idle - MIN(idle, sampler.cpus[index].idle);
+            lua_pushnumber(L, 100.0 * (dt - MIN(di, dt)) / dt);
+        } else {
+            lua_pushnil(L);
+        }
+        if (core < 0) lua_setfield(L, -2, "usage");
+        else lua_rawseti(L, -2, core + 1);
+
+        sampler.cpus[index] = (sampler_cpu_t){.total = total, .idle = idle};
+
+        line = strchr(line, '\n');
+        if (line) line++;
+    }
+
+    lua_setfield(L, -2, "cpu");
+}
+
+static void sampler_push_memory(lua_State *L) {
+    const char *content = sampler_read_file(&sampler.meminfo);
+    lua_Integer total = 0, available = -1;
+
+    if (!content) return;
+
+    lua_newtable(L);
+
+    for (const char *line = content; line && *line;) {
+        const char *colon = strchr(line, ':');
+        lua_Integer value;
+
+        if (!colon) break;
+        value = strtoll(colon + 1, NULL, 10);
+
+        /* All values are in KiB */
+        lua_pushlstring(L, line, colon - line);
+        lua_pushinteger(L, value);
+        lua_rawset(L, -3);
+
+        if (!strncmp(line, "MemTotal:", 9)) total = value;
+        else if (!strncmp(line, "MemAvailable:", 13)) available = value;
+
+        line = strchr(colon, '\n');
+        if (line) line++;
+    }
+
+    if (total > 0 && available >= 0) {
+        lua_pushnumber(L, 100.0 * (total - available) / total);
+        lua_setfield(L, -2, "usage");
+    }
+
+    lua_setfield(L, -2, "memory");
+}
+
+static void sampler_push_network(lua_State *L, double seconds) {
+    const char *content = sampler_read_file(&sampler.netdev);
+    const char *line;
+
+    if (!content) return;
+
+    if (!sampler.net) sampler.net = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+
+    lua_newtable(L);
+
+    /* Skip the two header lines */
+    line = strchr(content, '\n');
+    if (line) line = strchr(line + 1, '\n');
+
+    while (line && *++line) {
+        const char    *colon = strchr(line, ':');
+        const char    *name  = line;
+        uint64_t       v[9];
+        sampler_net_t *previous;
+        char          *key, *end;
+
+        if (!colon) break;
+        while (*name == ' ') name++;
+        key = g_strndup(name, colon - name);
+
+        /* rx: bytes packets errs drop fifo frame compressed multicast, then tx */
+        end = (char *)colon + 1;
+        for (int i = 0; i < countof(v); i++) v[i] = g_ascii_strtoull(end, &end, 10);
+        if (*end == ' ' || *end == '\n' || *end == '\0') {
+            lua_createtable(L, 0, 4);
+            lua_pushinteger(L, v[0]);
+            lua_setfield(L, -2, "rx_bytes");
+            lua_pushinteger(L, v[8]);
+            lua_setfield(L, -2, "tx_bytes");
+
+            previous = g_hash_table_lookup(sampler.net, key);
+            if (previous) {
+                sampler_push_rate(L, v[0], previous->rx, seconds);
+                lua_setfield(L, -2, "rx_rate");
+                sampler_push_rate(L, v[8], previous->tx, seconds);
+                lua_setfield(L, -2, "tx_rate");
+            } else {
+                previous = g_new(sampler_net_t, 1);
+                g_hash_table_insert(sampler.net, g_strdup(key), previous);
+            }
+            previous->rx = v[0];
+            previous->tx = v[8];
+
+            lua_setfield(L, -2, key);
+        }
+
+        g_free(key);
+        line = strchr(colon, '\n');
+    }
+
+    lua_setfield(L, -2, "network");
+}
+
+/** Push the content of an attribute, as a number if it is one */
+static void sampler_push_attribute(lua_State *L, sampler_file_t *file, double scale) {
+    const char *content = file->path ? sampler_read_file(file) : NULL;
+    char       *end;
+    long long   value;
+
+    if (!content) {
+        lua_pushnil(L);
+        return;
+    }
+
+    value = strtoll(content, &end, 10);
+    if (end != content && (*end == '\n' || *end == '\0')) {
+        if (scale == 1) lua_pushinteger(L, value);
+        else lua_pushnumber(L, value / scale);
+    } else {
+        lua_pushlstring(L, content, strcspn(content, "\n"));
+    }
+}
+
+static void sampler_push_power(lua_State *L) {
+    if (!sampler.power_supplies) return;
+
+    lua_newtable(L);
+    for (guint i = 0; i < sampler.power_supplies->len; i++) {
+        sampler_device_t *device = g_ptr_array_index(sampler.power_supplies, i);
+
+        lua_createtable(L, 0, POWER_COUNT + 1);
+        lua_pushstring(L, device->type);
+        lua_setfield(L, -2, "type");
+        for (int j = 0; j < POWER_COUNT; j++) {
+            sampler_push_attribute(L, &device->files[j], 1);
+            lua_setfield(L, -2, power_attributes[j]);
+        }
+        lua_setfield(L, -2, device->name);
+    }
+    lua_setfield(L, -2, "power");
+}
+
+static void sampler_push_thermal(lua_State *L) {
+    if (!sampler.thermal_zones) return;
+
+    lua_newtable(L);
+    for (guint i = 0; i < sampler.thermal_zones->len; i++) {
+        sampler_device_t *device = g_ptr_array_index(sampler.thermal_zones, i);
+
+        lua_createtable(L, 0, 2);
+        lua_pushstring(L, device->type);
+        lua_setfield(L, -2, "type");
+        /* millidegree Celsius */
+        sampler_push_attribute(L, &device->files[0], 1000);
+        lua_setfield(L, -2, "temperature");
+        lua_setfield(L, -2, device->name);
+    }
+    lua_setfield(L, -2, "thermal");
+}
+
+/** Sample the system statistics.
+ *
+ * This is used by `awful.sampler`, which calls it on a shared timer.
+ *
+ * The rates and usages are computed since the previous call and are nil on
+ * the first one. Sections which cannot be read are missing.
+ *
+ * @treturn table The statistics, with `time`, `cpu`, `memory`, `network`,
+ *  `power` and `thermal` keys.
+ * @staticfct _sampler_read
+ */
+int luaA_sampler_read(lua_State *L) {
+    static const char *const thermal_attributes[] = {"temp"};
+    gint64                   now                  = g_get_monotonic_time();
+    double                   seconds              = 0;
+
+    if (sampler.last_time) seconds = (now - sampler.last_time) / (double)G_USEC_PER_SEC;
+    sampler.last_time = now;
+
+    if (sampler.samples++ % SAMPLER_RESCAN == 0) {
+        if (sampler.power_supplies) g_ptr_array_unref(sampler.power_supplies);
+        if (sampler.thermal_zones) g_ptr_array_unref(sampler.thermal_zones);
+        sampler.power_supplies =
+            sampler_scan_devices(POWER_SUPPLY_DIR, "", power_attributes, POWER_COUNT, "type");
+        sampler.thermal_zones = sampler_scan_devices(
+            THERMAL_DIR, "thermal_zone", thermal_attributes, countof(thermal_attributes), "type");
+    }
+
+    lua_newtable(L);
+    lua_pushnumber(L, now / (double)G_USEC_PER_SEC);
+    lua_setfield(L, -2, "time");
+
+    sampler_push_cpu(L);
+    sampler_push_memory(L);
+    sampler_push_network(L, seconds);
+    sampler_push_power(L);
+    sampler_push_thermal(L);
+
+    return 1;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
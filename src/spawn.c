@@ -54,10 +54,16 @@
 
 #include "spawn.h"
 
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 
+#include <errno.h>
+#include <fcntl.h>
+#include <glib-unix.h>
 #include <glib.h>
+#include <signal.h>
+#include <string.h>
 #include <unistd.h>
 #include "common/lualib.h"
 #include "common/signals.h"
@@ -65,6 +71,30 @@
 /** 20 seconds timeout */
 #define AWESOME_SPAWN_TIMEOUT 20.0
 
+/** Size of the reads from the output of a child */
+#define SPAWN_READ_CHUNK 65536
+
+/** Use GLib's spawn functions instead of vfork() */
+static bool spawn_use_glib = false;
+
+/** A pipe from a child, read until end-of-file. */
+typedef struct {
+    int      fd;
+    /** Lua function called with the output */
+    int      callback;
+    /** Deliver complete lines as they arrive, or everything at the end */
+    bool     lines;
+    /** Maximum number of bytes kept, per line in line mode, 0 for no limit */
+    size_t   max_size;
+    /** Number of bytes kept so far, of the current line in line mode */
+    size_t   size;
+    bool     truncated;
+    /** Throwing away the rest of a line which was too long */
+    bool     skipping;
+    /** Incomplete line, or all of the output */
+    GString *buffer;
+} spawn_reader_t;
+
 /** Wrapper for unrefing startup sequence.
  */
 static inline void a_sn_startup_sequence_unref(SnStartupSequence **sss) {
@@ -76,6 +106,9 @@ DO_ARRAY(SnStartupSequence *, SnStartupSequence, a_sn_startup_sequence_unref)
 /** The array of startup sequence running */
 static SnStartupSequence_array_t sn_waits;
 
+/** A child which is reaped by us. Children started with vfork() and without an
+ * exit callback use LUA_NOREF as exit_callback.
+ */
 typedef struct {
     GPid pid;
     int  exit_callback;
@@ -246,6 +279,167 @@ static void spawn_callback(gpointer user_data) {
         unsetenv("DESKTOP_STARTUP_ID");
 }
 
+/** Make sure a pipe end is not one of the standard file descriptors, so that
+ * the child can dup2() its ends in any order.
+ * \param fd The file descriptor, closed if it is replaced.
+ * \return The file descriptor to use, with FD_CLOEXEC set.
+ */
+static int spawn_move_fd(int fd) {
+    int ret;
+
+    if (fd < 0 || fd > STDERR_FILENO) return fd;
+    ret = fcntl(fd, F_DUPFD_CLOEXEC, STDERR_FILENO + 1);
+    close(fd);
+    return ret;
+}
+
+static bool spawn_open_pipe(int fds[2], GError **error) {
+    if (!g_unix_open_pipe(fds, FD_CLOEXEC, error)) return false;
+
+    fds[0] = spawn_move_fd(fds[0]);
+    fds[1] = spawn_move_fd(fds[1]);
+    if (fds[0] < 0 || fds[1] < 0) {
+        g_set_error(
+            error, G_SPAWN_ERROR, G_SPAWN_ERROR_FAILED, "Failed to create pipe: %s",
+            g_strerror(errno));
+        if (fds[0] >= 0) close(fds[0]);
+        if (fds[1] >= 0) close(fds[1]);
+        fds[0] = fds[1] = -1;
+        return false;
+    }
+
+    return true;
+}
+
+/** Start a process with vfork() and execve().
+ *
+ * fork() has to copy the page tables of the whole awesome process, including
+ * the Lua heap and all the cairo surfaces, just to throw them away on exec().
+ * vfork() shares the memory with the child until it calls exec(), so the cost
+ * does not grow with the size of awesome. This behaves like
+ * g_spawn_async_with_pipes() with G_SPAWN_SEARCH_PATH, G_SPAWN_CLOEXEC_PIPES
+ * and spawn_callback() as child setup. The child is always reaped by
+ * reap_children().
+ *
+ * Everything that allocates is done before vfork(): between vfork() and exec()
+ * the child may only use async-signal-safe functions.
+ */
+static bool spawn_vfork(
+    gchar **argv, gchar **envp, SnLauncherContext *context, GPid *child_pid, int *stdin_fd,
+    int *stdout_fd, int *stderr_fd, GError **error) {
+    int          pipes[3][2] = {{-1, -1}, {-1, -1}, {-1, -1}};
+    int         *ret_fds[3]  = {stdin_fd, stdout_fd, stderr_fd};
+    int          child_fds[3];
+    gchar       *path, **env;
+    sigset_t     all_signals, old_mask;
+    volatile int child_errno = 0;
+    pid_t        pid;
+    bool         ok = false;
+
+    path = g_find_program_in_path(argv[0]);
+    if (!path) {
+        g_set_error(
+            error, G_SPAWN_ERROR, G_SPAWN_ERROR_NOENT,
+            "Failed to execute child process “%s” (%s)", argv[0], g_strerror(ENOENT));
+        return false;
+    }
+
+    env = envp ? g_strdupv(envp) : g_get_environ();
+    if (context)
+        env = g_environ_setenv(
+            env, "DESKTOP_STARTUP_ID", sn_launcher_context_get_startup_id(context), TRUE);
+    else if (!envp) /* Unset in case awesome was already started with this variable set */
+        env = g_environ_unsetenv(env, "DESKTOP_STARTUP_ID");
+
+    /* Without a pipe, stdin is /dev/null and stdout and stderr are inherited */
+    child_fds[0] = -1;
+    child_fds[1] = STDOUT_FILENO;
+    child_fds[2] = STDERR_FILENO;
+    for (int i = 0; i < 3; i++) {
+        if (!ret_fds[i]) continue;
+        if (!spawn_open_pipe(pipes[i], error)) goto out;
+        child_fds[i] = i == 0 ? pipes[i][0] : pipes[i][1];
+    }
+    if (child_fds[0] < 0) {
+        child_fds[0] = spawn_move_fd(open("/dev/null", O_RDONLY | O_CLOEXEC));
+        if (child_fds[0] < 0) {
+            g_set_error(
+                error, G_SPAWN_ERROR, G_SPAWN_ERROR_FAILED, "Failed to open /dev/null: %s",
+                g_strerror(errno));
+            goto out;
+        }
+    }
+
+    /* No signal handler may run in the child while it shares our memory */
+    sigfillset(&all_signals);
+    pthread_sigmask(SIG_SETMASK, &all_signals, &old_mask);
+
+    pid = vfork();
+    if (pid == 0) {
+        struct sigaction dfl = {.sa_handler = SIG_DFL};
+
+        for (int sig = 1; sig < NSIG; sig++) {
+            struct sigaction old;
+            if (sigaction(sig, NULL, &old) == 0 && old.sa_handler != SIG_DFL &&
+                old.sa_handler != SIG_IGN)
+                sigaction(sig, &dfl, NULL);
+        }
+        pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+
+        setsid();
+
+        for (int i = 0; i < 3; i++)
+            if (child_fds[i] != i && dup2(child_fds[i], i) < 0) {
+                child_errno = errno;
+                _exit(127);
+            }
+
+#ifdef SYS_close_range
+        /* GLib closes all other file descriptors too, most are FD_CLOEXEC */
+        syscall(SYS_close_range, STDERR_FILENO + 1, ~0U, 0);
+#endif
+
+        execve(path, argv, env);
+        child_errno = errno;
+        _exit(127);
+    }
+
+    pthread_sigmask(SIG_SETMASK, &old_mask, NULL);
+
+    if (pid < 0) {
+        g_set_error(
+            error, G_SPAWN_ERROR, G_SPAWN_ERROR_FORK, "Failed to fork (%s)", g_strerror(errno));
+        goto out;
+    }
+
+    if (child_errno) {
+        waitpid(pid, NULL, 0);
+        g_set_error(
+            error, G_SPAWN_ERROR, G_SPAWN_ERROR_FAILED,
+            "Failed to execute child process “%s” (%s)", argv[0],
+            g_strerror(child_errno));
+        goto out;
+    }
+
+    *child_pid = pid;
+    for (int i = 0; i < 3; i++)
+        if (ret_fds[i]) {
+            *ret_fds[i] = i == 0 ? pipes[i][1] : pipes[i][0];
+            pipes[i][i == 0 ? 1 : 0] = -1;
+        }
+    ok = true;
+
+out:
+    if (!stdin_fd && child_fds[0] >= 0) close(child_fds[0]);
+    for (int i = 0; i < 3; i++) {
+        if (pipes[i][0] >= 0) close(pipes[i][0]);
+        if (pipes[i][1] >= 0) close(pipes[i][1]);
+    }
+    g_strfreev(env);
+    g_free(path);
+    return ok;
+}
+
 /** Convert a Lua table of strings to a char** array.
  * \param L The Lua VM state.
  * \param idx The index of the table that we should parse.
@@ -319,6 +513,7 @@ void spawn_child_exited(pid_t pid, int status) {
     }
     exit_callback = child->exit_callback;
     running_child_array_remove(&running_children, child);
+    if (exit_callback == LUA_NOREF) return;
 
     /* 'Decode' the exit status */
     if (WIFEXITED(status)) {
@@ -335,6 +530,181 @@ void spawn_child_exited(pid_t pid, int status) {
     luaA_unregister(L, &exit_callback);
 }
 
+/** Push the complete lines of a reader's buffer as a table and drop them.
+ * \param L The Lua VM state.
+ * \param reader The reader.
+ * \param all Also push what follows the last newline, if anything.
+ */
+static void spawn_reader_push_lines(lua_State *L, spawn_reader_t *reader, bool all) {
+    const char *start = reader->buffer->str, *end = start + reader->buffer->len;
+    const char *newline;
+    int         count = 0;
+
+    lua_newtable(L);
+    while ((newline = memchr(start, '\n', end - start))) {
+        lua_pushlstring(L, start, newline - start);
+        lua_rawseti(L, -2, ++count);
+        start = newline + 1;
+    }
+    if (all && start < end) {
+        lua_pushlstring(L, start, end - start);
+        lua_rawseti(L, -2, ++count);
+        start = end;
+    }
+
+    g_string_erase(reader->buffer, 0, start - reader->buffer->str);
+}
+
+/** Call the Lua callback of a reader.
+ * \param reader The reader.
+ * \param done Whether this is the end of the output.
+ */
+static void spawn_reader_deliver(spawn_reader_t *reader, bool done) {
+    lua_State *L = globalconf_get_lua_State();
+
+    if (reader->lines) spawn_reader_push_lines(L, reader, done);
+    else if (done) {
+        /* Like lines which all got a newline appended */
+        if (reader->buffer->len && reader->buffer->str[reader->buffer->len - 1] != '\n')
+            g_string_append_c(reader->buffer, '\n');
+        lua_pushlstring(L, reader->buffer->str, reader->buffer->len);
+    } else return;
+
+    lua_pushboolean(L, done);
+    lua_pushboolean(L, reader->truncated);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, reader->callback);
+    luaA_dofunction(L, 3, 0);
+}
+
+static void spawn_reader_free(spawn_reader_t *reader) {
+    close(reader->fd);
+    luaA_unregister(globalconf_get_lua_State(), &reader->callback);
+    g_string_free(reader->buffer, TRUE);
+    p_delete(&reader);
+}
+
+/** Add some output to a reader in line mode.
+ * Each line is cut to the maximum size, and what follows until the next
+ * newline is thrown away.
+ * \param reader The reader.
+ * \param data The output.
+ * \param len The length of the output.
+ * \return Whether a line was completed.
+ */
+static bool spawn_reader_append_lines(spawn_reader_t *reader, const char *data, size_t len) {
+    const char *end      = data + len;
+    bool        complete = false;
+
+    while (data < end) {
+        const char *newline = memchr(data, '\n', end - data);
+        size_t      kept    = (newline ? newline : end) - data;
+
+        if (!reader->skipping) {
+            if (reader->max_size && reader->size + kept > reader->max_size) {
+                kept              = reader->max_size - reader->size;
+                reader->truncated = true;
+                reader->skipping  = true;
+            }
+            g_string_append_len(reader->buffer, data, kept);
+            reader->size += kept;
+        }
+        if (!newline) break;
+
+        g_string_append_c(reader->buffer, '\n');
+        reader->size     = 0;
+        reader->skipping = false;
+        complete         = true;
+        data             = newline + 1;
+    }
+
+    return complete;
+}
+
+/** Read what is available on a child's pipe.
+ * Output beyond the maximum size is read and thrown away, so that the child
+ * does not block on a full pipe.
+ */
+static gboolean spawn_reader_cb(gint fd, GIOCondition condition, gpointer data) {
+    static char     chunk[SPAWN_READ_CHUNK];
+    spawn_reader_t *reader = data;
+    ssize_t         len;
+    size_t          kept;
+
+    do
+        len = read(fd, chunk, sizeof(chunk));
+    while (len < 0 && errno == EINTR);
+
+    if (len < 0 && errno == EAGAIN) return G_SOURCE_CONTINUE;
+
+    if (len <= 0) {
+        if (len < 0) warn("Error reading the output of a child: %s", strerror(errno));
+        spawn_reader_deliver(reader, true);
+        spawn_reader_free(reader);
+        return G_SOURCE_REMOVE;
+    }
+
+    if (reader->lines) {
+        if (spawn_reader_append_lines(reader, chunk, len)) spawn_reader_deliver(reader, false);
+        return G_SOURCE_CONTINUE;
+    }
+
+    kept = len;
+    if (reader->max_size && reader->size + kept > reader->max_size) {
+        kept              = reader->max_size - reader->size;
+        reader->truncated = true;
+    }
+    if (!kept) return G_SOURCE_CONTINUE;
+
+    reader->size += kept;
+    g_string_append_len(reader->buffer, chunk, kept);
+
+    return G_SOURCE_CONTINUE;
+}
+
+/** Read the output of a child.
+ *
+ * The file descriptor is read in large chunks until end-of-file and closed.
+ * In line mode, the callback is called with a table of the new complete lines,
+ * without their newline, every time some arrive. Otherwise it is only called
+ * once, with all of the output as a string, each line ending with a newline.
+ * The last call gets `true` as second argument, and whether output was
+ * discarded because of the maximum size as third argument.
+ *
+ * @tparam integer fd The file descriptor, as returned by `spawn`.
+ * @tparam function callback The function called with the output.
+ * @tparam[opt=false] boolean lines Deliver the lines as they arrive.
+ * @tparam[opt=0] integer max_size The maximum number of bytes to keep, of each
+ *   line in line mode, 0 for no limit.
+ * @noreturn
+ * @staticfct _spawn_read
+ */
+int luaA_spawn_read(lua_State *L) {
+    int             fd       = luaL_checkinteger(L, 1);
+    bool            lines    = lua_toboolean(L, 3);
+    lua_Integer     max_size = luaL_optinteger(L, 4, 0);
+    spawn_reader_t *reader;
+    int             flags;
+
+    luaA_checkfunction(L, 2);
+    if (max_size < 0) return luaL_error(L, "invalid maximum size: %d", (int)max_size);
+
+    flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+        return luaL_error(L, "invalid file descriptor %d: %s", fd, strerror(errno));
+
+    reader           = p_new(spawn_reader_t, 1);
+    reader->fd       = fd;
+    reader->callback = LUA_REFNIL;
+    reader->lines    = lines;
+    reader->max_size = max_size;
+    reader->buffer   = g_string_new(NULL);
+    luaA_registerfct(L, 2, &reader->callback);
+
+    g_unix_fd_add(fd, G_IO_IN | G_IO_HUP | G_IO_ERR, spawn_reader_cb, reader);
+
+    return 0;
+}
+
 /** Spawn a program.
  * The program will be started on the default screen.
  *
@@ -413,9 +783,12 @@ int luaA_spawn(lua_State *L) {
     }
 
     flags |= G_SPAWN_SEARCH_PATH | G_SPAWN_CLOEXEC_PIPES;
-    retval = g_spawn_async_with_pipes(
-        NULL, argv, envp, flags, spawn_callback, context, &pid, stdin_ptr, stdout_ptr, stderr_ptr,
-        &error);
+    if (spawn_use_glib)
+        retval = g_spawn_async_with_pipes(
+            NULL, argv, envp, flags, spawn_callback, context, &pid, stdin_ptr, stdout_ptr,
+            stderr_ptr, &error);
+    else
+        retval = spawn_vfork(argv, envp, context, &pid, stdin_ptr, stdout_ptr, stderr_ptr, &error);
     g_strfreev(argv);
     g_strfreev(envp);
     if (!retval) {
@@ -430,6 +803,10 @@ int luaA_spawn(lua_State *L) {
         running_child_t child = {.pid = pid, .exit_callback = LUA_REFNIL};
         luaA_registerfct(L, 6, &child.exit_callback);
         running_child_array_insert(&running_children, child);
+    } else if (!spawn_use_glib) {
+        /* GLib double-forks so that the child is not ours, vfork() does not */
+        running_child_t child = {.pid = pid, .exit_callback = LUA_NOREF};
+        running_child_array_insert(&running_children, child);
     }
 
     /* push pid on stack */
@@ -449,4 +826,29 @@ int luaA_spawn(lua_State *L) {
     return 5;
 }
 
+/** Select how awesome.spawn() starts processes.
+ *
+ * This is meant for benchmarking and bisecting. `"vfork"` is the default,
+ * `"glib"` uses GLib's spawn functions, which fork().
+ *
+ * @tparam[opt] string backend Either `"vfork"` or `"glib"`.
+ * @treturn string The previous backend.
+ * @staticfct _spawn_backend
+ */
+int luaA_spawn_backend(lua_State *L) {
+    lua_pushstring(L, spawn_use_glib ? "glib" : "vfork");
+
+    if (!lua_isnoneornil(L, 1)) {
+        const char *backend = luaL_checkstring(L, 1);
+        if (A_STREQ(backend, "glib"))
+            spawn_use_glib = true;
+        else if (A_STREQ(backend, "vfork"))
+            spawn_use_glib = false;
+        else
+            return luaL_error(L, "unknown spawn backend: %s", backend);
+    }
+
+    return 1;
+}
+
 // vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -28,6 +28,8 @@
 void spawn_init(void);
 void spawn_start_notify(client_t *, const char *);
 int  luaA_spawn(lua_State *);
+int  luaA_spawn_backend(lua_State *);
+int  luaA_spawn_read(lua_State *);
 void spawn_child_exited(pid_t, int);
 
 #endif
@@ -137,6 +137,7 @@ int systray_request_handle(xcb_window_t embed_win) {
     xcb_change_save_set(globalconf.connection, XCB_SET_MODE_INSERT, embed_win);
     xcb_reparent_window(globalconf.connection, embed_win, globalconf.systray.window, 0, 0);
 
+    p_clear(&em, 1);
     em.win = embed_win;
 
     if (!xembed_info_get_reply(globalconf.connection, em_cookie, &em.info)) {
@@ -145,12 +146,17 @@ int systray_request_handle(xcb_window_t embed_win) {
         em.info.flags   = XEMBED_MAPPED;
     }
 
+    /* The window may still be mapped; start from a known state so that
+     * systray_update() only has to send what changed. It maps the window if
+     * XEMBED_MAPPED is set. */
+    xcb_unmap_window(globalconf.connection, em.win);
+
     xembed_embedded_notify(
         globalconf.connection, em.win, globalconf.timestamp, globalconf.systray.window,
         MIN(XEMBED_VERSION, em.info.version));
 
     xembed_window_array_append(&globalconf.embedded, em);
-    luaA_systray_invalidate();
+    systray_embed_update(&globalconf.embedded.tab[globalconf.embedded.len - 1], false);
 
     return 0;
 }
@@ -218,11 +224,26 @@ int xembed_process_client_message(xcb_client_message_event_t *ev) {
     return 0;
 }
 
-static int systray_num_visible_entries(void) {
-    int result = 0;
-    foreach (em, globalconf.embedded)
-        if (em->info.flags & XEMBED_MAPPED) result++;
-    return result;
+/** Update the systray after the XEMBED_MAPPED flag of a window changed.
+ * The caller sets em->mapped if it mapped or unmapped the window itself.
+ * \param em The embedded window.
+ * \param was_mapped Whether the flag was set before.
+ */
+void systray_embed_update(xembed_window_t *em, bool was_mapped) {
+    bool mapped = em->info.flags & XEMBED_MAPPED;
+
+    globalconf.systray.visible += mapped - was_mapped;
+    luaA_systray_invalidate();
+}
+
+/** Forget an embedded window.
+ * \param i The index of the window.
+ */
+void systray_embed_remove(int i) {
+    xembed_window_t em = xembed_window_array_take(&globalconf.embedded, i);
+
+    if (em.info.flags & XEMBED_MAPPED) globalconf.systray.visible--;
+    luaA_systray_invalidate();
 }
 
 /** Inform lua that the systray needs to be updated.
@@ -232,7 +253,7 @@ void luaA_systray_invalidate(void) {
     luna_emit_global_signal(L, ":systray.update", 0);
 
     /* Unmap now if the systray became empty */
-    if (systray_num_visible_entries() == 0)
+    if (globalconf.systray.visible == 0)
         xcb_unmap_window(globalconf.connection, globalconf.systray.window);
 }
 
@@ -246,7 +267,7 @@ static void systray_update(
     if (base_size <= 0) return;
 
     /* Give the systray window the correct size */
-    int      num_entries    = systray_num_visible_entries();
+    int      num_entries    = globalconf.systray.visible;
     int      cols           = (num_entries + rows - 1) / rows;
     uint32_t config_vals[4] = {0, 0, 0, 0};
     if (horizontal) {
@@ -256,13 +277,17 @@ static void systray_update(
         config_vals[0] = base_size * rows + spacing * (rows - 1);
         config_vals[1] = base_size * cols + spacing * (cols - 1);
     }
-    xcb_configure_window(
-        globalconf.connection, globalconf.systray.window,
-        XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, config_vals);
+    if (config_vals[0] != globalconf.systray.width || config_vals[1] != globalconf.systray.height) {
+        globalconf.systray.width  = config_vals[0];
+        globalconf.systray.height = config_vals[1];
+        xcb_configure_window(
+            globalconf.connection, globalconf.systray.window,
+            XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, config_vals);
+    }
 
-    /* Now resize each embedded window */
-    config_vals[0] = config_vals[1] = 0;
-    config_vals[2] = config_vals[3] = base_size;
+    /* Now move and resize the embedded windows whose slot changed */
+    int16_t x = 0, y = 0;
+    int     n = 0;
     for (int i = 0; i < globalconf.embedded.len; i++) {
         xembed_window_t *em;
 
@@ -270,30 +295,42 @@ static void systray_update(
         else em = &globalconf.embedded.tab[i];
 
         if (!(em->info.flags & XEMBED_MAPPED)) {
-            xcb_unmap_window(globalconf.connection, em->win);
+            if (em->mapped) xcb_unmap_window(globalconf.connection, em->win);
+            em->mapped = false;
             continue;
         }
 
-        xcb_configure_window(
-            globalconf.connection, em->win,
-            XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH |
-                XCB_CONFIG_WINDOW_HEIGHT,
-            config_vals);
-        xcb_map_window(globalconf.connection, em->win);
+        if (em->x != x || em->y != y || em->size != base_size) {
+            em->x          = x;
+            em->y          = y;
+            em->size       = base_size;
+            config_vals[0] = x;
+            config_vals[1] = y;
+            config_vals[2] = config_vals[3] = base_size;
+            xcb_configure_window(
+                globalconf.connection, em->win,
+                XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH |
+                    XCB_CONFIG_WINDOW_HEIGHT,
+                config_vals);
+        }
+        if (!em->mapped) xcb_map_window(globalconf.connection, em->win);
+        em->mapped = true;
         if (force_redraw) xcb_clear_area(globalconf.connection, 1, em->win, 0, 0, 0, 0);
-        if (i % rows == rows - 1) {
+
+        /* The slots are counted among the visible windows only */
+        if (n++ % rows == rows - 1) {
             if (horizontal) {
-                config_vals[0] += base_size + spacing;
-                config_vals[1] = 0;
+                x += base_size + spacing;
+                y = 0;
             } else {
-                config_vals[0] = 0;
-                config_vals[1] += base_size + spacing;
+                x = 0;
+                y += base_size + spacing;
             }
         } else {
             if (horizontal) {
-                config_vals[1] += base_size + spacing;
+                y += base_size + spacing;
             } else {
-                config_vals[0] += base_size + spacing;
+                x += base_size + spacing;
             }
         }
     }
@@ -354,13 +391,13 @@ int luaA_systray(lua_State *L) {
 
         globalconf.systray.parent = w;
 
-        if (systray_num_visible_entries() != 0) {
+        if (globalconf.systray.visible != 0) {
             systray_update(base_size, horiz, revers, spacing, force_redraw, rows);
             xcb_map_window(globalconf.connection, globalconf.systray.window);
         }
     }
 
-    lua_pushinteger(L, systray_num_visible_entries());
+    lua_pushinteger(L, globalconf.systray.visible);
     luna_object_push(L, globalconf.systray.parent);
     return 2;
 }
@@ -33,6 +33,8 @@ bool systray_iskdedockapp(xcb_window_t);
 int  systray_process_client_message(xcb_client_message_event_t *);
 int  xembed_process_client_message(xcb_client_message_event_t *);
 int  luaA_systray(lua_State *);
+void systray_embed_update(xembed_window_t *, bool);
+void systray_embed_remove(int);
 void luaA_systray_invalidate(void);
 
 #endif
@@ -25,6 +25,7 @@
  */
 
 #include "xkb.h"
+#include "atomcache.h"
 #include "common/atoms.h"
 #include "common/lualib.h"
 #include "common/signals.h"
@@ -32,6 +33,7 @@
 #include "objects/client.h"
 #include "xwindow.h"
 
+#include <glib.h>
 #include <xcb/xkb.h>
 #include <xkbcommon/xkbcommon-x11.h>
 #include <xkbcommon/xkbcommon.h>
@@ -109,25 +111,110 @@ int luaA_xkb_get_group_names(lua_State *L) {
         buffer, name_r->nTypes, name_r->indicators, name_r->virtualMods, name_r->groupNames,
         name_r->nKeys, name_r->nKeyAliases, name_r->nRadioGroups, name_r->which, &name_list);
 
-    xcb_get_atom_name_cookie_t atom_name_c;
-    atom_name_c = xcb_get_atom_name_unchecked(globalconf.connection, name_list.symbolsName);
-    xcb_get_atom_name_reply_t *atom_name_r;
-    atom_name_r = xcb_get_atom_name_reply(globalconf.connection, atom_name_c, NULL);
-    if (!atom_name_r) {
+    const char *name = atomcache_get_name(name_list.symbolsName);
+    free(name_r);
+    if (!name) {
         luaA_warn(L, "Failed to get atom symbols name");
-        free(name_r);
         return 0;
     }
 
-    const char *name     = xcb_get_atom_name_name(atom_name_r);
-    size_t      name_len = xcb_get_atom_name_name_length(atom_name_r);
-    lua_pushlstring(L, name, name_len);
-
-    free(atom_name_r);
-    free(name_r);
+    lua_pushstring(L, name);
     return 1;
 }
 
+/** Number of compiled keymaps kept for when a layout comes back */
+#define XKB_KEYMAP_CACHE_SIZE 8
+
+/** A compiled keymap and the tables derived from it */
+typedef struct {
+    /** The RMLVO names it was compiled for */
+    char              *rmlvo;
+    struct xkb_keymap *keymap;
+    /** Keycodes by keysym, built on first use */
+    GHashTable        *keycodes;
+} xkb_keymap_entry_t;
+
+/** Keymaps by RMLVO names */
+static GHashTable         *keymap_cache   = NULL;
+/** The entry of the keymap in use */
+static xkb_keymap_entry_t *current_keymap = NULL;
+
+static void xkb_keymap_entry_free(gpointer data) {
+    xkb_keymap_entry_t *entry = data;
+
+    if (entry == current_keymap) current_keymap = NULL;
+    xkb_keymap_unref(entry->keymap);
+    if (entry->keycodes) g_hash_table_destroy(entry->keycodes);
+    g_free(entry->rmlvo);
+    p_delete(&entry);
+}
+
+static void xkb_keycode_array_free(gpointer data) {
+    g_array_free(data, true);
+}
+
+static void xkb_keymap_add_key(struct xkb_keymap *keymap, xkb_keycode_t keycode, void *data) {
+    GHashTable        *keycodes = data;
+    xkb_layout_index_t layouts  = xkb_keymap_num_layouts_for_key(keymap, keycode);
+
+    /* X keycodes are 8 bits */
+    if (keycode > UINT8_MAX) return;
+
+    for (xkb_layout_index_t layout = 0; layout < layouts; layout++) {
+        /* The core keyboard mapping only has the first two levels */
+        xkb_level_index_t levels = MIN(xkb_keymap_num_levels_for_key(keymap, keycode, layout), 2);
+
+        for (xkb_level_index_t level = 0; level < levels; level++) {
+            const xkb_keysym_t *syms;
+            int nsyms = xkb_keymap_key_get_syms_by_level(keymap, keycode, layout, level, &syms);
+
+            for (int i = 0; i < nsyms; i++) {
+                GArray *array = g_hash_table_lookup(keycodes, GUINT_TO_POINTER(syms[i]));
+                if (!array) {
+                    array = g_array_new(true, false, sizeof(xcb_keycode_t));
+                    g_hash_table_insert(keycodes, GUINT_TO_POINTER(syms[i]), array);
+                }
+
+                xcb_keycode_t kc = keycode;
+                if (array->len == 0 || g_array_index(array, xcb_keycode_t, array->len - 1) != kc)
+                    g_array_append_val(array, kc);
+            }
+        }
+    }
+}
+
+/** Get the keycodes producing a keysym in the current keymap.
+ *
+ * This replaces xcb_key_symbols_get_keycode(), which searches the whole
+ * mapping on every call. The table is built once per keymap and kept with it
+ * in the cache. Without XKB, the keymap is compiled from names and may not
+ * match the server, so the core mapping is searched instead.
+ *
+ * \param keysym The keysym.
+ * \return A zero-terminated array, valid until the next call, or NULL.
+ */
+const xcb_keycode_t *xkb_get_keycodes(xcb_keysym_t keysym) {
+    if (!globalconf.have_xkb) {
+        static xcb_keycode_t *core_keycodes = NULL;
+
+        p_delete(&core_keycodes);
+        core_keycodes = xcb_key_symbols_get_keycode(globalconf.keysyms, keysym);
+        return core_keycodes;
+    }
+
+    if (!current_keymap) return NULL;
+
+    if (!current_keymap->keycodes) {
+        current_keymap->keycodes =
+            g_hash_table_new_full(NULL, NULL, NULL, xkb_keycode_array_free);
+        xkb_keymap_key_for_each(
+            current_keymap->keymap, xkb_keymap_add_key, current_keymap->keycodes);
+    }
+
+    GArray *array = g_hash_table_lookup(current_keymap->keycodes, GUINT_TO_POINTER(keysym));
+    return array ? (const xcb_keycode_t *)array->data : NULL;
+}
+
 static bool fill_rmlvo_from_root(struct xkb_rule_names *xkb_names) {
     xcb_get_property_reply_t *prop_reply = xcb_get_property_reply(
         globalconf.connection,
@@ -171,6 +258,111 @@ static bool fill_rmlvo_from_root(struct xkb_rule_names *xkb_names) {
     return true;
 }
 
+/** Check a cached keymap against the core keyboard mapping of the server.
+ *
+ * setxkbmap writes the RMLVO names after changing the mapping, so the names
+ * read when reloading can still be the previous ones. The first two levels of
+ * the first layout are compared, which tells keymaps for other names apart.
+ *
+ * \param keymap The cached keymap.
+ * \return Whether the server has the same symbols.
+ */
+static bool xkb_keymap_matches_server(struct xkb_keymap *keymap) {
+    const xcb_setup_t                *setup = xcb_get_setup(globalconf.connection);
+    xcb_keycode_t                     min   = setup->min_keycode;
+    xcb_keycode_t                     max   = setup->max_keycode;
+    xcb_get_keyboard_mapping_reply_t *reply = xcb_get_keyboard_mapping_reply(
+        globalconf.connection,
+        xcb_get_keyboard_mapping_unchecked(globalconf.connection, min, max - min + 1), NULL);
+
+    if (!reply) return false;
+
+    xcb_keysym_t *core    = xcb_get_keyboard_mapping_keysyms(reply);
+    int           per     = reply->keysyms_per_keycode;
+    bool          matches = true;
+
+    for (int keycode = min; matches && keycode <= max; keycode++) {
+        xkb_level_index_t levels = 0;
+        if (xkb_keymap_num_layouts_for_key(keymap, keycode) > 0)
+            levels = MIN(xkb_keymap_num_levels_for_key(keymap, keycode, 0), 2);
+
+        for (int level = 0; matches && level < (int)levels && level < per; level++) {
+            const xkb_keysym_t *syms;
+            int nsyms = xkb_keymap_key_get_syms_by_level(keymap, keycode, 0, level, &syms);
+
+            matches = core[(keycode - min) * per + level] ==
+                      (nsyms > 0 ? syms[0] : XKB_KEY_NoSymbol);
+        }
+    }
+
+    p_delete(&reply);
+    return matches;
+}
+
+/** Get the keymap for the current RMLVO names, compiling it if needed.
+ *
+ * A cached keymap is only reused when the names changed, i.e. when switching
+ * back to a layout, and the server has the same symbols. The same names being
+ * reported again means the mapping was changed some other way, such as with
+ * xmodmap, so it is compiled again.
+ *
+ * \param device_id The core keyboard, or -1 to compile from the names.
+ * \return The entry, also stored as current_keymap.
+ */
+static xkb_keymap_entry_t *xkb_get_keymap(int32_t device_id) {
+    struct xkb_rule_names names = {NULL, NULL, NULL, NULL, NULL};
+    bool                  found = fill_rmlvo_from_root(&names);
+    xkb_keymap_entry_t   *entry = NULL;
+    char                 *rmlvo = g_strdup_printf(
+        "%s\n%s\n%s\n%s\n%s", NONULL(names.rules), NONULL(names.model), NONULL(names.layout),
+        NONULL(names.variant), NONULL(names.options));
+
+    if (!keymap_cache)
+        keymap_cache = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, xkb_keymap_entry_free);
+
+    if (found && !(current_keymap && A_STREQ(current_keymap->rmlvo, rmlvo)))
+        entry = g_hash_table_lookup(keymap_cache, rmlvo);
+
+    /* The names may be stale, the entry is then replaced */
+    if (entry && device_id != -1 && !xkb_keymap_matches_server(entry->keymap)) entry = NULL;
+
+    if (!entry) {
+        struct xkb_keymap *xkb_keymap;
+
+        if (device_id != -1) {
+            xkb_keymap = xkb_x11_keymap_new_from_device(
+                globalconf.xkb_ctx, globalconf.connection, device_id, XKB_KEYMAP_COMPILE_NO_FLAGS);
+            if (!xkb_keymap) fatal("Failed while getting XKB keymap from device");
+        } else {
+            if (!found)
+                warn("Could not get _XKB_RULES_NAMES from root window, falling back to defaults.");
+            xkb_keymap = xkb_keymap_new_from_names(globalconf.xkb_ctx, &names, 0);
+            if (!xkb_keymap) fatal("Failed while creating XKB keymap");
+        }
+
+        if (g_hash_table_size(keymap_cache) >= XKB_KEYMAP_CACHE_SIZE &&
+            !g_hash_table_contains(keymap_cache, rmlvo))
+            g_hash_table_remove_all(keymap_cache);
+
+        entry         = p_new(xkb_keymap_entry_t, 1);
+        entry->rmlvo  = rmlvo;
+        entry->keymap = xkb_keymap;
+        rmlvo         = NULL;
+        g_hash_table_replace(keymap_cache, entry->rmlvo, entry);
+    }
+
+    current_keymap = entry;
+
+    g_free(rmlvo);
+    p_delete(&names.rules);
+    p_delete(&names.model);
+    p_delete(&names.layout);
+    p_delete(&names.variant);
+    p_delete(&names.options);
+
+    return entry;
+}
+
 /** Fill globalconf.xkb_state based on connection and context
  */
 static void xkb_fill_state(void) {
@@ -182,34 +374,14 @@ static void xkb_fill_state(void) {
         if (device_id == -1) warn("Failed while getting XKB device id");
     }
 
-    if (device_id != -1) {
-        struct xkb_keymap *xkb_keymap = xkb_x11_keymap_new_from_device(
-            globalconf.xkb_ctx, conn, device_id, XKB_KEYMAP_COMPILE_NO_FLAGS);
-
-        if (!xkb_keymap) fatal("Failed while getting XKB keymap from device");
+    xkb_keymap_entry_t *entry = xkb_get_keymap(device_id);
 
-        globalconf.xkb_state = xkb_x11_state_new_from_device(xkb_keymap, conn, device_id);
+    if (device_id != -1) {
+        globalconf.xkb_state = xkb_x11_state_new_from_device(entry->keymap, conn, device_id);
         if (!globalconf.xkb_state) fatal("Failed while getting XKB state from device");
-
-        /* xkb_keymap is no longer referenced directly; decreasing refcount */
-        xkb_keymap_unref(xkb_keymap);
     } else {
-        struct xkb_rule_names names = {NULL, NULL, NULL, NULL, NULL};
-        if (!fill_rmlvo_from_root(&names))
-            warn("Could not get _XKB_RULES_NAMES from root window, falling back to defaults.");
-
-        struct xkb_keymap *xkb_keymap = xkb_keymap_new_from_names(globalconf.xkb_ctx, &names, 0);
-
-        globalconf.xkb_state          = xkb_state_new(xkb_keymap);
+        globalconf.xkb_state = xkb_state_new(entry->keymap);
         if (!globalconf.xkb_state) fatal("Failed while creating XKB state");
-
-        /* xkb_keymap is no longer referenced directly; decreasing refcount */
-        xkb_keymap_unref(xkb_keymap);
-        p_delete(&names.rules);
-        p_delete(&names.model);
-        p_delete(&names.layout);
-        p_delete(&names.variant);
-        p_delete(&names.options);
     }
 }
 
@@ -228,6 +400,8 @@ static void xkb_init_keymap(void) {
  */
 static void xkb_free_keymap(void) {
     xkb_state_unref(globalconf.xkb_state);
+    if (keymap_cache) g_hash_table_destroy(keymap_cache);
+    keymap_cache = NULL;
     xkb_context_unref(globalconf.xkb_ctx);
 }
 
@@ -241,7 +415,8 @@ static void xkb_reload_keymap(void) {
     xkb_state_unref(globalconf.xkb_state);
     xkb_fill_state();
 
-    /* Free and then allocate the key symbols */
+    /* Free and then allocate the key symbols, they are only fetched again
+     * when looked up */
     xcb_key_symbols_free(globalconf.keysyms);
     globalconf.keysyms = xcb_key_symbols_alloc(globalconf.connection);
 
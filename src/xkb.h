@@ -29,6 +29,8 @@ void event_handle_xkb_notify(xcb_generic_event_t *event);
 void xkb_init(void);
 void xkb_free(void);
 
+const xcb_keycode_t *xkb_get_keycodes(xcb_keysym_t);
+
 int luaA_xkb_set_layout_group(lua_State *L);
 int luaA_xkb_get_layout_group(lua_State *L);
 int luaA_xkb_get_group_names(lua_State *L);
@@ -20,10 +20,212 @@
  */
 
 #include "xrdb.h"
+#include "common/lualib.h"
+#include "common/signals.h"
 #include "globalconf.h"
+#include "xreply.h"
 
+#include <glib.h>
 #include <string.h>
 
+/** The RESOURCE_MANAGER property the database was built from, or NULL if it
+ * was missing and the database comes from the resource files */
+static char *xrdb_resources = NULL;
+
+/** The memoized lookups, from "class\nname" to the value or xrdb_miss */
+static GHashTable *xrdb_cache = NULL;
+static char        xrdb_miss[] = "";
+
+/** Whether RESOURCE_MANAGER is being fetched, and whether it changed again
+ * meanwhile */
+static bool xrdb_fetching = false;
+static bool xrdb_refetch  = false;
+
+static void xrdb_cache_value_free(gpointer value) {
+    if (value != xrdb_miss) g_free(value);
+}
+
+/** Fetch the root window's RESOURCE_MANAGER property.
+ * \return The cookie of the request.
+ */
+static xcb_get_property_cookie_t xrdb_get_resources(void) {
+    return xcb_get_property(
+        globalconf.connection, false, globalconf.screen->root, XCB_ATOM_RESOURCE_MANAGER,
+        XCB_ATOM_STRING, 0, 0xffffffff);
+}
+
+/** Initialize the resource database, like Xlib does. */
+void xrdb_init(void) {
+    xcb_get_property_cookie_t cookie = xrdb_get_resources();
+    xcb_get_property_reply_t *reply;
+
+    globalconf.xrmdb = xcb_xrm_database_from_default(globalconf.connection);
+    if (globalconf.xrmdb == NULL) globalconf.xrmdb = xcb_xrm_database_from_string("");
+    if (globalconf.xrmdb == NULL) fatal("Failed to initialize xcb-xrm");
+
+    /* Remember what the database was built from, to tell what changes later */
+    reply = xcb_get_property_reply(globalconf.connection, cookie, NULL);
+    if (reply && xcb_get_property_value_length(reply) > 0)
+        xrdb_resources =
+            g_strndup(xcb_get_property_value(reply), xcb_get_property_value_length(reply));
+    p_delete(&reply);
+
+    xrdb_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, xrdb_cache_value_free);
+}
+
+/** Look up a resource, at most once until the database changes.
+ * \param resource_class The class, ie "URxvt" or "".
+ * \param resource_name The name, ie "background" or "color0".
+ * \return The value, or NULL if the resource does not exist.
+ */
+static const char *xrdb_lookup(const char *resource_class, const char *resource_name) {
+    char *key    = g_strdup_printf("%s\n%s", resource_class, resource_name);
+    char *value  = g_hash_table_lookup(xrdb_cache, key);
+    char *result = NULL;
+
+    if (value) {
+        g_free(key);
+        return value == xrdb_miss ? NULL : value;
+    }
+
+    if (xcb_xrm_resource_get_string(globalconf.xrmdb, resource_name, resource_class, &result) < 0)
+        value = xrdb_miss;
+    else {
+        value = g_strdup(result);
+        p_delete(&result);
+    }
+    g_hash_table_insert(xrdb_cache, key, value);
+
+    return value == xrdb_miss ? NULL : value;
+}
+
+/** Get the resource specifier of a resource line.
+ * \param line The line.
+ * \return The specifier, NULL for comments and empty lines.
+ */
+static char *xrdb_line_specifier(const char *line) {
+    const char *colon;
+
+    while (g_ascii_isspace(*line)) line++;
+    if (*line == '\0' || *line == '!' || *line == '#') return NULL;
+
+    colon = strchr(line, ':');
+    return g_strstrip(colon ? g_strndup(line, colon - line) : g_strdup(line));
+}
+
+/** Put the new lines of the resources into the database.
+ * Changed resources are overridden, but removed ones cannot be taken out of the
+ * database, which has to be rebuilt then.
+ * \param old The resources the database was built from.
+ * \param new The new resources.
+ * \return False if the database has to be rebuilt.
+ */
+static bool xrdb_merge(const char *old, const char *new) {
+    gchar     **old_lines = g_strsplit(old, "\n", -1);
+    gchar     **new_lines = g_strsplit(new, "\n", -1);
+    GHashTable *removed   = g_hash_table_new(g_str_hash, g_str_equal);
+    GHashTable *changed   = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    GPtrArray  *added     = g_ptr_array_new();
+    bool        ok        = true;
+
+    for (gchar **line = old_lines; *line; line++) g_hash_table_add(removed, *line);
+
+    for (gchar **line = new_lines; ok && *line; line++) {
+        char *specifier;
+
+        if (g_hash_table_remove(removed, *line)) continue;
+        /* Lines continued with a backslash are not worth the trouble */
+        if (g_str_has_suffix(*line, "\\")) ok = false;
+        else if ((specifier = xrdb_line_specifier(*line))) {
+            g_hash_table_add(changed, specifier);
+            g_ptr_array_add(added, *line);
+        }
+    }
+
+    if (ok) {
+        GHashTableIter iter;
+        gpointer       line;
+
+        g_hash_table_iter_init(&iter, removed);
+        while (ok && g_hash_table_iter_next(&iter, &line, NULL)) {
+            char *specifier = xrdb_line_specifier(line);
+            if (g_str_has_suffix(line, "\\") ||
+                (specifier && !g_hash_table_contains(changed, specifier)))
+                ok = false;
+            g_free(specifier);
+        }
+    }
+
+    if (ok)
+        for (guint i = 0; i < added->len; i++)
+            xcb_xrm_database_put_resource_line(&globalconf.xrmdb, g_ptr_array_index(added, i));
+
+    g_ptr_array_free(added, TRUE);
+    g_hash_table_destroy(changed);
+    g_hash_table_destroy(removed);
+    g_strfreev(new_lines);
+    g_strfreev(old_lines);
+    return ok;
+}
+
+/** Update the database to new RESOURCE_MANAGER content.
+ * \param value The content, not NUL-terminated.
+ * \param len Its length.
+ */
+static void xrdb_update(const char *value, int len) {
+    lua_State *L         = globalconf_get_lua_State();
+    char      *resources = g_strndup(value, len);
+
+    if (xrdb_resources ? A_STREQ(resources, xrdb_resources) : !*resources) {
+        g_free(resources);
+        return;
+    }
+
+    if (!xrdb_resources || !xrdb_merge(xrdb_resources, resources)) {
+        xcb_xrm_database_t *database = xcb_xrm_database_from_string(resources);
+        if (!database) {
+            warn("Failed to parse the RESOURCE_MANAGER property");
+            g_free(resources);
+            return;
+        }
+        xcb_xrm_database_free(globalconf.xrmdb);
+        globalconf.xrmdb = database;
+    }
+
+    g_free(xrdb_resources);
+    xrdb_resources = resources;
+    g_hash_table_remove_all(xrdb_cache);
+
+    luna_emit_global_signal(L, "xrdb::changed", 0);
+}
+
+static void xrdb_resources_cb(void *reply, xcb_generic_error_t *error, void *data) {
+    xcb_get_property_reply_t *prop = reply;
+
+    xrdb_fetching = false;
+
+    /* This is already outdated */
+    if (xrdb_refetch) {
+        xrdb_refetch = false;
+        xrdb_refresh();
+        return;
+    }
+
+    if (prop) xrdb_update(xcb_get_property_value(prop), xcb_get_property_value_length(prop));
+}
+
+/** The RESOURCE_MANAGER property changed, update the database once it is
+ * fetched. */
+void xrdb_refresh(void) {
+    if (xrdb_fetching) {
+        xrdb_refetch = true;
+        return;
+    }
+
+    xrdb_fetching = true;
+    xreply_add(xrdb_get_resources().sequence, xrdb_resources_cb, NULL);
+}
+
 /* \brief get value from X Resources DataBase
  * \param L The Lua VM state.
  * \return The number of elements pushed on stack.
@@ -34,14 +236,42 @@
  */
 int luaA_xrdb_get_value(lua_State *L) {
     const char *resource_class = luaL_checkstring(L, 1);
-    const char *resource_name = luaL_checkstring(L, 2);
-    char *result = NULL;
+    const char *resource_name  = luaL_checkstring(L, 2);
+    const char *result         = xrdb_lookup(resource_class, resource_name);
 
-    if (xcb_xrm_resource_get_string(globalconf.xrmdb, resource_name, resource_class, &result) < 0 ) {
-        lua_pushnil(L);
-    } else {
-        lua_pushstring(L, result);
-        p_delete(&result);
+    if (result) lua_pushstring(L, result);
+    else lua_pushnil(L);
+
+    return 1;
+}
+
+/* \brief get several values from X Resources DataBase at once
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lparam string xrdb class, ie "URxvt" or ""
+ * \lparam table xrdb names, ie { "background", "color0" }
+ * \lreturn table The values by name, without the ones which do not exist.
+ */
+int luaA_xrdb_get_values(lua_State *L) {
+    const char *resource_class = luaL_checkstring(L, 1);
+    size_t      len;
+
+    luaA_checktable(L, 2);
+    len = luaA_rawlen(L, 2);
+
+    lua_createtable(L, 0, len);
+    for (size_t i = 1; i <= len; i++) {
+        const char *resource_name, *result;
+
+        lua_rawgeti(L, 2, i);
+        if (lua_type(L, -1) != LUA_TSTRING)
+            return luaL_error(L, "xrdb name at index %d is not a string", (int)i);
+        resource_name = lua_tostring(L, -1);
+        if ((result = xrdb_lookup(resource_class, resource_name))) {
+            lua_pushstring(L, result);
+            lua_rawset(L, -3);
+        } else lua_pop(L, 1);
     }
 
     return 1;
@@ -24,7 +24,10 @@
 
 #include <lua.h>
 
-int luaA_xrdb_get_value(lua_State *L);
+void xrdb_init(void);
+void xrdb_refresh(void);
+int  luaA_xrdb_get_value(lua_State *L);
+int  luaA_xrdb_get_values(lua_State *L);
 
 #endif
 
@@ -0,0 +1,83 @@
+/*
+ * xreply.c - asynchronous X reply handling
+ *
+ * Copyright © 2026 Abigail Teague <ateague063@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* Requests whose reply is handled by a callback instead of waiting for it.
+ *
+ * The X server answers in request order, so the pending requests are kept in
+ * a queue and only its head is polled. The main loop polls after handling the
+ * events and before going to sleep, since reading the events may already have
+ * read the replies from the socket.
+ */
+
+#include "xreply.h"
+#include "common/array.h"
+#include "globalconf.h"
+
+typedef struct {
+    unsigned int      sequence;
+    xreply_callback_t callback;
+    void             *data;
+} xreply_t;
+
+DO_ARRAY(xreply_t, xreply, DO_NOTHING)
+
+static xreply_array_t pending;
+static bool           polling = false;
+
+/** Call a function with the reply of a request once it arrives.
+ * \param sequence The sequence number of the request, from its cookie.
+ * \param callback The function to call.
+ * \param data Passed to the function.
+ */
+void xreply_add(unsigned int sequence, xreply_callback_t callback, void *data) {
+    xreply_array_append(&pending, (xreply_t) {sequence, callback, data});
+}
+
+/** Call the functions of the requests whose reply arrived.
+ * \return The number of functions called.
+ */
+int xreply_poll(void) {
+    int done = 0;
+
+    /* The callbacks may send new requests, but not poll */
+    if (polling) return 0;
+    polling = true;
+
+    while (done < pending.len) {
+        xreply_t             request = pending.tab[done];
+        void                *reply   = NULL;
+        xcb_generic_error_t *error   = NULL;
+
+        if (!xcb_poll_for_reply(globalconf.connection, request.sequence, &reply, &error)) break;
+
+        done++;
+        request.callback(reply, error, request.data);
+        p_delete(&reply);
+        p_delete(&error);
+    }
+
+    if (done) xreply_array_splice(&pending, 0, done, NULL, 0);
+
+    polling = false;
+    return done;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
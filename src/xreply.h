@@ -0,0 +1,34 @@
+/*
+ * xreply.h - asynchronous X reply handling header
+ *
+ * Copyright © 2026 Abigail Teague <ateague063@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AWESOME_XREPLY_H
+#define AWESOME_XREPLY_H
+
+#include <xcb/xcb.h>
+
+/** Called with the reply, or NULL and the error. Both are freed afterwards. */
+typedef void (*xreply_callback_t)(void *reply, xcb_generic_error_t *error, void *data);
+
+void xreply_add(unsigned int, xreply_callback_t, void *);
+int  xreply_poll(void);
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -23,6 +23,7 @@
 #include "common/atoms.h"
 #include "objects/button.h"
 #include "objects/key.h"
+#include "xkb.h"
 
 #include <cairo-xcb.h>
 #include <xcb/shape.h>
@@ -115,13 +116,12 @@ static void xwindow_grabkey(xcb_window_t win, keyb_t *k) {
             globalconf.connection, true, win, k->modifiers, k->keycode, XCB_GRAB_MODE_ASYNC,
             XCB_GRAB_MODE_ASYNC);
     else if (k->keysym) {
-        xcb_keycode_t *keycodes = xcb_key_symbols_get_keycode(globalconf.keysyms, k->keysym);
+        const xcb_keycode_t *keycodes = xkb_get_keycodes(k->keysym);
         if (keycodes) {
-            for (xcb_keycode_t *kc = keycodes; *kc; kc++)
+            for (const xcb_keycode_t *kc = keycodes; *kc; kc++)
                 xcb_grab_key(
                     globalconf.connection, true, win, k->modifiers, *kc, XCB_GRAB_MODE_ASYNC,
                     XCB_GRAB_MODE_ASYNC);
-            p_delete(&keycodes);
         }
     }
 }
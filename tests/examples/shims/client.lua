@@ -378,6 +378,24 @@ function client.get(s)
     return ret
 end
 
+-- Emulate capi.client.batch_geometry
+function client.batch_geometry(geometries)
+    local count = 0
+
+    for c, geo in pairs(geometries) do
+        local old = c:geometry()
+        c:geometry(geo)
+
+        local new = c:geometry()
+        if old.x ~= new.x or old.y ~= new.y or old.width ~= new.width
+          or old.height ~= new.height then
+            count = count + 1
+        end
+    end
+
+    return count
+end
+
 return client
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
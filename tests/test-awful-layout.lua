@@ -181,6 +181,119 @@ for _ in ipairs(awful.layout.layouts) do
     gtable.merge(steps, common_steps)
 end
 
+-- client.batch_geometry checks everything before moving anything, and emits
+-- the signals once per client after all of them moved.
+table.insert(steps, function()
+    awful.layout.set(awful.layout.suit.floating, t)
+
+    local c1, c2 = t:clients()[1], t:clients()[2]
+    local g1, g2 = c1:geometry(), c2:geometry()
+
+    assert(not pcall(client.batch_geometry, {
+        [c1] = { x = g1.x + 10 },
+        [c2] = { width = -5 },
+    }))
+    assert(c1.x == g1.x)
+
+    local seen = {}
+    local function check(c)
+        seen[c] = (seen[c] or 0) + 1
+        assert(c1.x == g1.x + 10 and c2.x == g2.x + 10)
+    end
+    c1:connect_signal("property::geometry", check)
+    c2:connect_signal("property::geometry", check)
+
+    assert(client.batch_geometry {
+        [c1] = { x = g1.x + 10 },
+        [c2] = { x = g2.x + 10 },
+    } == 2)
+
+    c1:disconnect_signal("property::geometry", check)
+    c2:disconnect_signal("property::geometry", check)
+    assert(seen[c1] == 1 and seen[c2] == 1)
+
+    return true
+end)
+
+-- Check that the native layouts compute the same geometries as the Lua ones
+local native_configs = {
+    { master_count = 1, column_count = 1, master_width_factor = 0.5, gap = 0 },
+    { master_count = 2, column_count = 2, master_width_factor = 0.7, gap = 5 },
+    { master_count = 0, column_count = 3, master_width_factor = 0.3, gap = 0 },
+    { master_count = 6, column_count = 1, master_width_factor = 0.5, gap = 3,
+      master_fill_policy = "expand" },
+}
+
+local function snapshot()
+    local ret = {}
+    for _, c in ipairs(t:clients()) do
+        ret[c] = c:geometry()
+    end
+    return ret
+end
+
+local function same(a, b)
+    if type(a) ~= "table" or type(b) ~= "table" then
+        return a == b and math.type(a) == math.type(b)
+    end
+    for k, v in pairs(a) do
+        if not same(v, b[k]) then return false end
+    end
+    for k in pairs(b) do
+        if a[k] == nil then return false end
+    end
+    return true
+end
+
+for _, l in ipairs(awful.layout.layouts) do
+    for _, config in ipairs(l.native_arrange and native_configs or {}) do
+        local expected, expected_fact, focus
+
+        table.insert(steps, function()
+            -- The magnifier depends on the focus, keep it the same for both runs
+            focus = client.focus
+            awful.layout.native = false
+            awful.layout.set(l, t)
+            for k, v in pairs(config) do
+                t[k] = v
+            end
+            t.master_fill_policy = config.master_fill_policy or "master_width_factor"
+            awful.tag.getdata(t).windowfact = nil
+            awful.layout.arrange(t.screen)
+            return true
+        end)
+
+        table.insert(steps, function()
+            expected = snapshot()
+            local windowfact = awful.tag.getdata(t).windowfact
+            expected_fact = windowfact and gtable.clone(windowfact)
+
+            -- Move everything away so that the native layout has to do the work
+            for c in pairs(expected) do
+                c:geometry { x = 0, y = 0, width = 50, height = 50 }
+            end
+            awful.tag.getdata(t).windowfact = nil
+            client.focus = focus
+            awful.layout.native = true
+            awful.layout.arrange(t.screen)
+            return true
+        end)
+
+        table.insert(steps, function()
+            for c, geo in pairs(snapshot()) do
+                for _, prop in ipairs { "x", "y", "width", "height" } do
+                    assert(geo[prop] == expected[c][prop], string.format(
+                        "%s: %s of %s is %d instead of %d", l.name, prop, c.name,
+                        geo[prop], expected[c][prop]))
+                end
+            end
+            assert(same(awful.tag.getdata(t).windowfact, expected_fact), l.name)
+            awful.layout.native = false
+            return true
+        end)
+    end
+end
+
 require("_runner").run_steps(steps)
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
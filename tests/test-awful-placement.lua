@@ -325,6 +325,66 @@ for _, tag_num in ipairs{1, 2, 3} do
 
 end
 
+-- The native free space computation must find the same maximal free areas as
+-- `gears.geometry.rectangle.area_remove`, which also keeps contained ones.
+table.insert(tests, 1, function()
+    local grect = require("gears.geometry").rectangle
+    local wa = { x = 0, y = 20, width = 1920, height = 1060 }
+
+    local function contained(a, b)
+        return a.x >= b.x and a.y >= b.y and a.x + a.width <= b.x + b.width
+            and a.y + a.height <= b.y + b.height
+    end
+
+    local function maximal(areas)
+        local ret = {}
+        for i, a in ipairs(areas) do
+            local keep = true
+            for j, b in ipairs(areas) do
+                if i ~= j and contained(a, b) and (j < i or not contained(b, a)) then
+                    keep = false
+                    break
+                end
+            end
+            if keep then table.insert(ret, a) end
+        end
+        return ret
+    end
+
+    local function key(a)
+        return string.format("%d,%d,%d,%d", a.x, a.y, a.width, a.height)
+    end
+
+    local function keys(areas)
+        local ret = {}
+        for _, a in ipairs(areas) do table.insert(ret, key(a)) end
+        table.sort(ret)
+        return table.concat(ret, " ")
+    end
+
+    math.randomseed(42)
+
+    for count = 0, 20, 4 do
+        local obstacles, areas = {}, { wa }
+        for _ = 1, count do
+            local o = {
+                x      = math.random(-100, 1900),
+                y      = math.random(0, 1000),
+                width  = math.random(1, 600),
+                height = math.random(1, 400),
+            }
+            table.insert(obstacles, o)
+            areas = grect.area_remove(areas, o)
+        end
+
+        local native = awesome._placement_free_areas(wa, obstacles)
+        assert(keys(native) == keys(maximal(areas)),
+            count .. " obstacles: " .. keys(native) .. " ~= " .. keys(maximal(areas)))
+    end
+
+    return true
+end)
+
 runner.run_steps(tests)
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -3,6 +3,8 @@
 
 local runner = require("_runner")
 local awful = require("awful")
+local ruled = require("ruled")
+local spawn = require("awful.spawn")
 local GLib = require("lgi").GLib
 local create_wibox = require("_wibox_helper").create_wibox
 
@@ -77,6 +79,268 @@ benchmark(relayout_textclock, "relayout textclock")
 benchmark(redraw_textclock, "redraw textclock")
 benchmark(e2e_tag_switch, "tag switch")
 
-runner.run_steps({ function() return true end })
+-- The free space computation of awful.placement.no_overlap on a busy screen.
+local function random_windows(count)
+    local wa, ret = screen.primary.workarea, {}
+    math.randomseed(count)
+    for _ = 1, count do
+        table.insert(ret, {
+            x      = wa.x + math.random(0, wa.width - 100),
+            y      = wa.y + math.random(0, wa.height - 100),
+            width  = math.random(100, 600),
+            height = math.random(100, 400),
+        })
+    end
+    return ret
+end
+
+local function free_areas(obstacles)
+    return function()
+        awesome._placement_free_areas(screen.primary.workarea, obstacles)
+    end
+end
+
+local function free_areas_lua(obstacles)
+    local area_remove = require("gears.geometry").rectangle.area_remove
+    return function()
+        local areas = { screen.primary.workarea }
+        for _, o in ipairs(obstacles) do
+            areas = area_remove(areas, o)
+        end
+    end
+end
+
+benchmark(free_areas(random_windows(25)), "free areas (25)")
+benchmark(free_areas_lua(random_windows(25)), "free areas (25, Lua)")
+benchmark(free_areas(random_windows(200)), "free areas (200)")
+
+-- Matrix composition and bounding boxes, as done for every widget of a
+-- hierarchy.
+local function matrix_hierarchy()
+    local gmatrix = require("gears.matrix")
+    local m = gmatrix.identity
+    for i = 1, 100 do
+        m = gmatrix.create_translate(i, i) * m
+        m:transform_rectangle(0, 0, 100, 20)
+    end
+    m:invert()
+end
+
+benchmark(matrix_hierarchy, "matrix hierarchy")
+
+-- Spawn latency as awesome grows. fork() copies the page tables of the whole
+-- process, vfork() does not.
+local function spawn_true()
+    assert(type(awesome.spawn({ "true" }, false)) == "number")
+end
+
+local function benchmark_spawn(size)
+    for _, backend in ipairs { "vfork", "glib" } do
+        local previous = awesome._spawn_backend(backend)
+        benchmark(spawn_true, string.format("spawn (%s, +%d MiB)", backend, size))
+        awesome._spawn_backend(previous)
+    end
+end
+
+-- Grow the Lua heap with strings that actually get touched.
+local function benchmark_spawn_with_ballast(size)
+    local ballast = {}
+    for i = 1, size * 1024 do
+        ballast[i] = string.rep("x", 1016) .. string.format("%08d", i)
+    end
+    benchmark_spawn(size)
+    return #ballast
+end
+
+benchmark_spawn(0)
+benchmark_spawn_with_ballast(128)
+collectgarbage("collect")
+
+-- One sample of all the statistics a status bar usually shows.
+benchmark(awesome._sampler_read, "sampler read")
+
+-- Repeat the end-to-end benchmarks with a realistic amount of clients, created
+-- by the synthetic client swarm.
+local SWARM_SIZE = 100
+local swarm_pid
+
+local function e2e_tag_switch_back()
+    awful.tag.viewprev()
+    do_pending_repaint()
+end
+
+-- A large rule set, mostly literal classes and instances with a few patterns.
+local RULE_COUNT = 300
+local bench_rules = {}
+
+for i = 1, RULE_COUNT do
+    local rule
+
+    if i % 10 == 0 then
+        rule = { class = "^Swarm[0-9]+x" .. i }
+    elseif i % 10 == 1 then
+        rule = { instance = "^bench" .. i .. "$" }
+    else
+        rule = { class = "Bench" .. i }
+    end
+
+    table.insert(bench_rules, { id = "benchmark" .. i, rule = rule, properties = {} })
+end
+
+local function rules_apply_swarm()
+    for _, c in ipairs(client.get()) do
+        ruled.client.apply(c)
+    end
+end
+
+local function rules_match_swarm()
+    for _, c in ipairs(client.get()) do
+        ruled.client.matching_rules(c, bench_rules)
+    end
+end
+
+local function rules_match_swarm_linear()
+    for _, c in ipairs(client.get()) do
+        for _, entry in ipairs(bench_rules) do
+            ruled.client.matches(c, entry)
+        end
+    end
+end
+
+-- A burst of D-Bus signals through the session bus of the test, a local
+-- dbus-daemon, from the first emission to the last handler call.
+local DBUS_BURST = 2000
+local dbus_interface = "org.awesomewm.test.Benchmark"
+local dbus_received, dbus_timer = 0, GLib.Timer()
+
+local function dbus_burst(lazy)
+    dbus_received = 0
+    dbus.disconnect_signal(dbus_interface)
+    dbus.connect_signal(dbus_interface, function(_, message)
+        if lazy then message:arg(4) end
+        dbus_received = dbus_received + 1
+    end, lazy)
+
+    dbus_timer:start()
+    for i = 1, DBUS_BURST do
+        dbus.emit_signal("session", "/", dbus_interface, "Notify",
+            "s", "benchmark", "u", i, "s", "", "s", "summary", "s", "body",
+            "as", { "s", "default", "s", "Open" }, "i", -1)
+    end
+end
+
+local function dbus_burst_done(msg)
+    if dbus_received < DBUS_BURST then return end
+    local elapsed = dbus_timer:elapsed()
+    print(string.format("%20s: %-10.6g sec/msg (%d msgs, %.4g sec for benchmark)",
+                        msg, elapsed / DBUS_BURST, DBUS_BURST, elapsed))
+    return true
+end
+
+-- A burst of notifications through the Notify method of naughty, from the
+-- first call to the last reply. Then again with the per-application limit
+-- and the popups of the first burst reused.
+local NOTIFY_BURST = 50
+local naughty = require("naughty")
+local Gio = require("lgi").Gio
+local session_bus = Gio.bus_get_sync(Gio.BusType.SESSION)
+local notify_replies, notify_timer = 0, GLib.Timer()
+
+local function notify_burst(limit, spare)
+    naughty.config.spare_boxes = spare
+    naughty.destroy_all_notifications()
+    naughty.config.burst_limit = limit
+    notify_replies = 0
+
+    notify_timer:start()
+    for i = 1, NOTIFY_BURST do
+        session_bus:call("org.freedesktop.Notifications",
+            "/org/freedesktop/Notifications", "org.freedesktop.Notifications",
+            "Notify", GLib.Variant("(susssasa{sv}i)", {
+                "benchmark", 0, "", "Burst " .. i, "message", {}, {}, -1
+            }), GLib.VariantType.new("(u)"), Gio.DBusCallFlags.NO_AUTO_START,
+            -1, nil, function(conn, result)
+                conn:call_finish(result)
+                notify_replies = notify_replies + 1
+            end)
+    end
+end
+
+local function notify_burst_done(msg)
+    if notify_replies < NOTIFY_BURST then return end
+    do_pending_repaint()
+    local elapsed = notify_timer:elapsed()
+    print(string.format("%20s: %-10.6g sec/notif (%d notifs, %d popups, %.4g sec for benchmark)",
+                        msg, elapsed / NOTIFY_BURST, NOTIFY_BURST, #naughty.active, elapsed))
+    return true
+end
+
+runner.run_steps({
+    function()
+        notify_burst(nil, 0)
+        return true
+    end,
+    function()
+        if not notify_burst_done("notify burst") then return end
+        notify_burst(5, NOTIFY_BURST)
+        return true
+    end,
+    function()
+        if not notify_burst_done("notify burst (limit)") then return end
+        naughty.config.burst_limit = nil
+        naughty.config.spare_boxes = 0
+        naughty.destroy_all_notifications()
+        return true
+    end,
+    function()
+        dbus.add_match("session", "type='signal',interface='" .. dbus_interface .. "'")
+        dbus_burst(false)
+        return true
+    end,
+    function()
+        if not dbus_burst_done("dbus burst") then return end
+        dbus_burst(true)
+        return true
+    end,
+    function()
+        if not dbus_burst_done("dbus burst (lazy)") then return end
+        dbus.disconnect_signal(dbus_interface)
+        return true
+    end,
+    function()
+        swarm_pid = spawn({ "./test-swarm", "-n", tostring(SWARM_SIZE), "-k" })
+        assert(type(swarm_pid) == "number", swarm_pid)
+        return true
+    end,
+    function()
+        if #client.get() < SWARM_SIZE then return end
+
+        -- Tile the swarm so that the layout is part of the measurement
+        awful.screen.focused().selected_tag.layout = awful.layout.suit.tile
+
+        benchmark(e2e_tag_switch, "tag switch (swarm)")
+        benchmark(e2e_tag_switch_back, "tag switch back (swarm)")
+
+        awful.layout.native = true
+        benchmark(e2e_tag_switch, "tag switch (swarm, native)")
+        benchmark(e2e_tag_switch_back, "tag switch back (swarm, native)")
+        awful.layout.native = false
+
+        ruled.client.append_rules(bench_rules)
+        benchmark(rules_apply_swarm, "rules apply (swarm)")
+        benchmark(rules_match_swarm, "rules match (swarm)")
+        benchmark(rules_match_swarm_linear, "rules match (swarm, linear)")
+
+        for _, entry in ipairs(bench_rules) do
+            ruled.client.remove_rule(entry)
+        end
+
+        awesome.kill(swarm_pid, awesome.unix_signal.SIGTERM)
+        return true
+    end,
+    function()
+        return #client.get() == 0
+    end,
+}, { wait_per_step = 10 })
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
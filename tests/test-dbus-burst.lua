@@ -0,0 +1,84 @@
+-- Test the lazy D-Bus message handles and the processing of message bursts.
+
+local runner = require("_runner")
+local gtimer = require("gears.timer")
+
+local BURST = 200
+local BUDGET = 32
+local interface = "org.awesomewm.test.Burst"
+
+local received, batches, batch_pending = 0, 0, false
+
+local function count_batch()
+    if batch_pending then return end
+    batch_pending = true
+    gtimer.delayed_call(function()
+        batch_pending = false
+        batches = batches + 1
+    end)
+end
+
+local function lazy_callback(data, message)
+    assert(data.member == "Notify")
+    assert(message:signature() == "susssasi")
+
+    -- Only the requested argument is decoded
+    assert(message:arg(4) == "summary")
+    assert(message:arg(6)[2] == "b")
+    assert(message:arg(9) == nil)
+
+    local args = table.pack(message:args())
+    assert(args.n == 7)
+    assert(args[1] == "app" and args[2] == data.path:match("%d+") + 0)
+    assert(args[7] == -1)
+
+    received = received + 1
+    count_batch()
+end
+
+local function emit(i)
+    dbus.emit_signal("session", "/burst/" .. i, interface, "Notify",
+        "s", "app", "u", i, "s", "icon", "s", "summary", "s", "body",
+        "as", { "s", "a", "s", "b" }, "i", -1)
+end
+
+local steps = {
+    function()
+        dbus.add_match("session", "type='signal',interface='" .. interface .. "'")
+        assert(dbus.connect_signal(interface, lazy_callback, true))
+
+        for i = 1, BURST do
+            emit(i)
+        end
+        return true
+    end,
+
+    -- The burst is spread over several main loop iterations.
+    function()
+        if received < BURST or batch_pending then return end
+        assert(batches >= math.ceil(BURST / BUDGET), batches)
+
+        -- Without `lazy`, the arguments are decoded as before.
+        dbus.disconnect_signal(interface, lazy_callback)
+        received = 0
+        dbus.connect_signal(interface, function(data, app, id, _, summary, _, actions, timeout)
+            assert(data.interface == interface)
+            assert(app == "app" and id == 1 and summary == "summary")
+            assert(actions[1] == "a" and actions[2] == "b" and timeout == -1)
+            received = received + 1
+        end)
+        emit(1)
+        return true
+    end,
+
+    function()
+        if received < 1 then return end
+        dbus.disconnect_signal(interface)
+        dbus.remove_match("session", "type='signal',interface='" .. interface .. "'")
+        return true
+    end,
+}
+
+runner.run_steps(steps)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
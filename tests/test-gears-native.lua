@@ -0,0 +1,116 @@
+-- Compare the native versions of gears.geometry and gears.matrix with the Lua
+-- ones, which are still used outside of awesome.
+
+local runner = require("_runner")
+local gears = require("gears")
+
+-- Load a module again without the native functions.
+local function load_lua_version(name)
+    local env = setmetatable({ awesome = false }, { __index = _G })
+    local path = assert(package.searchpath(name, package.path))
+    return assert(loadfile(path, "t", env))()
+end
+
+local lua_geometry = load_lua_version("gears.geometry").rectangle
+local lua_matrix = load_lua_version("gears.matrix")
+local grect, gmatrix = gears.geometry.rectangle, gears.matrix
+
+local function random_rect()
+    return {
+        x      = math.random(-200, 1800),
+        y      = math.random(-200, 1000),
+        width  = math.random(1, 800),
+        height = math.random(1, 600),
+    }
+end
+
+local function random_matrix(m)
+    return m.create(math.random() * 4 - 2, math.random() * 4 - 2,
+                    math.random() * 4 - 2, math.random() * 4 - 2,
+                    math.random(-100, 100), math.random(-100, 100))
+end
+
+local function close(a, b)
+    return a == b or math.abs(a - b) <= 1e-9 * math.max(math.abs(a), math.abs(b))
+end
+
+local function same_matrix(a, b)
+    for _, k in ipairs { "xx", "yx", "xy", "yy", "x0", "y0" } do
+        if not close(a[k], b[k]) then return false end
+    end
+    return true
+end
+
+local function copy(areas)
+    local ret = {}
+    for k, a in ipairs(areas) do
+        ret[k] = { x = a.x, y = a.y, width = a.width, height = a.height }
+    end
+    return ret
+end
+
+runner.run_steps {
+    function()
+        assert(grect.area_remove ~= lua_geometry.area_remove, "native geometry not in use")
+        assert(gmatrix.multiply ~= lua_matrix.multiply, "native matrix not in use")
+
+        math.randomseed(1)
+
+        for _ = 1, 200 do
+            local a, b = random_rect(), random_rect()
+            assert(grect.area_intersect_area(a, b) == lua_geometry.area_intersect_area(a, b))
+            assert(grect.are_equal(grect.get_intersection(a, b),
+                                   lua_geometry.get_intersection(a, b)))
+        end
+
+        local native_areas = { { x = 0, y = 0, width = 1920, height = 1080 } }
+        local lua_areas = copy(native_areas)
+        local first = native_areas[1]
+        for _ = 1, 15 do
+            local elem = random_rect()
+            assert(grect.area_remove(native_areas, elem) == native_areas)
+            lua_geometry.area_remove(lua_areas, elem)
+            assert(#native_areas == #lua_areas)
+            for k, a in ipairs(native_areas) do
+                assert(grect.are_equal(a, lua_areas[k]))
+            end
+        end
+
+        -- Areas which were not split are kept as they are.
+        local untouched = { x = 5000, y = 0, width = 10, height = 10 }
+        native_areas = { first, untouched }
+        grect.area_remove(native_areas, { x = 0, y = 0, width = 10, height = 10 })
+        assert(native_areas[1] == untouched)
+
+        for _ = 1, 50 do
+            local list, x, y = {}, math.random(-100, 2000), math.random(-100, 1200)
+            for i = 1, 10 do list[i] = random_rect() end
+            assert(grect.get_closest_by_coord(list, x, y)
+                   == lua_geometry.get_closest_by_coord(list, x, y))
+        end
+        assert(grect.get_closest_by_coord({}, 0, 0) == nil)
+
+        for _ = 1, 200 do
+            local a, b = random_matrix(gmatrix), random_matrix(gmatrix)
+            local la = lua_matrix.create(a.xx, a.yx, a.xy, a.yy, a.x0, a.y0)
+            local lb = lua_matrix.create(b.xx, b.yx, b.xy, b.yy, b.x0, b.y0)
+
+            assert(same_matrix(a * b, la * lb))
+            assert(same_matrix(a:invert(), la:invert()))
+
+            local r = random_rect()
+            local n = { a:transform_rectangle(r.x, r.y, r.width, r.height) }
+            local l = { la:transform_rectangle(r.x, r.y, r.width, r.height) }
+            for i = 1, 4 do assert(close(n[i], l[i])) end
+        end
+
+        -- Integer arithmetic stays integer.
+        local m = gmatrix.create_translate(10, 20) * gmatrix.create_scale(2, 3)
+        assert(math.type(m.x0) == "integer" and m.x0 == 20 and m.y0 == 60)
+        assert(select("#", m:transform_rectangle(0, 0, 5, 5)) == 4)
+
+        return true
+    end,
+}
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,138 @@
+-- Test that the keyboard grab is acquired without blocking while another
+-- client holds it.
+
+local runner = require("_runner")
+local spawn = require("awful.spawn")
+local gtimer = require("gears.timer")
+local GLib = require("lgi").GLib
+
+local lua_executable = os.getenv("LUA")
+if lua_executable == nil or lua_executable == "" then
+    lua_executable = "lua"
+end
+
+-- A client grabbing the keyboard for `hold` milliseconds.
+local function competing_grab(hold)
+    return { lua_executable, "-e", [[
+local lgi = require 'lgi'
+local GLib = lgi.GLib
+local Gdk = lgi.Gdk
+local Gtk = lgi.require('Gtk', '3.0')
+
+Gtk.init()
+
+local window = Gtk.Window { title = 'grabber' }
+
+function window:on_map_event()
+    local seat = Gdk.Display.get_default():get_default_seat()
+    local status = seat:grab(window.window, Gdk.SeatCapabilities.KEYBOARD, false)
+    print(status == 'SUCCESS' and 'grabbed' or 'failed')
+    io.stdout:flush()
+
+    GLib.timeout_add(GLib.PRIORITY_DEFAULT, ]] .. hold .. [[, function()
+        seat:ungrab()
+        Gdk.Display.get_default():flush()
+        Gtk.main_quit()
+    end)
+end
+
+window:show_all()
+Gtk.main()
+]]}
+end
+
+local helper_state, grab_result
+local ticks, ticks_at_result = 0, nil
+
+local function record(result)
+    return function()
+        grab_result = result
+        ticks_at_result = ticks
+    end
+end
+
+awesome.connect_signal("keygrabber::grabbed", record("grabbed"))
+awesome.connect_signal("keygrabber::grab_failed", record("failed"))
+
+local ticker = gtimer {
+    timeout   = 0.02,
+    autostart = true,
+    callback  = function() ticks = ticks + 1 end,
+}
+
+local function start_helper(hold)
+    helper_state = nil
+    spawn.with_line_callback(competing_grab(hold), {
+        stdout = function(line) helper_state = line end,
+        exit   = function() helper_state = "exited" end,
+    })
+end
+
+-- Start the keygrabber once the helper holds the grab.
+local function run_keygrabber()
+    if helper_state ~= "grabbed" then return end
+
+    grab_result, ticks, ticks_at_result = nil, 0, nil
+
+    local start = GLib.get_monotonic_time()
+    keygrabber.run(function() end)
+    assert(GLib.get_monotonic_time() - start < 100000)
+
+    -- It is running, but doesn't have the grab yet.
+    assert(keygrabber.isrunning())
+    assert(grab_result == nil)
+
+    return true
+end
+
+local steps = {
+    function()
+        start_helper(300)
+        return true
+    end,
+
+    run_keygrabber,
+
+    -- The grab succeeds once the helper releases it, and the main loop kept
+    -- running meanwhile.
+    function()
+        if not grab_result then return end
+
+        assert(grab_result == "grabbed", grab_result)
+        assert(ticks_at_result > 0)
+        assert(keygrabber.isrunning())
+
+        keygrabber.stop()
+        return true
+    end,
+
+    function()
+        if helper_state ~= "exited" then return end
+
+        start_helper(2000)
+        return true
+    end,
+
+    run_keygrabber,
+
+    -- The helper holds the grab for too long.
+    function()
+        if not grab_result then return end
+
+        assert(grab_result == "failed", grab_result)
+        assert(ticks_at_result > 10)
+        assert(not keygrabber.isrunning())
+        return true
+    end,
+
+    function()
+        if helper_state ~= "exited" then return end
+
+        ticker:stop()
+        return true
+    end,
+}
+
+runner.run_steps(steps)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
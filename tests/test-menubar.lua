@@ -33,6 +33,30 @@ do
     end
 end
 
+local utils = require("menubar.utils")
+local index_dir, parsed = nil, {}
+
+local function write_desktop_file(path, name)
+    local file = assert(io.open(path, "w"))
+    file:write("[Desktop Entry]\nType=Application\nName=" .. name .. "\nExec=true\n")
+    file:close()
+end
+
+local function parse_index_dir()
+    utils.parse_dir(index_dir, function(programs)
+        table.insert(parsed, programs)
+    end)
+end
+
+local function sorted_names(programs)
+    local names = {}
+    for _, program in ipairs(programs) do
+        table.insert(names, program.Name)
+    end
+    table.sort(names)
+    return table.concat(names, ",")
+end
+
 local show_menubar_and_hide = function(count)
     -- Just show the menubar and hide it.
     -- TODO: Write a proper test. But for the mean time this is better than
@@ -62,9 +86,46 @@ runner.run_steps {
         return show_menubar_and_hide(count)
     end,
 
+    -- The desktop entry index gives the same entries as parsing the files
+    -- and notices new files.
+    function(count)
+        if count == 1 then
+            index_dir = os.tmpname()
+            os.remove(index_dir)
+            assert(os.execute("mkdir -p " .. index_dir .. "/sub"))
+            write_desktop_file(index_dir .. "/a.desktop", "Alpha")
+            write_desktop_file(index_dir .. "/sub/b.desktop", "Beta")
+            utils.index_file = index_dir .. "/index"
+            utils.clear_index()
+            parse_index_dir()
+        end
+        return #parsed == 1
+    end,
+
+    function(count)
+        if count == 1 then
+            assert(sorted_names(parsed[1]) == "Alpha,Beta")
+            assert(io.open(utils.index_file)):close()
+            parse_index_dir()
+        end
+        return #parsed == 2
+    end,
+
+    function(count)
+        if count == 1 then
+            assert(sorted_names(parsed[2]) == "Alpha,Beta")
+            write_desktop_file(index_dir .. "/sub/c.desktop", "Gamma")
+            parse_index_dir()
+        end
+        return #parsed == 3
+    end,
+
     function()
+        assert(sorted_names(parsed[3]) == "Alpha,Beta,Gamma")
+        os.execute("rm -rf " .. index_dir)
+        utils.index_file = nil
         return true
-    end
+    end,
 }
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,169 @@
+-- Test the per-application burst limit of the notifications received over
+-- DBus and the reuse of the `naughty.layout.box` popups.
+
+local runner = require("_runner")
+local naughty = require("naughty")
+local grect = require("gears.geometry").rectangle
+local lgi = require("lgi")
+local Gio, GLib = lgi.Gio, lgi.GLib
+
+local dbus_connection = assert(Gio.bus_get_sync(Gio.BusType.SESSION))
+
+-- Another connection to the bus, sending with the same application name.
+local other_connection = assert(Gio.DBusConnection.new_for_address_sync(
+    Gio.dbus_address_get_for_bus_sync(Gio.BusType.SESSION),
+    { "AUTHENTICATION_CLIENT", "MESSAGE_BUS_CONNECTION" }))
+
+local BURST, LIMIT = 10, 3
+
+-- The popups of the first step.
+local POPUPS = LIMIT + 2
+
+-- Track the boxes created by `rc.lua`.
+local real_box = getmetatable(naughty.layout.box).__call
+local boxes = {}
+
+getmetatable(naughty.layout.box).__call = function(_, args)
+    local ret = real_box(_, args)
+    table.insert(boxes, ret)
+    return ret
+end
+
+local ids = {}
+
+local function send_notify(app, summary, connection)
+    connection = connection or dbus_connection
+    connection:call("org.freedesktop.Notifications",
+        "/org/freedesktop/Notifications", "org.freedesktop.Notifications",
+        "Notify", GLib.Variant("(susssasa{sv}i)", {
+            app, 0, "", summary, "message", {}, {}, 25000
+        }), GLib.VariantType.new("(u)"), Gio.DBusCallFlags.NO_AUTO_START, -1,
+        nil, function(conn, result)
+            table.insert(ids, conn:call_finish(result).value[1])
+        end)
+end
+
+local function check_overlap()
+    local visible = {}
+    for _, b in ipairs(boxes) do
+        if b.visible then table.insert(visible, b) end
+    end
+
+    for i = 1, #visible do
+        for j = i + 1, #visible do
+            assert(not grect.area_intersect_area(visible[i]:geometry(), visible[j]:geometry()))
+        end
+    end
+
+    return #visible
+end
+
+local first_boxes = {}
+
+local steps = {
+    function()
+        naughty.config.burst_limit = LIMIT
+        naughty.config.burst_window = 60
+        naughty.config.spare_boxes = LIMIT
+
+        for i = 1, BURST do
+            send_notify("burst", "Burst " .. i)
+        end
+
+        -- Other applications have their own limit.
+        send_notify("other", "Other")
+
+        -- So do other connections using the same name.
+        send_notify("burst", "Impostor", other_connection)
+
+        return true
+    end,
+
+    -- The extra notifications update the last popup of the application.
+    function()
+        if #ids < BURST + 2 then return end
+
+        assert(#naughty.active == POPUPS, #naughty.active)
+        assert(#boxes == POPUPS)
+
+        -- The popups show the first messages and the latest one.
+        local titles, last, impostor = {}, nil, nil
+        for _, n in ipairs(naughty.active) do
+            titles[n.title] = true
+            if n.title == "Burst " .. BURST then
+                last = n
+            elseif n.title == "Impostor" then
+                impostor = n
+            end
+        end
+
+        for i = 1, BURST do
+            assert((titles["Burst " .. i] or false) == (i < LIMIT or i == BURST), i)
+        end
+
+        assert(last.app_name == "burst")
+        assert(impostor.app_name == "burst")
+
+        -- The applications get the id of the popup showing their message.
+        local counts = {}
+        for _, id in ipairs(ids) do
+            counts[id] = (counts[id] or 0) + 1
+        end
+        assert(counts[last.id] == BURST - LIMIT + 1, counts[last.id])
+        assert(counts[impostor.id] == 1)
+
+        -- Each notification has its own popup.
+        local shown = {}
+        for _, b in ipairs(boxes) do
+            assert(not shown[b.notification])
+            shown[b.notification] = true
+        end
+        assert(shown[last] and shown[impostor])
+
+        for k, b in ipairs(boxes) do first_boxes[k] = b end
+
+        return true
+    end,
+
+    -- The stack is laid out once the burst is over.
+    function()
+        assert(check_overlap() == POPUPS)
+
+        naughty.destroy_all_notifications()
+        naughty.config.burst_limit = nil
+
+        for i = 1, LIMIT do
+            naughty.notification { title = "Reused " .. i, timeout = 25000 }
+        end
+
+        return true
+    end,
+
+    -- The popups of the destroyed notifications are reused.
+    function()
+        assert(#boxes == POPUPS + LIMIT)
+
+        for i = POPUPS + 1, #boxes do
+            local reused = false
+            for _, b in ipairs(first_boxes) do
+                reused = reused or rawequal(b, boxes[i])
+            end
+            assert(reused)
+            assert(boxes[i].visible)
+            assert(boxes[i].notification.title:match("^Reused"))
+        end
+
+        assert(check_overlap() == LIMIT)
+
+        naughty.config.spare_boxes = 0
+        naughty.config.burst_window = 1
+        naughty.destroy_all_notifications()
+        other_connection:close_sync()
+
+        return true
+    end,
+}
+
+runner.run_steps(steps)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
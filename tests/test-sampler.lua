@@ -0,0 +1,85 @@
+-- Test the native /proc and /sys sampler and awful.sampler.
+
+local runner = require("_runner")
+local asampler = require("awful.sampler")
+local sampler_widget = require("awful.widget.sampler")
+
+local first, updates = nil, {}
+local widget, update
+local once_calls, after_once = 0, 0
+
+local function once()
+    once_calls = once_calls + 1
+    asampler.disconnect(once)
+end
+
+local function count_after_once()
+    after_once = after_once + 1
+end
+
+local function record(data)
+    table.insert(updates, data)
+end
+
+local steps = {
+    function()
+        first = asampler.read()
+        assert(first and first.time)
+
+        -- The files are kept open, reading again must give new content.
+        local second = asampler.read()
+        assert(second.time >= first.time)
+
+        if second.memory then
+            assert(second.memory.MemTotal > 0)
+            assert(second.memory.usage >= 0 and second.memory.usage <= 100)
+        end
+
+        if second.cpu and second.cpu.usage then
+            assert(second.cpu.usage >= 0 and second.cpu.usage <= 100)
+            for _, usage in ipairs(second.cpu) do
+                assert(usage >= 0 and usage <= 100)
+            end
+        end
+
+        for _, iface in pairs(second.network or {}) do
+            assert(iface.rx_bytes >= 0 and iface.tx_bytes >= 0)
+            assert(not iface.rx_rate or iface.rx_rate >= 0)
+        end
+
+        for _, supply in pairs(second.power or {}) do
+            assert(supply.type)
+        end
+
+        asampler.set_interval(0.1)
+        asampler.connect(record)
+        widget, update = sampler_widget()
+        return true
+    end,
+
+    -- Both consumers share the same timer.
+    function()
+        if #updates < 3 then return end
+        assert(widget.text:match("^CPU .* MEM "))
+
+        asampler.disconnect(record)
+        asampler.disconnect(update)
+
+        -- A callback disconnecting itself does not skip the next one.
+        asampler.connect(once)
+        asampler.connect(count_after_once)
+        return true
+    end,
+
+    function()
+        if after_once < 2 then return end
+        assert(once_calls == 1, once_calls)
+
+        asampler.disconnect(count_after_once)
+        return true
+    end,
+}
+
+runner.run_steps(steps)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
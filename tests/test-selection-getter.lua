@@ -132,8 +132,9 @@ runner.run_steps{
         continue = false
         local s = selection.getter{ selection = "CLIPBOARD", target = "UTF8_STRING" }
         local data = nil
-        s:connect_signal("data", function(_, d)
+        s:connect_signal("data", function(_, d, final)
             assert(data == nil)
+            assert(final)
             data = d
         end)
         s:connect_signal("data_end", function()
@@ -174,11 +175,15 @@ runner.run_steps{
         -- Query the image in the clipboard
         continue = false
         local s = selection.getter{ selection = "CLIPBOARD", target = "image/bmp" }
-        local data = {}
-        s:connect_signal("data", function(_, d)
+        local data, last = {}, false
+        s:connect_signal("data", function(_, d, final)
+            -- The chunks are streamed, only the last one is final
+            assert(not last)
+            last = final
             table.insert(data, d)
         end)
         s:connect_signal("data_end", function()
+            assert(last)
             local image = table.concat(data)
             local stream = Gio.MemoryInputStream.new_from_data(image)
             local pixbuf, err = GdkPixbuf.Pixbuf.new_from_stream(stream)
@@ -2,6 +2,8 @@
 
 local runner = require("_runner")
 local spawn = require("awful.spawn")
+local gtimer = require("gears.timer")
+local Gio = require("lgi").Gio
 
 local lua_executable = os.getenv("LUA")
 if lua_executable == nil or lua_executable == "" then
@@ -18,6 +20,20 @@ large_transfer_piece = large_transfer_piece .. large_transfer_piece .. large_tra
 local large_transfer_piece_count = 3
 local large_transfer_size = #large_transfer_piece * large_transfer_piece_count
 
+-- Files served without their content going through Lua
+local small_file = os.tmpname()
+local large_file = os.tmpname()
+local large_file_size = 3 * 1024 * 1024 + 17
+do
+    local f = assert(io.open(small_file, "w"))
+    f:write("Hello World!")
+    f:close()
+
+    f = assert(io.open(large_file, "w"))
+    f:write(string.rep("b", large_file_size))
+    f:close()
+end
+
 local header = [[
 local lgi = require("lgi")
 local Gdk = lgi.Gdk
@@ -53,6 +69,11 @@ local check_large_transfer = header
     .. string.format("\nassert_equal(#clipboard:wait_for_text(), %d)\n", large_transfer_size)
     .. done_footer
 
+local check_large_file = header
+    .. string.format("\nassert_equal(clipboard:wait_for_text(), string.rep('b', %d))\n",
+        large_file_size)
+    .. done_footer
+
 local check_empty_selection = header .. [[
 assert_equal(clipboard:wait_for_targets(), nil)
 assert_equal(clipboard:wait_for_text(), nil)
@@ -179,6 +200,111 @@ runner.run_steps({
         if not continue then return end
         continue = false
 
+        -- Now test a file small enough to be sent at once
+        selection_object = assert(selection.acquire{ selection = "CLIPBOARD" },
+            "Failed to acquire the clipboard selection")
+        selection_object:connect_signal("request", function(_, target, transfer)
+            if target == "TARGETS" then
+                transfer:send{
+                    format = "atom",
+                    data = { "TARGETS", "UTF8_STRING" },
+                }
+            elseif target == "UTF8_STRING" then
+                transfer:send{ file = small_file }
+            end
+        end)
+        awesome.sync()
+        spawn.with_line_callback({ lua_executable, "-e", check_targets_and_text },
+            { stdout = function(line)
+                assert(line == "done", "Unexpected line: " .. line)
+                continue = true
+            end })
+        return true
+    end,
+
+    function()
+        -- Wait for the previous test to succeed
+        if not continue then return end
+        continue = false
+
+        -- Now test a file streamed in pieces
+        selection_object = assert(selection.acquire{ selection = "CLIPBOARD" },
+            "Failed to acquire the clipboard selection")
+        selection_object:connect_signal("request", function(_, target, transfer)
+            if target == "TARGETS" then
+                transfer:send{
+                    format = "atom",
+                    data = { "TARGETS", "UTF8_STRING" },
+                }
+            elseif target == "UTF8_STRING" then
+                transfer:send{ file = large_file }
+                transfer:connect_signal("continue", function()
+                    error("A file transfer does not ask Lua for more data")
+                end)
+            end
+        end)
+        awesome.sync()
+        spawn.with_line_callback({ lua_executable, "-e", check_large_file },
+            { stdout = function(line)
+                assert(line == "done", "Unexpected line: " .. line)
+                continue = true
+            end })
+        return true
+    end,
+
+    function()
+        -- Wait for the previous test to succeed
+        if not continue then return end
+        continue = false
+
+        -- Now test a pipe, whose data arrives while the main loop runs
+        local ticks = 0
+        local ticker = gtimer {
+            timeout   = 0.02,
+            autostart = true,
+            callback  = function() ticks = ticks + 1 end,
+        }
+
+        selection_object = assert(selection.acquire{ selection = "CLIPBOARD" },
+            "Failed to acquire the clipboard selection")
+        selection_object:connect_signal("request", function(_, target, transfer)
+            if target == "TARGETS" then
+                transfer:send{
+                    format = "atom",
+                    data = { "TARGETS", "UTF8_STRING" },
+                }
+            elseif target == "UTF8_STRING" then
+                local pid, _, _, stdout = awesome.spawn(
+                    { "sh", "-c", "printf Hello; sleep 1; printf ' World!'" },
+                    false, false, true, false)
+                assert(type(pid) == "number", pid)
+
+                ticks = 0
+                transfer:send{ fd = stdout }
+
+                -- The transfer has its own copy of the descriptor
+                Gio.UnixInputStream.new(stdout, true):close()
+            end
+        end)
+        awesome.sync()
+        spawn.with_line_callback({ lua_executable, "-e", check_targets_and_text },
+            { stdout = function(line)
+                assert(line == "done", "Unexpected line: " .. line)
+                assert(ticks > 10, "The main loop was blocked: " .. ticks)
+                ticker:stop()
+                continue = true
+            end })
+        return true
+    end,
+
+    function()
+        -- Wait for the previous test to succeed
+        if not continue then return end
+        continue = false
+
+        os.remove(small_file)
+        os.remove(large_file)
+
         -- Now test that :release() works
         selection_object:release()
         awesome.sync()
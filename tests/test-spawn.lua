@@ -10,6 +10,8 @@ end
 
 local spawns_done = 0
 local async_spawns_done = 0
+local backends_done = 0
+local large_done = 0
 local exit_yay, exit_snd = nil, nil
 
 -- * Using spawn with array is already covered by the test client.
@@ -71,6 +73,67 @@ local steps = {
         return true
     end,
 
+    -- Both spawn backends give the child /dev/null as stdin and no startup id.
+    function(count)
+        if count == 1 then
+            for _, backend in ipairs { "vfork", "glib" } do
+                local previous = awesome._spawn_backend(backend)
+                spawn.easy_async({ "sh", "-c", "cat; echo \"done:$DESKTOP_STARTUP_ID\"" },
+                    function(stdout, _, _, code)
+                        assert(stdout == "done:\n", backend .. ": " .. stdout)
+                        assert(code == 0, backend .. ": " .. code)
+                        backends_done = backends_done + 1
+                    end)
+                awesome._spawn_backend(previous)
+            end
+        end
+
+        return backends_done == 2
+    end,
+
+    -- Large outputs are read in big chunks, and can be limited.
+    function(count)
+        if count == 1 then
+            local lines = 0
+            spawn.with_line_callback({ "seq", "100000" }, {
+                stdout = function(line)
+                    lines = lines + 1
+                    assert(line == tostring(lines), line)
+                end,
+                output_done = function()
+                    assert(lines == 100000, lines)
+                    large_done = large_done + 1
+                end,
+            })
+            spawn.easy_async({ "seq", "100000" }, function(stdout)
+                assert(#stdout == 588895, #stdout)
+                assert(stdout:sub(-14) == "99999\n100000\n", stdout:sub(-14))
+                large_done = large_done + 1
+            end)
+
+            spawn.max_output_size = 10
+            spawn.easy_async({ "seq", "100000" }, function(stdout, _, _, code)
+                assert(stdout == "1\n2\n3\n4\n5\n", stdout)
+                assert(code == 0, code)
+                large_done = large_done + 1
+            end)
+            spawn.max_output_size = 3
+            local cut = {}
+            spawn.with_line_callback({ "printf", "12345\\n6\\n" }, {
+                stdout = function(line)
+                    table.insert(cut, line)
+                end,
+                output_done = function()
+                    assert(table.concat(cut, ",") == "123,6", table.concat(cut, ","))
+                    large_done = large_done + 1
+                end,
+            })
+            spawn.max_output_size = nil
+        end
+
+        return large_done == 4
+    end,
+
     function(count)
         if count == 1 then
             spawn.easy_async("echo yay", function(stdout)
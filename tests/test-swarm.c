@@ -0,0 +1,539 @@
+/*
+ * A synthetic client swarm for load and integration tests.
+ *
+ * Copyright © 2026 Abigail Teague <ateague063@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <getopt.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <xcb/xcb.h>
+#include <xcb/xcb_aux.h>
+#include <xcb/xcb_icccm.h>
+
+#include "common/util.h"
+
+// Include all the C code we might need directly into this file - I am lazy
+#include "common/util.c"
+
+/*
+ * This program creates many windows with the kind of properties real
+ * applications set and then generates churn on them, so that the window
+ * manager can be put under a reproducible load:
+ * - Create N windows with WM_CLASS, WM_NAME/_NET_WM_NAME, WM_NORMAL_HINTS,
+ *   WM_HINTS and a _NET_WM_ICON containing several sizes. Every few windows
+ *   are dialogs transient for their predecessor and the first few are docks
+ *   with struts.
+ * [Wait until the WM mapped every window]
+ * - Change the title of every window a number of times.
+ * - Send a number of ConfigureRequests for every window.
+ * - Flip the urgency hint of every window a number of times.
+ * - Unmap and map every window a number of times.
+ * [Wait until the WM mapped every window again after each cycle]
+ *
+ * Each phase ends with a round trip and logs how long it took. The output
+ * follows the protocol of test-gravity: "LOG: " lines are informational and
+ * "SUCCESS" is printed once everything is done. With -k the windows are kept
+ * alive afterwards until the process is killed.
+ */
+
+#define SWARM_TRANSIENT_FOR_NONE 0
+#define SWARM_STRUT_SIZE 16
+
+static const uint32_t icon_sizes[] = { 16, 24, 32, 48, 64 };
+
+struct swarm_options {
+    uint32_t count;
+    uint32_t docks;
+    uint32_t transient_every;
+    uint32_t title_rounds;
+    uint32_t configure_rounds;
+    uint32_t urgent_flips;
+    uint32_t map_cycles;
+    uint32_t seed;
+    uint32_t timeout;
+    bool     keep;
+};
+
+struct swarm_window {
+    xcb_window_t window;
+    xcb_window_t transient_for;
+    bool         dock;
+    bool         mapped;
+    bool         urgent;
+};
+
+enum {
+    ATOM_NET_WM_NAME,
+    ATOM_NET_WM_ICON,
+    ATOM_NET_WM_STRUT,
+    ATOM_NET_WM_STRUT_PARTIAL,
+    ATOM_NET_WM_WINDOW_TYPE,
+    ATOM_NET_WM_WINDOW_TYPE_DOCK,
+    ATOM_NET_WM_WINDOW_TYPE_DIALOG,
+    ATOM_UTF8_STRING,
+    ATOM_COUNT
+};
+
+static const char *const atom_names[ATOM_COUNT] = {
+    [ATOM_NET_WM_NAME]               = "_NET_WM_NAME",
+    [ATOM_NET_WM_ICON]               = "_NET_WM_ICON",
+    [ATOM_NET_WM_STRUT]              = "_NET_WM_STRUT",
+    [ATOM_NET_WM_STRUT_PARTIAL]      = "_NET_WM_STRUT_PARTIAL",
+    [ATOM_NET_WM_WINDOW_TYPE]        = "_NET_WM_WINDOW_TYPE",
+    [ATOM_NET_WM_WINDOW_TYPE_DOCK]   = "_NET_WM_WINDOW_TYPE_DOCK",
+    [ATOM_NET_WM_WINDOW_TYPE_DIALOG] = "_NET_WM_WINDOW_TYPE_DIALOG",
+    [ATOM_UTF8_STRING]               = "UTF8_STRING",
+};
+
+static xcb_connection_t    *c;
+static xcb_screen_t        *screen;
+static xcb_atom_t           atoms[ATOM_COUNT];
+static struct swarm_options opts;
+static struct swarm_window *windows;
+static uint32_t             rng_state;
+static uint32_t            *icon_data;
+static uint32_t             icon_data_len;
+static uint32_t             mapped_count;
+
+static void do_log(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
+static void do_log(const char *format, ...) {
+    va_list ap;
+
+    va_start(ap, format);
+    fprintf(stdout, "LOG: ");
+    vfprintf(stdout, format, ap);
+    fprintf(stdout, "\n");
+    va_end(ap);
+    fflush(stdout);
+}
+
+/* xorshift32, so that runs with the same seed generate the same requests */
+static uint32_t swarm_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static uint32_t swarm_random_range(uint32_t min, uint32_t max) {
+    return min + swarm_random() % (max - min + 1);
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/* Make sure the server processed everything we sent so far */
+static void sync_with_server(void) {
+    free(xcb_get_input_focus_reply(c, xcb_get_input_focus(c), NULL));
+}
+
+static void intern_atoms(void) {
+    xcb_intern_atom_cookie_t cookies[ATOM_COUNT];
+
+    /* Send all requests first so that this is only one round trip */
+    for (int i = 0; i < ATOM_COUNT; i++)
+        cookies[i] = xcb_intern_atom(c, false, strlen(atom_names[i]), atom_names[i]);
+
+    for (int i = 0; i < ATOM_COUNT; i++) {
+        xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(c, cookies[i], NULL);
+        if (!reply) fatal("Failed to intern atom %s\n", atom_names[i]);
+        atoms[i] = reply->atom;
+        free(reply);
+    }
+}
+
+/* Build a _NET_WM_ICON value with all sizes from icon_sizes. Every window
+ * gets the same layout, only the colour is patched in before uploading. */
+static void build_icon_data(void) {
+    icon_data_len = 0;
+    for (size_t i = 0; i < countof(icon_sizes); i++)
+        icon_data_len += 2 + icon_sizes[i] * icon_sizes[i];
+
+    icon_data = p_new(uint32_t, icon_data_len);
+}
+
+static void fill_icon_data(uint32_t argb) {
+    uint32_t *p = icon_data;
+
+    for (size_t i = 0; i < countof(icon_sizes); i++) {
+        uint32_t size = icon_sizes[i];
+        *p++          = size;
+        *p++          = size;
+        for (uint32_t y = 0; y < size; y++)
+            for (uint32_t x = 0; x < size; x++)
+                /* A frame around a solid square so that scaling is visible */
+                *p++ = (x == 0 || y == 0 || x == size - 1 || y == size - 1) ? 0xff000000 : argb;
+    }
+}
+
+static void set_title(struct swarm_window *w, uint32_t index, uint32_t round) {
+    char    title[64];
+    ssize_t len = snprintf(title, sizeof(title), "swarm %u: title %u", index, round);
+
+    xcb_change_property(
+        c, XCB_PROP_MODE_REPLACE, w->window, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8, len, title);
+    xcb_change_property(
+        c, XCB_PROP_MODE_REPLACE, w->window, atoms[ATOM_NET_WM_NAME], atoms[ATOM_UTF8_STRING], 8,
+        len, title);
+}
+
+static void set_wm_hints(struct swarm_window *w) {
+    xcb_icccm_wm_hints_t hints;
+
+    p_clear(&hints, 1);
+    xcb_icccm_wm_hints_set_input(&hints, true);
+    xcb_icccm_wm_hints_set_normal(&hints);
+    xcb_icccm_wm_hints_set_urgency(&hints);
+    if (!w->urgent) hints.flags &= ~XCB_ICCCM_WM_HINT_X_URGENCY;
+    xcb_icccm_set_wm_hints(c, w->window, &hints);
+}
+
+static void set_struts(struct swarm_window *w, uint32_t index) {
+    uint32_t top = SWARM_STRUT_SIZE * (index + 1);
+    /* left, right, top, bottom, then start/end pairs for each side */
+    uint32_t strut[12] = { 0, 0, top, 0, 0, 0, 0, 0, 0, screen->width_in_pixels - 1, 0, 0 };
+
+    xcb_change_property(
+        c, XCB_PROP_MODE_REPLACE, w->window, atoms[ATOM_NET_WM_STRUT_PARTIAL], XCB_ATOM_CARDINAL,
+        32, 12, strut);
+    xcb_change_property(
+        c, XCB_PROP_MODE_REPLACE, w->window, atoms[ATOM_NET_WM_STRUT], XCB_ATOM_CARDINAL, 32, 4,
+        strut);
+}
+
+static void create_window(uint32_t index) {
+    struct swarm_window *w = &windows[index];
+    xcb_size_hints_t     size_hints;
+    xcb_atom_t           type;
+    char                 wm_class[64];
+    int                  class_len;
+    uint32_t             width  = swarm_random_range(100, 400);
+    uint32_t             height = swarm_random_range(80, 300);
+
+    w->window                   = xcb_generate_id(c);
+    w->dock                     = index < opts.docks;
+    w->transient_for            = SWARM_TRANSIENT_FOR_NONE;
+    if (!w->dock && opts.transient_every && index > opts.docks &&
+        (index - opts.docks) % opts.transient_every == 0)
+        w->transient_for = windows[index - 1].window;
+
+    xcb_create_window(
+        c, screen->root_depth, w->window, screen->root,
+        w->dock ? 0 : swarm_random_range(0, screen->width_in_pixels / 2),
+        w->dock ? SWARM_STRUT_SIZE * index : swarm_random_range(0, screen->height_in_pixels / 2),
+        w->dock ? screen->width_in_pixels : width, w->dock ? SWARM_STRUT_SIZE : height, 0,
+        XCB_WINDOW_CLASS_INPUT_OUTPUT, screen->root_visual, XCB_CW_BACK_PIXEL | XCB_CW_EVENT_MASK,
+        (uint32_t[]) {
+            swarm_random() & 0xffffff,
+            XCB_EVENT_MASK_STRUCTURE_NOTIFY,
+        });
+
+    /* "instance\0class\0", a handful of classes so that rules have something
+     * to match against */
+    class_len = snprintf(
+        wm_class, sizeof(wm_class), "swarm%u%cSwarm%u%c", index, '\0', index % 8, '\0');
+    xcb_icccm_set_wm_class(c, w->window, class_len, wm_class);
+
+    set_title(w, index, 0);
+    set_wm_hints(w);
+
+    p_clear(&size_hints, 1);
+    xcb_icccm_size_hints_set_min_size(&size_hints, 50, 40);
+    xcb_icccm_size_hints_set_base_size(&size_hints, 10, 10);
+    if (index % 3 == 0) xcb_icccm_size_hints_set_resize_inc(&size_hints, 7, 13);
+    if (index % 5 == 0) xcb_icccm_size_hints_set_max_size(&size_hints, 800, 600);
+    xcb_icccm_set_wm_normal_hints(c, w->window, &size_hints);
+
+    fill_icon_data(0xff000000 | (swarm_random() & 0xffffff));
+    xcb_change_property(
+        c, XCB_PROP_MODE_REPLACE, w->window, atoms[ATOM_NET_WM_ICON], XCB_ATOM_CARDINAL, 32,
+        icon_data_len, icon_data);
+
+    if (w->dock) {
+        type = atoms[ATOM_NET_WM_WINDOW_TYPE_DOCK];
+        set_struts(w, index);
+    } else if (w->transient_for != SWARM_TRANSIENT_FOR_NONE) {
+        type = atoms[ATOM_NET_WM_WINDOW_TYPE_DIALOG];
+        xcb_icccm_set_wm_transient_for(c, w->window, w->transient_for);
+    } else {
+        type = XCB_NONE;
+    }
+    if (type != XCB_NONE)
+        xcb_change_property(
+            c, XCB_PROP_MODE_REPLACE, w->window, atoms[ATOM_NET_WM_WINDOW_TYPE], XCB_ATOM_ATOM, 32,
+            1, &type);
+
+    xcb_map_window(c, w->window);
+}
+
+static struct swarm_window *find_window(xcb_window_t window) {
+    for (uint32_t i = 0; i < opts.count; i++)
+        if (windows[i].window == window) return &windows[i];
+    return NULL;
+}
+
+static void handle_event(xcb_generic_event_t *ev) {
+    struct swarm_window *w;
+
+    switch (ev->response_type & 0x7f) {
+        case XCB_MAP_NOTIFY:
+            w = find_window(((xcb_map_notify_event_t *)ev)->window);
+            if (w && !w->mapped) {
+                w->mapped = true;
+                mapped_count++;
+            }
+            break;
+        case XCB_UNMAP_NOTIFY:
+            w = find_window(((xcb_unmap_notify_event_t *)ev)->window);
+            if (w && w->mapped) {
+                w->mapped = false;
+                mapped_count--;
+            }
+            break;
+        case 0:
+            fatal("X11 error %d\n", ((xcb_generic_error_t *)ev)->error_code);
+    }
+}
+
+/* Process events until all windows are mapped or the timeout expired */
+static uint32_t wait_for_mapped(void) {
+    struct pollfd        pfd = { .fd = xcb_get_file_descriptor(c), .events = POLLIN };
+    double               end = now_ms() + opts.timeout * 1000.0;
+    xcb_generic_event_t *ev;
+
+    xcb_flush(c);
+    for (;;) {
+        /* Always drain the queue first, it may contain stale UnmapNotifys */
+        while ((ev = xcb_poll_for_event(c)) != NULL) {
+            handle_event(ev);
+            free(ev);
+        }
+        if (xcb_connection_has_error(c)) fatal("X11 connection broke\n");
+        if (mapped_count >= opts.count) break;
+
+        double left = end - now_ms();
+        if (left <= 0) break;
+        poll(&pfd, 1, (int)left + 1);
+    }
+
+    return mapped_count;
+}
+
+static void phase_done(const char *name, double start, uint32_t requests) {
+    sync_with_server();
+    do_log("%s: %u requests in %.3f ms", name, requests, now_ms() - start);
+}
+
+static void phase_create(void) {
+    double   start = now_ms();
+    uint32_t mapped;
+
+    for (uint32_t i = 0; i < opts.count; i++)
+        create_window(i);
+    phase_done("create", start, opts.count);
+
+    mapped = wait_for_mapped();
+    if (mapped < opts.count)
+        fatal("Only %u of %u windows got mapped within %us\n", mapped, opts.count, opts.timeout);
+    do_log("managed: %u windows in %.3f ms", opts.count, now_ms() - start);
+}
+
+static void phase_titles(void) {
+    double start = now_ms();
+
+    for (uint32_t round = 1; round <= opts.title_rounds; round++)
+        for (uint32_t i = 0; i < opts.count; i++)
+            set_title(&windows[i], i, round);
+    phase_done("title storm", start, opts.title_rounds * opts.count * 2);
+}
+
+static void phase_configure(void) {
+    double start = now_ms();
+
+    for (uint32_t round = 0; round < opts.configure_rounds; round++)
+        for (uint32_t i = 0; i < opts.count; i++) {
+            if (windows[i].dock) continue;
+            xcb_configure_window(
+                c, windows[i].window,
+                XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH |
+                    XCB_CONFIG_WINDOW_HEIGHT,
+                (uint32_t[]) {
+                    swarm_random_range(0, screen->width_in_pixels / 2),
+                    swarm_random_range(0, screen->height_in_pixels / 2),
+                    swarm_random_range(100, 400),
+                    swarm_random_range(80, 300),
+                });
+        }
+    phase_done("configure", start, opts.configure_rounds * (opts.count - opts.docks));
+}
+
+static void phase_urgent(void) {
+    double start = now_ms();
+
+    for (uint32_t flip = 0; flip < opts.urgent_flips; flip++)
+        for (uint32_t i = 0; i < opts.count; i++) {
+            windows[i].urgent = !windows[i].urgent;
+            set_wm_hints(&windows[i]);
+        }
+    phase_done("urgent flips", start, opts.urgent_flips * opts.count);
+}
+
+static void phase_map_cycles(void) {
+    double   start = now_ms();
+    uint32_t mapped;
+
+    for (uint32_t cycle = 0; cycle < opts.map_cycles; cycle++) {
+        for (uint32_t i = 0; i < opts.count; i++)
+            xcb_unmap_window(c, windows[i].window);
+        for (uint32_t i = 0; i < opts.count; i++)
+            xcb_map_window(c, windows[i].window);
+
+        /* Wait for the UnmapNotify of each window before waiting for the
+         * WM to map them again */
+        sync_with_server();
+        mapped = wait_for_mapped();
+        if (mapped < opts.count)
+            fatal(
+                "Only %u of %u windows got mapped again in cycle %u\n", mapped, opts.count, cycle);
+    }
+    do_log(
+        "map cycles: %u requests in %.3f ms", opts.map_cycles * opts.count * 2, now_ms() - start);
+}
+
+static void usage(const char *name) {
+    fprintf(
+        stderr,
+        "Usage: %s [OPTION]...\n"
+        "  -n COUNT  number of windows (default: 100)\n"
+        "  -d COUNT  number of dock windows with struts (default: 1)\n"
+        "  -r EVERY  make every EVERY-th window a transient dialog, 0 for none (default: 5)\n"
+        "  -t ROUNDS title-change storm rounds (default: 0)\n"
+        "  -c ROUNDS ConfigureRequest rounds (default: 0)\n"
+        "  -u FLIPS  urgency hint flips (default: 0)\n"
+        "  -m CYCLES map/unmap cycles (default: 0)\n"
+        "  -s SEED   seed for positions, sizes and colours (default: 1)\n"
+        "  -w SECS   how long to wait for the WM to map windows (default: 10)\n"
+        "  -k        keep the windows alive until killed\n",
+        name);
+    exit(64);
+}
+
+static uint32_t parse_number(const char *name, const char *arg) {
+    char         *end;
+    unsigned long value = strtoul(arg, &end, 10);
+    if (*arg == '\0' || *end != '\0' || value > UINT32_MAX) usage(name);
+    return value;
+}
+
+int main(int argc, char **argv) {
+    int default_screen, opt;
+
+    opts = (struct swarm_options) {
+        .count           = 100,
+        .docks           = 1,
+        .transient_every = 5,
+        .seed            = 1,
+        .timeout         = 10,
+    };
+
+    while ((opt = getopt(argc, argv, "n:d:r:t:c:u:m:s:w:kh")) != -1) {
+        switch (opt) {
+            case 'n':
+                opts.count = parse_number(argv[0], optarg);
+                break;
+            case 'd':
+                opts.docks = parse_number(argv[0], optarg);
+                break;
+            case 'r':
+                opts.transient_every = parse_number(argv[0], optarg);
+                break;
+            case 't':
+                opts.title_rounds = parse_number(argv[0], optarg);
+                break;
+            case 'c':
+                opts.configure_rounds = parse_number(argv[0], optarg);
+                break;
+            case 'u':
+                opts.urgent_flips = parse_number(argv[0], optarg);
+                break;
+            case 'm':
+                opts.map_cycles = parse_number(argv[0], optarg);
+                break;
+            case 's':
+                opts.seed = parse_number(argv[0], optarg);
+                break;
+            case 'w':
+                opts.timeout = parse_number(argv[0], optarg);
+                break;
+            case 'k':
+                opts.keep = true;
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (opts.count == 0 || opts.docks > opts.count) usage(argv[0]);
+
+    /* xorshift must not start at zero */
+    rng_state = opts.seed ? opts.seed : 1;
+
+    c         = xcb_connect(NULL, &default_screen);
+    if (xcb_connection_has_error(c))
+        fatal("Could not connect to X11 server: %d\n", xcb_connection_has_error(c));
+    screen  = xcb_aux_get_screen(c, default_screen);
+    windows = p_new(struct swarm_window, opts.count);
+
+    intern_atoms();
+    build_icon_data();
+
+    do_log(
+        "swarm of %u windows (%u docks, transient every %u), seed %u", opts.count, opts.docks,
+        opts.transient_every, opts.seed);
+
+    phase_create();
+    phase_titles();
+    phase_configure();
+    phase_urgent();
+    phase_map_cycles();
+
+    if (xcb_connection_has_error(c))
+        fatal("X11 connection has error: %d\n", xcb_connection_has_error(c));
+    puts("SUCCESS");
+    fflush(stdout);
+
+    if (opts.keep) {
+        xcb_generic_event_t *event;
+        while ((event = xcb_wait_for_event(c)) != NULL)
+            free(event);
+    }
+
+    xcb_disconnect(c);
+    p_delete(&icon_data);
+    p_delete(&windows);
+    return 0;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
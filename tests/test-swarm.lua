@@ -0,0 +1,57 @@
+-- Run the synthetic client swarm with a bit of every kind of churn and check
+-- that awesome manages all windows and survives.
+
+local runner = require("_runner")
+local spawn = require("awful.spawn")
+
+local count = 40
+local had_exit, had_success
+local had_error = false
+local max_clients = 0
+
+client.connect_signal("request::manage", function()
+    max_clients = math.max(max_clients, #client.get())
+end)
+
+local function check_done()
+    if had_exit and had_success then
+        if had_error then
+            runner.done("Some error occurred, see above")
+        elseif max_clients < count then
+            runner.done("Only " .. max_clients .. " of " .. count .. " clients were managed")
+        else
+            runner.done()
+        end
+    end
+end
+
+local err = spawn.with_line_callback(
+    { "./test-swarm", "-n", tostring(count), "-d", "2", "-t", "5", "-c", "2", "-u", "2", "-m", "1" },
+    {
+        exit = function(what, code)
+            assert(what == "exit", what)
+            assert(code == 0, "Exit code was " .. code)
+            had_exit = true
+            check_done()
+        end,
+        stderr = function(line)
+            had_error = true
+            print("Read on stderr: " .. line)
+        end,
+        stdout = function(line)
+            if line == "SUCCESS" then
+                had_success = true
+                check_done()
+            elseif line:sub(1, 5) ~= "LOG: " then
+                had_error = true
+                print("Read on stdout: " .. line)
+            else
+                runner.verbose(line)
+            end
+        end
+    })
+
+assert(type(err) ~= "string", err)
+runner.run_direct()
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
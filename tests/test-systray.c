@@ -1,5 +1,6 @@
 /*
- * A simple client icon that "does nothing".
+ * A simple client icon that "does nothing", except printing "mapped" when the
+ * systray maps it. With the "noinfo" argument, it has no _XEMBED_INFO.
  *
  * Copyright © 2021 Uli Schlachter <psychon@znc.in>
  *
@@ -74,7 +75,8 @@ static uint32_t get_color(xcb_connection_t *conn, xcb_screen_t *screen, uint16_t
     return pixel;
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+    bool noinfo = argc > 1 && strcmp(argv[1], "noinfo") == 0;
     int default_screen;
     xcb_connection_t* conn = xcb_connect(NULL, &default_screen);
     if (xcb_connection_has_error(conn)) {
@@ -83,11 +85,13 @@ int main() {
     atoms_init(conn);
     xcb_screen_t* screen = xcb_aux_get_screen(conn, default_screen);
 
-    // Create a window for the systray icon
+    // Create an unmapped window for the systray icon, asking to be mapped
     xcb_window_t window = xcb_generate_id(conn);
     xcb_create_window(conn, screen->root_depth, window, screen->root, 0, 0, 10, 10, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT,
-            screen->root_visual, XCB_CW_BACK_PIXEL, (uint32_t[]) { get_color(conn, screen, 0xffff, 0x9999, 0x0000) });
-    xcb_change_property(conn, XCB_PROP_MODE_REPLACE, window, _XEMBED_INFO, _XEMBED_INFO, 32, 2, (uint32_t[]) { 0, 1 });
+            screen->root_visual, XCB_CW_BACK_PIXEL | XCB_CW_EVENT_MASK,
+            (uint32_t[]) { get_color(conn, screen, 0xffff, 0x9999, 0x0000), XCB_EVENT_MASK_STRUCTURE_NOTIFY });
+    if (!noinfo)
+        xcb_change_property(conn, XCB_PROP_MODE_REPLACE, window, _XEMBED_INFO, _XEMBED_INFO, 32, 2, (uint32_t[]) { 0, 1 });
 
     // Make our window a systray icon
     xcb_window_t systray_owner = find_systray(conn, systray_atom(conn, default_screen));
@@ -108,6 +112,10 @@ int main() {
     xcb_flush(conn);
     xcb_generic_event_t *event;
     while ((event = xcb_wait_for_event(conn)) != NULL) {
+        if ((event->response_type & ~0x80) == XCB_MAP_NOTIFY) {
+            printf("mapped\n");
+            fflush(stdout);
+        }
         free(event);
     }
 
@@ -4,6 +4,18 @@ local beautiful = require("beautiful")
 
 local steps, pid1, pid2, draw_w, st = {}
 
+-- Whether the icons got mapped. They dock unmapped, asking to be mapped with
+-- XEMBED_MAPPED or with the default used when _XEMBED_INFO is missing.
+local mapped = {}
+
+local function spawn_icon(name, cmd)
+    return spawn.with_line_callback(cmd, {
+        stdout = function(line)
+            if line == "mapped" then mapped[name] = true end
+        end
+    })
+end
+
 table.insert(steps, function()
     screen[1].mywibox:remove()
 
@@ -33,21 +45,21 @@ table.insert(steps, function()
         layout = wibox.layout.fixed.horizontal
     }
 
-    pid1 = spawn("./test-systray")
+    pid1 = spawn_icon("info", "./test-systray")
 
     return true
 end)
 
 table.insert(steps, function()
-    if draw_w ~= 80 then return end
+    if draw_w ~= 80 or not mapped.info then return end
 
-    pid2 = spawn("./test-systray")
+    pid2 = spawn_icon("noinfo", "./test-systray noinfo")
 
     return true
 end)
 
 table.insert(steps, function()
-    if draw_w ~= 60 then return end
+    if draw_w ~= 60 or not mapped.noinfo then return end
 
     st.reverse = true
     st.horizontal = false
@@ -0,0 +1,59 @@
+-- Test the X resources lookups and their update when RESOURCE_MANAGER changes.
+
+local runner = require("_runner")
+local spawn = require("awful.spawn")
+
+local changes = 0
+awesome.connect_signal("xrdb::changed", function() changes = changes + 1 end)
+
+local function xrdb(command)
+    spawn.easy_async({ "sh", "-c", command }, function(_, stderr, _, code)
+        assert(code == 0, stderr)
+    end)
+end
+
+local steps = {
+    function()
+        -- Looked up before it exists, the miss must not stick.
+        assert(awesome.xrdb_get_value("", "awesomeTest.color") == nil)
+
+        xrdb("echo 'awesomeTest.color: #123456' | xrdb -nocpp -merge")
+        return true
+    end,
+
+    -- A new resource is added.
+    function()
+        if changes ~= 1 then return end
+
+        assert(awesome.xrdb_get_value("", "awesomeTest.color") == "#123456")
+
+        local values = awesome.xrdb_get_values("", { "awesomeTest.color", "awesomeTest.missing" })
+        assert(values["awesomeTest.color"] == "#123456")
+        assert(values["awesomeTest.missing"] == nil)
+
+        xrdb("echo 'awesomeTest.color: #654321' | xrdb -nocpp -merge")
+        return true
+    end,
+
+    -- The value of a resource changes.
+    function()
+        if changes ~= 2 then return end
+
+        assert(awesome.xrdb_get_value("", "awesomeTest.color") == "#654321")
+
+        xrdb("xrdb -query | grep -v '^awesomeTest' | xrdb -nocpp -load")
+        return true
+    end,
+
+    -- The resource is removed.
+    function()
+        if changes ~= 3 then return end
+
+        assert(awesome.xrdb_get_value("", "awesomeTest.color") == nil)
+        return true
+    end,
+}
+
+runner.run_steps(steps)
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80